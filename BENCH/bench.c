@@ -0,0 +1,373 @@
+#include "../train.h"
+#include "../esn.h"
+#include "../included_datasets.h"
+#include "../linear_solve.h"
+#include "../moore_penrose.h"
+#include <string.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+/** BENCH_REPS, BENCH_SEED
+  * Every case is run BENCH_REPS times and the fastest run is reported. Resevoirs and inputs are drawn from streams seeded with BENCH_SEED, so every run of
+  * the suite times the same work.
+*/
+static const int BENCH_REPS = 3;
+static const uint64_t BENCH_SEED = 20240601;
+
+/** BENCH_PINV_LIMIT
+  * moore_penrose_pinv is only timed when the harvested matrix has at most this many entries; it is far slower than every other case.
+*/
+static const double BENCH_PINV_LIMIT = 2.5e6;
+
+/**STRUCT bench_grid - BENCH GRID
+ * The sizes the suite runs over. The components are:
+  * nodes, node_count - The resevoir sizes.
+  * densities, density_count - The resevoir densities passed to randomize_esn_rng.
+  * lengths, length_count - The sequence lengths (table entries).
+*/
+typedef struct bench_grid{
+  const int* nodes;
+  int node_count;
+  const double* densities;
+  int density_count;
+  const int* lengths;
+  int length_count;
+} bench_grid;
+
+/**bench_now - BENCH NOW
+  * The monotonic clock in seconds.
+*/
+static double bench_now(){
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + (1e-9 * t.tv_nsec);
+}
+
+/**bench_emit - BENCH EMIT
+  * Prints one result object. The first result of the suite must pass first = true so the separating commas are right.
+    * first. Whether this is the first result.
+    * name. The case's name.
+    * nodes, density, length. The case's sizes; a negative density or length is omitted.
+    * seconds. The fastest run's time.
+    * rate, unit. The throughput derived from seconds, or a rate of 0 to omit it.
+*/
+static void bench_emit(bool* first, const char* name, int nodes, double density, int length, double seconds, double rate, const char* unit){
+  printf("%s\n    {\"bench\": \"%s\", \"nodes\": %d", *first ? "" : ",", name, nodes);
+  if(density >= 0){
+    printf(", \"density\": %g", density);
+  }
+  if(length >= 0){
+    printf(", \"length\": %d", length);
+  }
+  printf(", \"seconds\": %.9f", seconds);
+  if(rate > 0){
+    printf(", \"rate\": %.6g, \"unit\": \"%s\"", rate, unit);
+  }
+  printf("}");
+  fflush(stdout);
+  *first = false;
+}
+
+/**bench_cpu - BENCH CPU
+  * Copies the CPU model name from /proc/cpuinfo into name, or "unknown".
+    * name. Where to write the name.
+    * size. The size of name.
+*/
+static void bench_cpu(char* name, size_t size){
+  snprintf(name, size, "unknown");
+  FILE* cpuinfo = fopen("/proc/cpuinfo", "r");
+  if(cpuinfo == NULL){
+    return;
+  }
+  char line[512];
+  while(fgets(line, sizeof(line), cpuinfo) != NULL){
+    char* colon = strchr(line, ':');
+    if(strncmp(line, "model name", 10) == 0 && colon != NULL){
+      colon += 2;
+      colon[strcspn(colon, "\n")] = '\0';
+      for(char* c = colon; *c != '\0'; c++){
+        if(*c == '"' || *c == '\\'){
+          *c = ' ';
+        }
+      }
+      snprintf(name, size, "%s", colon);
+      break;
+    }
+  }
+  fclose(cpuinfo);
+}
+
+/**bench_esn - BENCH ESN
+  * Builds the suite's resevoir for a size and density.
+    * nodes. The resevoir size.
+    * density. The resevoir density.
+*/
+static ESN* bench_esn(int nodes, double density){
+  rand_stream rng;
+  rand_stream_init(&rng, BENCH_SEED, nodes);
+  ESN* esn = empty_esn(1, 1, nodes, 0.3, 1.0, 0.9);
+  randomize_esn_rng(esn, density, &rng);
+  return esn;
+}
+
+/**bench_stepping - BENCH STEPPING
+  * Times randomize_esn and update_esn (with both tanh modes) for every size and density.
+    * grid. The sizes.
+    * first. As bench_emit.
+*/
+static void bench_stepping(const bench_grid* grid, bool* first){
+  int steps = 20000;
+  gsl_matrix* uN = gsl_matrix_alloc(2, 1);
+  gsl_matrix_set(uN, 0, 0, 1.0);
+  gsl_matrix_set(uN, 1, 0, 0.25);
+  for(int n = 0; n < grid->node_count; n++){
+    for(int d = 0; d < grid->density_count; d++){
+      int nodes = grid->nodes[n];
+      double density = grid->densities[d];
+
+      double best = 1e300;
+      for(int r = 0; r < BENCH_REPS; r++){
+        double start = bench_now();
+        ESN* esn = bench_esn(nodes, density);
+        best = fmin(best, bench_now() - start);
+        free_esn(esn);
+      }
+      bench_emit(first, "randomize_esn", nodes, density, -1, best, 0, NULL);
+
+      ESN* esn = bench_esn(nodes, density);
+      for(int mode = 0; mode < 2; mode++){
+        esn_set_tanh(esn, mode == 0 ? ESN_TANH_EXACT : ESN_TANH_FAST);
+        best = 1e300;
+        for(int r = 0; r < BENCH_REPS; r++){
+          double start = bench_now();
+          for(int t = 0; t < steps; t++){
+            update_esn(esn, uN);
+          }
+          best = fmin(best, bench_now() - start);
+        }
+        bench_emit(first, mode == 0 ? "update_esn" : "update_esn_fast_tanh", nodes, density, steps, best, steps / best, "steps/s");
+      }
+      free_esn(esn);
+    }
+  }
+  gsl_matrix_free(uN);
+}
+
+/** BENCH_TOPOLOGY_NODES
+  * The size of the largest structured resevoir the bench_topologies cases step, beyond what a dense or sparse w would fit in memory.
+*/
+static const int BENCH_TOPOLOGY_NODES = 100000;
+
+/**bench_topologies - BENCH TOPOLOGIES
+  * Times update_esn (with the fast tanh) on every structured resevoir (see topology.h), at every size and at BENCH_TOPOLOGY_NODES.
+    * grid. The sizes.
+    * first. As bench_emit.
+*/
+static void bench_topologies(const bench_grid* grid, bool* first){
+  static const int kinds[3] = {TOPOLOGY_CYCLE, TOPOLOGY_DELAY, TOPOLOGY_JUMPS};
+  static const char* names[3] = {"update_esn_cycle", "update_esn_delay", "update_esn_jumps"};
+  gsl_matrix* uN = gsl_matrix_alloc(2, 1);
+  gsl_matrix_set(uN, 0, 0, 1.0);
+  gsl_matrix_set(uN, 1, 0, 0.25);
+  for(int n = 0; n <= grid->node_count; n++){
+    int nodes = n < grid->node_count ? grid->nodes[n] : BENCH_TOPOLOGY_NODES;
+    int steps = nodes < 1000 ? 20000 : 2000;
+    for(int k = 0; k < 3; k++){
+      rand_stream rng;
+      rand_stream_init(&rng, BENCH_SEED, nodes);
+      ESN* esn = empty_structured_esn(1, 1, nodes, 0.3, 1.0, 0.9, kinds[k], nodes / 10 > 2 ? nodes / 10 : 2, 0.3);
+      randomize_esn_rng(esn, 0.0, &rng);
+      esn_set_tanh(esn, ESN_TANH_FAST);
+      double best = 1e300;
+      for(int r = 0; r < BENCH_REPS; r++){
+        double start = bench_now();
+        for(int t = 0; t < steps; t++){
+          update_esn(esn, uN);
+        }
+        best = fmin(best, bench_now() - start);
+      }
+      bench_emit(first, names[k], nodes, -1, steps, best, steps / best, "steps/s");
+      free_esn(esn);
+    }
+  }
+  gsl_matrix_free(uN);
+}
+
+/** BENCH_SEQUENCE
+  * The length of the sequences the train_get_gram_threads case splits each table into.
+*/
+static const int BENCH_SEQUENCE = 100;
+
+/**bench_split - BENCH SPLIT
+  * Copies a table into a table of BENCH_SEQUENCE long sequences (the last taking any remainder), each with a washout of a tenth of its length.
+    * table. The table to split.
+*/
+static train_table* bench_split(const train_table* table){
+  int sequences = table->entries / BENCH_SEQUENCE > 0 ? table->entries / BENCH_SEQUENCE : 1;
+  int* lengths = malloc(sequences * sizeof(int));
+  int* washouts = malloc(sequences * sizeof(int));
+  for(int s = 0; s < sequences; s++){
+    lengths[s] = s + 1 < sequences ? BENCH_SEQUENCE : table->entries - (s * BENCH_SEQUENCE);
+    washouts[s] = BENCH_SEQUENCE / 10;
+  }
+  train_table* split = train_table_alloc_sequences(table->uN->size2 - 1, table->y_target->size2, sequences, lengths, washouts, 0);
+  gsl_matrix_memcpy(split->uN, table->uN);
+  gsl_matrix_memcpy(split->y_target, table->y_target);
+  for(size_t i = 0; i < split->washout_uN->size1; i++){
+    gsl_vector_const_view row = gsl_matrix_const_row(table->uN, i % table->entries);
+    gsl_matrix_set_row(split->washout_uN, i, &row.vector);
+  }
+  free(lengths);
+  free(washouts);
+  return split;
+}
+
+/**bench_training - BENCH TRAINING
+  * Times the harvest (train_get_X), X.Xt formation (as a GEMM from X, streamed by train_get_gram and, over the table split into sequences, by
+  * train_get_gram_threads on every core), the ridge solve and moore_penrose_pinv for every size and sequence length, at the grid's last (sparsest) density.
+    * grid. The sizes.
+    * first. As bench_emit.
+*/
+static void bench_training(const bench_grid* grid, bool* first){
+  double density = grid->densities[grid->density_count - 1];
+  for(int l = 0; l < grid->length_count; l++){
+    int length = grid->lengths[l];
+    rand_stream rng;
+    rand_stream_init(&rng, BENCH_SEED, length);
+    train_table* table = NARMA_10_table_rng(length, 100, 0.3, 0.05, 0.1, 1.0, 0.0, 0.5, &rng);
+    train_table* split = bench_split(table);
+    for(int n = 0; n < grid->node_count; n++){
+      int nodes = grid->nodes[n];
+      int rows = 1 + 1 + nodes;
+      ESN* esn = bench_esn(nodes, density);
+
+      gsl_matrix* X = NULL;
+      double best = 1e300;
+      for(int r = 0; r < BENCH_REPS; r++){
+        gsl_matrix_set_zero(esn->state);
+        if(X != NULL){
+          gsl_matrix_free(X);
+        }
+        double start = bench_now();
+        X = train_get_X(esn, table);
+        best = fmin(best, bench_now() - start);
+      }
+      bench_emit(first, "train_get_X", nodes, density, length, best, length / best, "steps/s");
+
+      gsl_matrix* XXt = gsl_matrix_alloc(rows, rows);
+      gsl_matrix* y_Xt = gsl_matrix_alloc(1, rows);
+      best = 1e300;
+      for(int r = 0; r < BENCH_REPS; r++){
+        double start = bench_now();
+        gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, X, X, 0.0, XXt);
+        best = fmin(best, bench_now() - start);
+      }
+      bench_emit(first, "xxt_gemm", nodes, -1, length, best, 2.0 * rows * rows * (double)length / best, "flop/s");
+
+      best = 1e300;
+      for(int r = 0; r < BENCH_REPS; r++){
+        gsl_matrix_set_zero(esn->state);
+        double start = bench_now();
+        train_get_gram(esn, table, XXt, y_Xt);
+        best = fmin(best, bench_now() - start);
+      }
+      bench_emit(first, "train_get_gram", nodes, density, length, best, length / best, "steps/s");
+
+      best = 1e300;
+      for(int r = 0; r < BENCH_REPS; r++){
+        double start = bench_now();
+        train_get_gram_threads(esn, split, XXt, y_Xt, 0);
+        best = fmin(best, bench_now() - start);
+      }
+      bench_emit(first, "train_get_gram_threads", nodes, density, length, best, length / best, "steps/s");
+
+      best = 1e300;
+      for(int r = 0; r < BENCH_REPS; r++){
+        gsl_matrix* factor = gsl_matrix_alloc(rows, rows);
+        gsl_matrix* w = gsl_matrix_alloc(1, rows);
+        gsl_matrix_memcpy(factor, XXt);
+        gsl_matrix_add_diagonal(factor, 1e-6);
+        gsl_matrix_memcpy(w, y_Xt);
+        double start = bench_now();
+        linear_spd_solve_right(factor, w);
+        best = fmin(best, bench_now() - start);
+        gsl_matrix_free(factor);
+        gsl_matrix_free(w);
+      }
+      bench_emit(first, "ridge_solve", nodes, -1, -1, best, 0, NULL);
+
+      if((double)rows * length <= BENCH_PINV_LIMIT){
+        best = 1e300;
+        for(int r = 0; r < BENCH_REPS; r++){
+          gsl_matrix* Xt = gsl_matrix_alloc(length, rows);
+          gsl_matrix_transpose_memcpy(Xt, X);
+          double start = bench_now();
+          gsl_matrix* pinv = moore_penrose_pinv(Xt, 1e-7);
+          best = fmin(best, bench_now() - start);
+          gsl_matrix_free(pinv);
+          gsl_matrix_free(Xt);
+        }
+        bench_emit(first, "moore_penrose_pinv", nodes, -1, length, best, 0, NULL);
+      }
+
+      gsl_matrix_free(XXt);
+      gsl_matrix_free(y_Xt);
+      gsl_matrix_free(X);
+      free_esn(esn);
+    }
+    train_table_free(split);
+    train_table_free(table);
+  }
+}
+
+/**main - ESN BENCH
+  * Times the ESN hot paths and prints one JSON object: the label, the machine (CPU, cores, kernel, compiler and the fast tanh kernel in use) and a list of
+  * results, one per case, each the fastest of BENCH_REPS runs. Usage: bench [--quick] [--label name]. --quick runs a small grid for smoke testing.
+  * Results from different builds or engines are comparable case by case on (bench, nodes, density, length).
+*/
+int main(int argc, char** argv){
+  bool quick = false;
+  const char* label = "baseline";
+  for(int i = 1; i < argc; i++){
+    if(strcmp(argv[i], "--quick") == 0){
+      quick = true;
+    }
+    else if(strcmp(argv[i], "--label") == 0 && i + 1 < argc){
+      label = argv[++i];
+    }
+    else{
+      printf("usage: %s [--quick] [--label name]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  static const int full_nodes[] = {100, 400, 1000};
+  static const double full_densities[] = {1.0, 0.1, 0.01};
+  static const int full_lengths[] = {1000, 5000};
+  static const int quick_nodes[] = {50, 200};
+  static const double quick_densities[] = {1.0, 0.05};
+  static const int quick_lengths[] = {1000};
+  bench_grid grid;
+  if(quick){
+    grid = (bench_grid){quick_nodes, 2, quick_densities, 2, quick_lengths, 1};
+  }
+  else{
+    grid = (bench_grid){full_nodes, 3, full_densities, 3, full_lengths, 2};
+  }
+
+  char cpu[256];
+  bench_cpu(cpu, sizeof(cpu));
+  struct utsname host;
+  uname(&host);
+  printf("{\n  \"label\": \"%s\",\n  \"time\": %ld,\n", label, (long)time(NULL));
+  printf("  \"hardware\": {\"cpu\": \"%s\", \"cores\": %ld, \"machine\": \"%s\", \"kernel\": \"%s\", \"compiler\": \"%s\", \"tanh_kernel\": \"%s\"},\n", cpu,
+    sysconf(_SC_NPROCESSORS_ONLN), host.machine, host.release, __VERSION__, activation_name(ESN_TANH_FAST));
+  printf("  \"results\": [");
+
+  bool first = true;
+  bench_stepping(&grid, &first);
+  bench_topologies(&grid, &first);
+  bench_training(&grid, &first);
+  printf("\n  ]\n}\n");
+  return 0;
+}
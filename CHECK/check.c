@@ -0,0 +1,185 @@
+#include "../esn.h"
+#include "../esn_batch.h"
+#include <string.h>
+
+/** CHECK_SEED, CHECK_STEPS, CHECK_STREAMS, CHECK_TOL
+  * Every check draws its resevoir and inputs from streams seeded with CHECK_SEED and runs CHECK_STEPS steps (of CHECK_STREAMS streams for esn_batch).
+  * States from the sparse and dense kernels must agree to within CHECK_TOL; the kernels only differ in summation order, if at all.
+*/
+static const uint64_t CHECK_SEED = 20240601;
+static const int CHECK_STEPS = 200;
+static const int CHECK_STREAMS = 5;
+static const double CHECK_TOL = 1e-12;
+
+/**check_random_esn - CHECK RANDOM ESN
+  * Builds a randomized ESN from CHECK_SEED, held dense with a CSR copy (empty_esn) or only in CSR form (empty_sparse_esn).
+    * nodes. The resevoir size.
+    * density. The resevoir density.
+    * sparse_only. Whether to use empty_sparse_esn.
+*/
+static ESN* check_random_esn(int nodes, double density, bool sparse_only){
+  rand_stream rng;
+  rand_stream_init(&rng, CHECK_SEED, 0);
+  ESN* esn = sparse_only ? empty_sparse_esn(2, 1, nodes, 0.3, 1.0, 0.9) : empty_esn(2, 1, nodes, 0.3, 1.0, 0.9);
+  randomize_esn_rng(esn, density, &rng);
+  return esn;
+}
+
+/**check_inputs - CHECK INPUTS
+  * Draws a [(inputs + 1) x count] matrix of inputs in [-1, 1], each prefaced with the bias.
+    * inputs. The number of inputs.
+    * count. The number of columns.
+    * stream. The stream id to draw from.
+*/
+static gsl_matrix* check_inputs(int inputs, int count, uint64_t stream){
+  rand_stream rng;
+  rand_stream_init(&rng, CHECK_SEED, stream);
+  gsl_matrix* uN = gsl_matrix_alloc(inputs + 1, count);
+  for(int j = 0; j < count; j++){
+    gsl_matrix_set(uN, 0, j, 1.0);
+    for(int i = 1; i <= inputs; i++){
+      gsl_matrix_set(uN, i, j, rand_stream_range(&rng, -1.0, 1.0));
+    }
+  }
+  return uN;
+}
+
+/**check_run - CHECK RUN
+  * Runs an ESN from a zero state over CHECK_STEPS columns of inputs with step_esn, writing the state after each step to a column of states.
+    * esn. The ESN to run.
+    * uN. The [(inputs + 1) x CHECK_STEPS] inputs.
+    * states. The [nodes x CHECK_STEPS] matrix to write to.
+*/
+static void check_run(ESN* esn, const gsl_matrix* uN, gsl_matrix* states){
+  gsl_matrix_set_zero(esn->state);
+  for(int t = 0; t < CHECK_STEPS; t++){
+    gsl_vector_const_view uN_v = gsl_matrix_const_column(uN, t);
+    step_esn(esn, &uN_v.vector);
+    for(int i = 0; i < esn->nodes; i++){
+      gsl_matrix_set(states, i, t, gsl_matrix_get(esn->state, i, 0));
+    }
+  }
+}
+
+/**check_report - CHECK REPORT
+  * Prints whether two matrices agree to within CHECK_TOL and returns 0 if they do, 1 otherwise.
+    * name. The check's name.
+    * a, b. The matrices to compare.
+*/
+static int check_report(const char* name, const gsl_matrix* a, const gsl_matrix* b){
+  double diff = 0.0;
+  for(size_t i = 0; i < a->size1; i++){
+    for(size_t j = 0; j < a->size2; j++){
+      double d = fabs(gsl_matrix_get(a, i, j) - gsl_matrix_get(b, i, j));
+      diff = d > diff || isnan(d) ? d : diff;
+    }
+  }
+  bool ok = diff <= CHECK_TOL;
+  printf("check: %-40s %s (max difference %g)\n", name, ok ? "ok" : "FAILED", diff);
+  return ok ? 0 : 1;
+}
+
+/**check_step - CHECK STEP
+  * Checks that step_esn gives the same states through w_sparse as through the dense w, and through the CSR-only resevoir of empty_sparse_esn drawn
+  * from the same stream. Returns the number of failed checks.
+    * nodes. The resevoir size.
+    * density. The resevoir density, at most ESN_SPARSE_DENSITY.
+*/
+static int check_step(int nodes, double density){
+  ESN* esn = check_random_esn(nodes, density, false);
+  gsl_matrix* uN = check_inputs(esn->inputs, CHECK_STEPS, 1);
+  gsl_matrix* sparse = gsl_matrix_alloc(nodes, CHECK_STEPS);
+  gsl_matrix* dense = gsl_matrix_alloc(nodes, CHECK_STEPS);
+  gsl_matrix* sparse_only = gsl_matrix_alloc(nodes, CHECK_STEPS);
+
+  int failed = 0;
+  esn_use_sparse(esn, true);
+  check_run(esn, uN, sparse);
+  esn_use_sparse(esn, false);
+  check_run(esn, uN, dense);
+  failed += check_report("step_esn sparse vs dense", sparse, dense);
+
+  ESN* csr_esn = check_random_esn(nodes, density, true);
+  check_run(csr_esn, uN, sparse_only);
+  failed += check_report("step_esn empty_sparse_esn vs dense", sparse_only, dense);
+
+  free_esn(csr_esn);
+  free_esn(esn);
+  gsl_matrix_free(uN);
+  gsl_matrix_free(sparse);
+  gsl_matrix_free(dense);
+  gsl_matrix_free(sparse_only);
+  return failed;
+}
+
+/**check_batch - CHECK BATCH
+  * Checks that esn_batch_step_into gives the same states through w_sparse as through the dense w, and as stepping each stream alone. Returns the number of
+  * failed checks.
+    * nodes. The resevoir size.
+    * density. The resevoir density, at most ESN_SPARSE_DENSITY.
+*/
+static int check_batch(int nodes, double density){
+  ESN* esn = check_random_esn(nodes, density, false);
+  gsl_matrix* uN = check_inputs(esn->inputs, CHECK_STEPS * CHECK_STREAMS, 2);
+  gsl_matrix* sparse = gsl_matrix_alloc(nodes, CHECK_STREAMS);
+  gsl_matrix* dense = gsl_matrix_alloc(nodes, CHECK_STREAMS);
+  gsl_matrix* alone = gsl_matrix_alloc(nodes, CHECK_STREAMS);
+  esn_batch* batch = esn_batch_alloc(esn, CHECK_STREAMS);
+
+  int failed = 0;
+  for(int pass = 0; pass < 2; pass++){
+    esn_use_sparse(esn, pass == 0);
+    esn_batch_reset(batch);
+    for(int t = 0; t < CHECK_STEPS; t++){
+      gsl_matrix_const_view uN_t = gsl_matrix_const_submatrix(uN, 0, t * CHECK_STREAMS, esn->inputs + 1, CHECK_STREAMS);
+      esn_batch_step(batch, &uN_t.matrix);
+    }
+    gsl_matrix_memcpy(pass == 0 ? sparse : dense, batch->state);
+  }
+  failed += check_report("esn_batch_step_into sparse vs dense", sparse, dense);
+
+  esn_use_sparse(esn, true);
+  gsl_vector* state = gsl_vector_alloc(nodes);
+  gsl_vector* next = gsl_vector_alloc(nodes);
+  for(int b = 0; b < CHECK_STREAMS; b++){
+    gsl_vector_set_zero(state);
+    for(int t = 0; t < CHECK_STEPS; t++){
+      gsl_vector_const_view uN_v = gsl_matrix_const_column(uN, t * CHECK_STREAMS + b);
+      esn_step_into(esn, &uN_v.vector, state, next);
+      gsl_vector* old_state = state;
+      state = next;
+      next = old_state;
+    }
+    gsl_vector_view column = gsl_matrix_column(alone, b);
+    gsl_vector_memcpy(&column.vector, state);
+  }
+  failed += check_report("esn_batch_step_into vs esn_step_into", sparse, alone);
+
+  gsl_vector_free(state);
+  gsl_vector_free(next);
+  esn_batch_free(batch);
+  free_esn(esn);
+  gsl_matrix_free(uN);
+  gsl_matrix_free(sparse);
+  gsl_matrix_free(dense);
+  gsl_matrix_free(alone);
+  return failed;
+}
+
+/**main - ESN CHECK
+  * Checks that the sparse resevoir kernels produce the same states as the dense ones. Prints one line per check and exits with status 1 if any failed.
+*/
+int main(){
+  static const int nodes[2] = {50, 300};
+  static const double densities[2] = {0.02, 0.05};
+  int failed = 0;
+  for(int n = 0; n < 2; n++){
+    for(int d = 0; d < 2; d++){
+      printf("check: %d nodes, density %g\n", nodes[n], densities[d]);
+      failed += check_step(nodes[n], densities[d]);
+      failed += check_batch(nodes[n], densities[d]);
+    }
+  }
+  printf("check: %d failed\n", failed);
+  return failed == 0 ? 0 : 1;
+}
@@ -1,6 +1,8 @@
 #include "../train.h"
 #include "../esn.h"
 #include "../included_datasets.h"
+#include "../search.h"
+#include <string.h>
 
 int
 main (void)
@@ -18,53 +20,50 @@ main (void)
     betas[4] = 0.000000001;
 
     int runs = 10000;
+    int nodes = 200;
+
+    search_config config;
+    search_config_init(&config, 1, 1, nodes, runs, betas, 5);
+    config.verbose = true;
+
+    search_result* results = hyperparameter_search(dataset, &config);
 
     double train_scores[runs];
     double best_train = 999999;
     double validate_scores[runs];
-    double best_validate = 999999;
     double test_scores[runs];
     double best_test = 999999;
 
-    double best_lr;
-    double best_is;
-    double best_sr;
-    double best_s;
-
-    int nodes = 200;
-
     for(int i = 0; i < runs; i++){
-      double leak_rate = rand_range(0.0, 1.0);
-      double input_scale = rand_range(-1.0, 1.0);
-      double spectral_radius = rand_range(-1.0, 1.0);
-      double sparsity = rand_range(0.005, 1.0);
-      ESN* esn = empty_esn(1, 1, nodes, leak_rate, input_scale, spectral_radius);
-      printf("ESN %d: sparsity = %lf | leak rate = %lf | input scale = %lf | spectral radius = %lf\n", i, sparsity, leak_rate, input_scale, spectral_radius);
-      randomize_esn(esn, sparsity);
-      train_esn_ridge_regression(esn, dataset, 0, 1, betas, 5);
-      double train_score = nmse(esn, dataset, 0);
-      double validate_score = nmse(esn, dataset, 1);
-      double test_score = nmse(esn, dataset, 2);
-      train_scores[i] = train_score;
-      validate_scores[i] = validate_score;
-      test_scores[i] = test_score;
-      if(train_score < best_train){
-        best_train = train_score;
+      train_scores[i] = results[i].train_nmse;
+      validate_scores[i] = results[i].validate_nmse;
+      test_scores[i] = results[i].test_nmse;
+      if(train_scores[i] < best_train){
+        best_train = train_scores[i];
       }
-      if(validate_score < best_validate){
-        best_validate = validate_score;
-        best_lr = leak_rate;
-        best_is = input_scale;
-        best_sr = spectral_radius;
-        best_s = sparsity;
+      if(test_scores[i] < best_test){
+        best_test = test_scores[i];
       }
-      if(test_score < best_test){
-        best_test = test_score;
-      }
-      printf("  scores: %lf | %lf | %lf\n", train_score, validate_score, test_score);
-      free_esn(esn);
+    }
 
+    /* Results are ranked by validation NMSE. */
+    double best_validate = results[0].validate_nmse;
+    double best_lr = results[0].leak_rate;
+    double best_is = results[0].input_scale;
+    double best_sr = results[0].spectral_radius;
+    double best_s = results[0].density;
+    if(profile_enabled()){
+      profile_report total;
+      memset(&total, 0, sizeof(total));
+      for(int i = 0; i < runs; i++){
+        profile_add(&total, &results[i].profile);
+      }
+      printf("Profile of the best candidate: ");
+      profile_dump(stdout, &results[0].profile);
+      printf("Profile of the whole search: ");
+      profile_dump(stdout, &total);
     }
+    free(results);
 
     printf("Train: mean %lf best %lf\n", train_mean(train_scores, runs), best_train);
     printf("Validate: mean %lf best %lf\n", train_mean(validate_scores, runs), best_validate);
@@ -72,16 +71,22 @@ main (void)
 
     printf("\n\nBest validate params: [%lf, %lf, %lf, %lf]\n", best_s, best_lr, best_is, best_sr);
     ESN* esn = empty_esn(1, 1, nodes, best_lr, best_is, best_sr);
+    const int tables[3] = {0, 1, 2};
     for(int i = 0; i < 20; i++){
       randomize_esn(esn, best_s);
-      train_esn_ridge_regression(esn, dataset, 0, 1, betas, 5);
-      double train_score = nmse(esn, dataset, 0);
-      double validate_score = nmse(esn, dataset, 1);
-      double test_score = nmse(esn, dataset, 2);
-      printf("  scores: %lf | %lf | %lf\n", train_score, validate_score, test_score);
+      train_esn_ridge_regression_concurrent(esn, dataset, 0, 1, betas, 5, RIDGE_AUTO, 0);
+      double scores[3];
+      nmse_tables(esn, dataset, tables, 3, 0, scores);
+      printf("  scores: %lf | %lf | %lf\n", scores[0], scores[1], scores[2]);
+    }
+
+    double cv_scores[5];
+    int best_beta = train_esn_ridge_cv(esn, dataset, 0, 5, betas, 5, RIDGE_AUTO, 0, cv_scores);
+    if(best_beta >= 0){
+      printf("5-fold CV beta %g (held-out NMSE %lf): test %lf\n", betas[best_beta], cv_scores[best_beta], nmse(esn, dataset, 2));
     }
 
-    free(esn);
+    free_esn(esn);
 
     train_dataset_free(dataset);
 
@@ -0,0 +1,50 @@
+#include "../train.h"
+#include "../esn.h"
+#include "../esn_rollout.h"
+#include "../included_datasets.h"
+
+int
+main (void)
+{
+    printf("Generating dataset\n");
+    train_dataset* dataset = mackey_glass_dataset(6000, 2000, 3000, 100, 17);
+    double betas[5];
+    betas[0] = 0.1;
+    betas[1] = 0.001;
+    betas[2] = 0.00001;
+    betas[3] = 0.0000001;
+    betas[4] = 0.000000001;
+
+    rand_stream rng;
+    rand_stream_init(&rng, 17, 0);
+    ESN* esn = empty_esn(1, 1, 400, 0.3, 0.5, 0.95);
+    randomize_esn_rng(esn, 0.05, &rng);
+    train_esn_ridge_regression(esn, dataset, 0, 1, betas, 5);
+    printf("One step NMSE: %lf | %lf | %lf\n", nmse(esn, dataset, 0), nmse(esn, dataset, 1), nmse(esn, dataset, 2));
+
+    int count = 1000;
+    int horizon = 200;
+    int* origins = malloc(count * sizeof(int));
+    for(int k = 0; k < count; k++){
+      origins[k] = 200 + (k * (dataset->test->entries - horizon - 200)) / count;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    gsl_matrix* predictions = esn_rollout(esn, dataset->test, origins, count, horizon);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Rolled out %d origins %d steps ahead in %lfs\n", count, horizon, (end.tv_sec - start.tv_sec) + (1e-9 * (end.tv_nsec - start.tv_nsec)));
+
+    gsl_vector* curve = esn_rollout_nmse(predictions, dataset->test, origins, count);
+    printf("horizon\ttest NMSE\n");
+    for(int h = 0; h < horizon; h += (h < 10 ? 1 : 10)){
+      printf("%d\t%lf\n", h, gsl_vector_get(curve, h));
+    }
+
+    gsl_vector_free(curve);
+    gsl_matrix_free(predictions);
+    free(origins);
+    free_esn(esn);
+    train_dataset_free(dataset);
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include "../train.h"
+#include "../esn.h"
+#include "../esn_float.h"
+#include "../included_datasets.h"
+
+int
+main (void)
+{
+  srand(time(NULL));
+
+    printf("Generating dataset\n");
+    train_dataset* dataset = NARMA__10_dataset(6000, 2000, 2000, 100, 0.3, 0.05, 0.1, 1.0, 0.0, 0.5);
+    double betas[5];
+    betas[0] = 0.1;
+    betas[1] = 0.001;
+    betas[2] = 0.00001;
+    betas[3] = 0.0000001;
+    betas[4] = 0.000000001;
+
+    int runs = 5;
+    int sizes[3] = {50, 200, 400};
+    double densities[3] = {1.0, 0.1, 0.05};
+
+    printf("nodes\tdensity\tdouble train\tdouble test\tfloat train\tfloat test\ttest drift\n");
+    for(int s = 0; s < 3; s++){
+      for(int r = 0; r < runs; r++){
+        ESN* esn = empty_esn(1, 1, sizes[s], 0.3, 1.0, 0.9);
+        randomize_esn(esn, densities[s]);
+
+        train_esn_ridge_regression(esn, dataset, 0, 1, betas, 5);
+        double double_train = nmse(esn, dataset, 0);
+        double double_test = nmse(esn, dataset, 2);
+
+        esn_float* f = esn_float_from_esn(esn);
+        train_esn_float_ridge_regression(f, dataset, 0, 1, betas, 5, RIDGE_AUTO);
+        double float_train = esn_float_nmse(f, dataset, 0);
+        double float_test = esn_float_nmse(f, dataset, 2);
+
+        printf("%d\t%g\t%f\t%f\t%f\t%f\t%+e\n", sizes[s], densities[s], double_train, double_test, float_train, float_test, float_test - double_test);
+
+        esn_float_free(f);
+        free_esn(esn);
+      }
+    }
+
+    train_dataset_free(dataset);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "../esn.h"
+#include "../esn_file.h"
+#include "server_protocol.h"
+#include <string.h>
+#include <unistd.h>
+
+/**client_expect - CLIENT EXPECT
+  * Reads one reply and prints it if it is an error. Returns 0 if the reply has the expected type, otherwise -1.
+    * fd. The connection.
+    * type. The expected reply type.
+    * frame. Set to the reply's header.
+    * payload, capacity. The receive buffer, as server_recv.
+*/
+static int client_expect(int fd, uint32_t type, server_frame* frame, void** payload, size_t* capacity){
+  if(server_recv(fd, frame, payload, capacity) != 0){
+    printf("esn_client: the server closed the connection.\n");
+    return -1;
+  }
+  if(frame->type == SERVER_ERROR){
+    printf("esn_client: %.*s\n", (int)frame->length, (char*)*payload);
+    return -1;
+  }
+  return frame->type == type ? 0 : -1;
+}
+
+/**main - ESN CLIENT
+  * A command line client for esn_server. Usage:
+    * esn_client <socket path> - reads one input vector per line of stdin (inputs whitespace separated numbers) and prints the output after each step.
+    * esn_client <socket path> info - prints the served model's shape and the number of wOut swaps.
+    * esn_client <socket path> reset - zeros this session's state (useful only to test the server, as each connection is a new session).
+    * esn_client <socket path> swap <model file> - replaces the served wOut with the wOut of a model file written by esn_save for the same resevoir.
+*/
+int main(int argc, char** argv){
+  if(argc < 2){
+    printf("usage: %s <socket path> [info | reset | swap <model file>]\n", argv[0]);
+    return 1;
+  }
+  int fd = server_connect(argv[1]);
+  if(fd < 0){
+    return 1;
+  }
+  server_frame frame;
+  void* payload = NULL;
+  size_t capacity = 0;
+  int status = 0;
+
+  if(server_send(fd, SERVER_INFO, 0, 0, NULL, 0) != 0 || client_expect(fd, SERVER_INFO, &frame, &payload, &capacity) != 0){
+    close(fd);
+    free(payload);
+    return 1;
+  }
+  uint32_t info[4];
+  memcpy(info, payload, sizeof(info));
+
+  if(argc >= 3 && strcmp(argv[2], "info") == 0){
+    printf("inputs %u outputs %u nodes %u swaps %u\n", info[0], info[1], info[2], info[3]);
+  }
+  else if(argc >= 3 && strcmp(argv[2], "reset") == 0){
+    status = server_send(fd, SERVER_RESET, 1, 0, NULL, 0) != 0 || client_expect(fd, SERVER_OK, &frame, &payload, &capacity) != 0;
+  }
+  else if(argc >= 4 && strcmp(argv[2], "swap") == 0){
+    ESN* esn = esn_load(argv[3]);
+    if(esn == NULL){
+      status = 1;
+    }
+    else{
+      gsl_matrix* wOut = gsl_matrix_alloc(esn->wOut->size1, esn->wOut->size2);
+      gsl_matrix_memcpy(wOut, esn->wOut);
+      status = server_send(fd, SERVER_SWAP, 1, 0, wOut->data, wOut->size1 * wOut->size2 * sizeof(double)) != 0
+        || client_expect(fd, SERVER_OK, &frame, &payload, &capacity) != 0;
+      gsl_matrix_free(wOut);
+      free_esn(esn);
+    }
+  }
+  else{
+    double input[info[0] > 0 ? info[0] : 1];
+    char line[4096];
+    uint32_t id = 1;
+    while(status == 0 && fgets(line, sizeof(line), stdin) != NULL){
+      char* cursor = line;
+      uint32_t read = 0;
+      for(; read < info[0]; read++){
+        char* end;
+        input[read] = strtod(cursor, &end);
+        if(end == cursor){
+          break;
+        }
+        cursor = end;
+      }
+      if(read < info[0]){
+        continue;
+      }
+      if(server_send(fd, SERVER_STEP, id++, 1, input, info[0] * sizeof(double)) != 0
+        || client_expect(fd, SERVER_OUTPUT, &frame, &payload, &capacity) != 0){
+        status = 1;
+        break;
+      }
+      for(uint32_t o = 0; o < info[1]; o++){
+        printf(o == 0 ? "%f" : "\t%f", ((double*)payload)[o]);
+      }
+      printf("\n");
+    }
+  }
+
+  close(fd);
+  free(payload);
+  return status;
+}
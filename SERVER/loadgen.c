@@ -0,0 +1,155 @@
+#include "server_protocol.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**STRUCT loadgen_worker - LOADGEN WORKER
+ * One simulated client. The components are:
+  * path - The server's socket path.
+  * requests - The number of SERVER_STEP requests to send.
+  * depth - The number of requests kept in flight (1 = no pipelining).
+  * batch - The number of steps per request.
+  * seed - The seed of the worker's inputs.
+  * latency - A requests long array of round trip times in seconds, filled in by the worker.
+  * failed - Set if the connection failed.
+*/
+typedef struct loadgen_worker{
+  const char* path;
+  int requests;
+  int depth;
+  int batch;
+  unsigned int seed;
+  double* latency;
+  int failed;
+} loadgen_worker;
+
+/**loadgen_now - LOADGEN NOW
+  * The monotonic clock in seconds.
+*/
+static double loadgen_now(){
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + (1e-9 * t.tv_nsec);
+}
+
+/**loadgen_compare - LOADGEN COMPARE
+  * qsort comparison of doubles.
+*/
+static int loadgen_compare(const void* a, const void* b){
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+/**loadgen_run - LOADGEN RUN
+  * The body of a worker thread: opens a session, keeps depth requests in flight until requests have been answered, and times each one from send to reply.
+    * arg. The loadgen_worker.
+*/
+static void* loadgen_run(void* arg){
+  loadgen_worker* w = arg;
+  w->failed = 1;
+  int fd = server_connect(w->path);
+  if(fd < 0){
+    return NULL;
+  }
+  server_frame frame;
+  void* payload = NULL;
+  size_t capacity = 0;
+  if(server_send(fd, SERVER_INFO, 0, 0, NULL, 0) != 0 || server_recv(fd, &frame, &payload, &capacity) != 0 || frame.type != SERVER_INFO){
+    close(fd);
+    free(payload);
+    return NULL;
+  }
+  uint32_t inputs = ((uint32_t*)payload)[0];
+  size_t values = (size_t)inputs * w->batch;
+  double* input = malloc((values > 0 ? values : 1) * sizeof(double));
+  double* sent = malloc(w->depth * sizeof(double));
+
+  int issued = 0;
+  int answered = 0;
+  int ok = 1;
+  while(ok && answered < w->requests){
+    while(issued < w->requests && issued - answered < w->depth){
+      for(size_t i = 0; i < values; i++){
+        input[i] = 0.5 * rand_r(&w->seed) / RAND_MAX;
+      }
+      sent[issued % w->depth] = loadgen_now();
+      ok = server_send(fd, SERVER_STEP, issued, w->batch, input, values * sizeof(double)) == 0;
+      issued++;
+    }
+    ok = ok && server_recv(fd, &frame, &payload, &capacity) == 0 && frame.type == SERVER_OUTPUT && frame.id == (uint32_t)answered;
+    if(ok){
+      w->latency[answered] = loadgen_now() - sent[answered % w->depth];
+      answered++;
+    }
+  }
+  w->failed = !ok;
+
+  free(input);
+  free(sent);
+  free(payload);
+  close(fd);
+  return NULL;
+}
+
+/**main - ESN LOADGEN
+  * Measures an esn_server's throughput and latency. Usage: esn_loadgen <socket path> [sessions] [requests per session] [pipeline depth] [steps per request].
+  * Each session runs on its own thread with random inputs in [0, 0.5]. Prints one JSON object with the throughput in steps per second and the round trip
+  * latency percentiles of every request in microseconds.
+*/
+int main(int argc, char** argv){
+  if(argc < 2){
+    printf("usage: %s <socket path> [sessions] [requests per session] [pipeline depth] [steps per request]\n", argv[0]);
+    return 1;
+  }
+  int sessions = argc > 2 ? atoi(argv[2]) : 4;
+  int requests = argc > 3 ? atoi(argv[3]) : 10000;
+  int depth = argc > 4 ? atoi(argv[4]) : 1;
+  int batch = argc > 5 ? atoi(argv[5]) : 1;
+  if(sessions < 1 || requests < 1 || depth < 1 || batch < 1){
+    printf("esn_loadgen: sessions, requests, depth and steps must be positive.\n");
+    return 1;
+  }
+
+  loadgen_worker* workers = malloc(sessions * sizeof(loadgen_worker));
+  pthread_t* threads = malloc(sessions * sizeof(pthread_t));
+  double start = loadgen_now();
+  for(int i = 0; i < sessions; i++){
+    workers[i].path = argv[1];
+    workers[i].requests = requests;
+    workers[i].depth = depth;
+    workers[i].batch = batch;
+    workers[i].seed = 12345u + i;
+    workers[i].latency = malloc(requests * sizeof(double));
+    pthread_create(&threads[i], NULL, loadgen_run, &workers[i]);
+  }
+  int failed = 0;
+  for(int i = 0; i < sessions; i++){
+    pthread_join(threads[i], NULL);
+    failed += workers[i].failed;
+  }
+  double elapsed = loadgen_now() - start;
+  if(failed > 0){
+    printf("esn_loadgen: %d of %d sessions failed.\n", failed, sessions);
+    return 1;
+  }
+
+  size_t total = (size_t)sessions * requests;
+  double* latency = malloc(total * sizeof(double));
+  for(int i = 0; i < sessions; i++){
+    memcpy(latency + ((size_t)i * requests), workers[i].latency, requests * sizeof(double));
+    free(workers[i].latency);
+  }
+  qsort(latency, total, sizeof(double), loadgen_compare);
+  printf("{\"sessions\": %d, \"requests\": %zu, \"depth\": %d, \"steps_per_request\": %d, \"seconds\": %.6f, \"steps_per_second\": %.1f, "
+    "\"latency_us\": {\"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, \"max\": %.2f}}\n", sessions, total, depth, batch, elapsed,
+    total * (double)batch / elapsed, 1e6 * latency[total / 2], 1e6 * latency[(total * 9) / 10], 1e6 * latency[(total * 99) / 100], 1e6 * latency[total - 1]);
+
+  free(latency);
+  free(workers);
+  free(threads);
+  return 0;
+}
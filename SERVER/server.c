@@ -0,0 +1,455 @@
+#include "../esn.h"
+#include "../esn_file.h"
+#include "server_protocol.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <gsl/gsl_blas.h>
+
+/** SERVER_READ_CHUNK, SERVER_OUT_LIMIT
+  * Connections are read SERVER_READ_CHUNK bytes at a time. Once a connection's unsent replies reach SERVER_OUT_LIMIT bytes, neither its buffered frames
+  * are answered nor is it read from again until they drain, so a client that pipelines without reading cannot grow the server's memory without bound.
+*/
+static const size_t SERVER_READ_CHUNK = 64 * 1024;
+static const size_t SERVER_OUT_LIMIT = 4 << 20;
+
+/**STRUCT session - SESSION
+ * One client connection and its own resevoir state. Every session shares the server's ESN weights. The components are:
+  * fd - The connection, non blocking.
+  * state - The session's nodes long state.
+  * state_next - A nodes long scratch vector the next state is written into before it is swapped with state.
+  * uN - The (inputs + 1) long current input, prefaced with the bias.
+  * y - An outputs long scratch vector for the current readout.
+  * in, in_length, in_capacity - Bytes read from the connection that do not yet form a whole frame.
+  * out, out_start, out_length, out_capacity - Replies not yet written. Bytes out_start to out_length - 1 are pending.
+*/
+typedef struct session{
+  int fd;
+  gsl_vector* state;
+  gsl_vector* state_next;
+  gsl_vector* uN;
+  gsl_vector* y;
+  char* in;
+  size_t in_length;
+  size_t in_capacity;
+  char* out;
+  size_t out_start;
+  size_t out_length;
+  size_t out_capacity;
+} session;
+
+/**STRUCT server - SERVER
+ * The server's state. The components are:
+  * esn - The model being served. Its wOut is replaced by SERVER_SWAP.
+  * swaps - The number of times wOut has been replaced.
+  * listener - The listening socket.
+  * sessions, session_count, session_capacity - The open sessions.
+*/
+typedef struct server{
+  ESN* esn;
+  uint32_t swaps;
+  int listener;
+  session** sessions;
+  int session_count;
+  int session_capacity;
+} server;
+
+static volatile sig_atomic_t server_stop = 0;
+
+/**server_signal - SERVER SIGNAL
+  * Asks the poll loop to stop.
+*/
+static void server_signal(int signal){
+  (void)signal;
+  server_stop = 1;
+}
+
+/**session_alloc - SESSION ALLOC
+  * Allocates a session for a newly accepted connection with a zero'd state.
+    * esn. The ESN being served.
+    * fd. The connection.
+*/
+static session* session_alloc(const ESN* esn, int fd){
+  session* c = malloc(sizeof(session));
+  c->fd = fd;
+  c->state = gsl_vector_calloc(esn->nodes);
+  c->state_next = gsl_vector_calloc(esn->nodes);
+  c->uN = gsl_vector_alloc(esn->inputs + 1);
+  c->y = gsl_vector_alloc(esn->outputs);
+  c->in_capacity = SERVER_READ_CHUNK;
+  c->in = malloc(c->in_capacity);
+  c->in_length = 0;
+  c->out_capacity = SERVER_READ_CHUNK;
+  c->out = malloc(c->out_capacity);
+  c->out_start = 0;
+  c->out_length = 0;
+  return c;
+}
+
+/**session_free - SESSION FREE
+  * Closes a session's connection and frees it.
+    * c. The session to free.
+*/
+static void session_free(session* c){
+  close(c->fd);
+  gsl_vector_free(c->state);
+  gsl_vector_free(c->state_next);
+  gsl_vector_free(c->uN);
+  gsl_vector_free(c->y);
+  free(c->in);
+  free(c->out);
+  free(c);
+}
+
+/**session_reserve - SESSION RESERVE
+  * Makes room for a reply of bytes bytes at the end of a session's output and returns where to write it. The caller must then advance out_length.
+    * c. The session.
+    * bytes. The size of the reply.
+*/
+static char* session_reserve(session* c, size_t bytes){
+  if(c->out_start == c->out_length){
+    c->out_start = 0;
+    c->out_length = 0;
+  }
+  if(c->out_length + bytes > c->out_capacity){
+    if(c->out_start > 0){
+      memmove(c->out, c->out + c->out_start, c->out_length - c->out_start);
+      c->out_length -= c->out_start;
+      c->out_start = 0;
+    }
+    while(c->out_length + bytes > c->out_capacity){
+      c->out_capacity *= 2;
+    }
+    c->out = realloc(c->out, c->out_capacity);
+  }
+  return c->out + c->out_length;
+}
+
+/**session_reply - SESSION REPLY
+  * Queues a reply frame on a session.
+    * c. The session.
+    * type, id, count. The reply's header fields.
+    * payload. The reply's payload, or NULL if length is 0.
+    * length. The length of the payload in bytes.
+*/
+static void session_reply(session* c, uint32_t type, uint32_t id, uint32_t count, const void* payload, uint32_t length){
+  server_frame frame = {type, id, count, length};
+  char* out = session_reserve(c, sizeof(frame) + length);
+  memcpy(out, &frame, sizeof(frame));
+  if(length > 0){
+    memcpy(out + sizeof(frame), payload, length);
+  }
+  c->out_length += sizeof(frame) + length;
+}
+
+/**session_error - SESSION ERROR
+  * Queues a SERVER_ERROR reply on a session.
+    * c. The session.
+    * id. The id of the rejected request.
+    * message. Why it was rejected.
+*/
+static void session_error(session* c, uint32_t id, const char* message){
+  session_reply(c, SERVER_ERROR, id, 0, message, strlen(message));
+}
+
+/**session_step - SESSION STEP
+  * Answers a SERVER_STEP request: steps the session through each input in turn and writes each readout straight into the reply. Makes no allocations
+  * beyond growing the output buffer.
+    * s. The server.
+    * c. The session.
+    * frame. The request header.
+    * payload. The request's count x inputs doubles.
+*/
+static void session_step(server* s, session* c, const server_frame* frame, const char* payload){
+  ESN* esn = s->esn;
+  if(frame->count == 0 || frame->length != (uint64_t)frame->count * esn->inputs * sizeof(double)){
+    session_error(c, frame->id, "SERVER_STEP payload must be count x inputs doubles.");
+    return;
+  }
+  uint64_t reply_length = (uint64_t)frame->count * esn->outputs * sizeof(double);
+  if(reply_length > SERVER_MAX_PAYLOAD){
+    session_error(c, frame->id, "SERVER_STEP reply would exceed SERVER_MAX_PAYLOAD; send fewer steps.");
+    return;
+  }
+  uint32_t length = (uint32_t)reply_length;
+  server_frame reply = {SERVER_OUTPUT, frame->id, frame->count, length};
+  char* out = session_reserve(c, sizeof(reply) + length);
+  memcpy(out, &reply, sizeof(reply));
+  double* outputs = (double*)(out + sizeof(reply));
+
+  gsl_matrix_const_view wOut_in = gsl_matrix_const_submatrix(esn->wOut, 0, 0, esn->outputs, 1 + esn->inputs);
+  gsl_matrix_const_view wOut_res = gsl_matrix_const_submatrix(esn->wOut, 0, 1 + esn->inputs, esn->outputs, esn->nodes);
+  gsl_vector_set(c->uN, 0, 1.0);
+  for(uint32_t t = 0; t < frame->count; t++){
+    memcpy(c->uN->data + 1, payload + (size_t)t * esn->inputs * sizeof(double), esn->inputs * sizeof(double));
+    esn_step_into(esn, c->uN, c->state, c->state_next);
+    gsl_vector* old_state = c->state;
+    c->state = c->state_next;
+    c->state_next = old_state;
+
+    /* the reply buffer is only byte aligned, so the readout goes through the session's scratch vector */
+    gsl_blas_dgemv(CblasNoTrans, 1.0, &wOut_in.matrix, c->uN, 0.0, c->y);
+    gsl_blas_dgemv(CblasNoTrans, 1.0, &wOut_res.matrix, c->state, 1.0, c->y);
+    memcpy(outputs + (size_t)t * esn->outputs, c->y->data, esn->outputs * sizeof(double));
+  }
+  c->out_length += sizeof(reply) + length;
+}
+
+/**session_swap - SESSION SWAP
+  * Answers a SERVER_SWAP request by replacing the served wOut. The poll loop handles one frame at a time, so every session sees either the old or the new
+  * wOut for a whole step, and no session's state is disturbed.
+    * s. The server.
+    * c. The session.
+    * frame. The request header.
+    * payload. The new wOut.
+*/
+static void session_swap(server* s, session* c, const server_frame* frame, const char* payload){
+  ESN* esn = s->esn;
+  size_t size = esn->wOut->size1 * esn->wOut->size2;
+  if(frame->length != size * sizeof(double)){
+    session_error(c, frame->id, "SERVER_SWAP payload must be outputs x (1 + inputs + nodes) doubles.");
+    return;
+  }
+  gsl_matrix* wOut = gsl_matrix_alloc(esn->wOut->size1, esn->wOut->size2);
+  memcpy(wOut->data, payload, frame->length);
+  for(size_t i = 0; i < size; i++){
+    if(!isfinite(wOut->data[i])){
+      gsl_matrix_free(wOut);
+      session_error(c, frame->id, "SERVER_SWAP wOut is not finite.");
+      return;
+    }
+  }
+  gsl_matrix_free(esn->wOut);
+  esn->wOut = wOut;
+  s->swaps++;
+  session_reply(c, SERVER_OK, frame->id, 0, NULL, 0);
+}
+
+/**session_handle - SESSION HANDLE
+  * Answers one request frame.
+    * s. The server.
+    * c. The session.
+    * frame. The request header.
+    * payload. The request's payload.
+*/
+static void session_handle(server* s, session* c, const server_frame* frame, const char* payload){
+  if(frame->type == SERVER_STEP){
+    session_step(s, c, frame, payload);
+  }
+  else if(frame->type == SERVER_RESET){
+    gsl_vector_set_zero(c->state);
+    session_reply(c, SERVER_OK, frame->id, 0, NULL, 0);
+  }
+  else if(frame->type == SERVER_SWAP){
+    session_swap(s, c, frame, payload);
+  }
+  else if(frame->type == SERVER_INFO){
+    uint32_t info[4] = {s->esn->inputs, s->esn->outputs, s->esn->nodes, s->swaps};
+    session_reply(c, SERVER_INFO, frame->id, 0, info, sizeof(info));
+  }
+  else{
+    session_error(c, frame->id, "Unknown frame type.");
+  }
+}
+
+/**session_flush - SESSION FLUSH
+  * Writes as much of a session's pending output as the connection will take. Returns 0, or -1 if the connection failed.
+    * c. The session.
+*/
+static int session_flush(session* c){
+  while(c->out_start < c->out_length){
+    ssize_t written = write(c->fd, c->out + c->out_start, c->out_length - c->out_start);
+    if(written < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    }
+    c->out_start += written;
+  }
+  return 0;
+}
+
+/**session_read - SESSION READ
+  * Reads whatever a session's connection has into its input buffer. Returns 0, or -1 if the connection closed or failed.
+    * c. The session.
+*/
+static int session_read(session* c){
+  for(;;){
+    if(c->in_capacity - c->in_length < SERVER_READ_CHUNK){
+      c->in_capacity = c->in_length + SERVER_READ_CHUNK;
+      c->in = realloc(c->in, c->in_capacity);
+    }
+    ssize_t got = read(c->fd, c->in + c->in_length, c->in_capacity - c->in_length);
+    if(got < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      if(errno == EAGAIN || errno == EWOULDBLOCK){
+        break;
+      }
+      return -1;
+    }
+    if(got == 0){
+      return -1;
+    }
+    c->in_length += got;
+    if(c->in_length < c->in_capacity){
+      break;
+    }
+  }
+  return 0;
+}
+
+/**session_dispatch - SESSION DISPATCH
+  * Answers the whole frames in a session's input buffer, in order, so pipelined requests are handled without waiting for another wakeup. Stops once the
+  * unsent replies reach SERVER_OUT_LIMIT; the remaining frames are answered after the output drains. Returns 0, or -1 if the session sent an oversized frame.
+    * s. The server.
+    * c. The session.
+*/
+static int session_dispatch(server* s, session* c){
+  size_t start = 0;
+  while(c->in_length - start >= sizeof(server_frame) && c->out_length - c->out_start < SERVER_OUT_LIMIT){
+    server_frame frame;
+    memcpy(&frame, c->in + start, sizeof(frame));
+    if(frame.length > SERVER_MAX_PAYLOAD){
+      return -1;
+    }
+    if(c->in_length - start < sizeof(frame) + frame.length){
+      break;
+    }
+    session_handle(s, c, &frame, c->in + start + sizeof(frame));
+    start += sizeof(frame) + frame.length;
+  }
+  memmove(c->in, c->in + start, c->in_length - start);
+  c->in_length -= start;
+  return 0;
+}
+
+/**server_listen - SERVER LISTEN
+  * Creates a non blocking Unix domain socket listening at path, replacing any stale socket file. Returns the descriptor, or -1 (after printing why).
+    * path. The socket path.
+*/
+static int server_listen(const char* path){
+  struct sockaddr_un address;
+  if(strlen(path) >= sizeof(address.sun_path)){
+    printf("esn_server: socket path %s is too long.\n", path);
+    return -1;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path);
+  unlink(path);
+  if(fd < 0 || bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 128) != 0){
+    printf("esn_server: could not listen on %s.\n", path);
+    if(fd >= 0){
+      close(fd);
+    }
+    return -1;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+/**server_accept - SERVER ACCEPT
+  * Accepts every pending connection as a new session.
+    * s. The server.
+*/
+static void server_accept(server* s){
+  for(;;){
+    int fd = accept(s->listener, NULL, NULL);
+    if(fd < 0){
+      return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    if(s->session_count == s->session_capacity){
+      s->session_capacity = s->session_capacity == 0 ? 16 : s->session_capacity * 2;
+      s->sessions = realloc(s->sessions, s->session_capacity * sizeof(session*));
+    }
+    s->sessions[s->session_count++] = session_alloc(s->esn, fd);
+  }
+}
+
+/**main - ESN SERVER
+  * Serves a model file written by esn_save. Usage: esn_server <model file> <socket path>. The model is opened with esn_mmap, so any number of servers of the
+  * same file share its weights. Each connection is a session with its own resevoir state, starting from zeros; see server_protocol.h for the frames.
+  * SIGINT or SIGTERM stops the server and removes the socket.
+*/
+int main(int argc, char** argv){
+  if(argc != 3){
+    printf("usage: %s <model file> <socket path>\n", argv[0]);
+    return 1;
+  }
+  server s;
+  s.esn = esn_mmap(argv[1]);
+  if(s.esn == NULL){
+    return 1;
+  }
+  s.swaps = 0;
+  s.sessions = NULL;
+  s.session_count = 0;
+  s.session_capacity = 0;
+  s.listener = server_listen(argv[2]);
+  if(s.listener < 0){
+    free_esn(s.esn);
+    return 1;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, server_signal);
+  signal(SIGTERM, server_signal);
+  printf("esn_server: serving %s (%d inputs, %d outputs, %d nodes) on %s\n", argv[1], s.esn->inputs, s.esn->outputs, s.esn->nodes, argv[2]);
+  fflush(stdout);
+
+  struct pollfd* fds = NULL;
+  int fds_capacity = 0;
+  while(!server_stop){
+    if(fds_capacity < s.session_count + 1){
+      fds_capacity = 2 * (s.session_count + 1);
+      fds = realloc(fds, fds_capacity * sizeof(struct pollfd));
+    }
+    fds[0].fd = s.listener;
+    fds[0].events = POLLIN;
+    for(int i = 0; i < s.session_count; i++){
+      session* c = s.sessions[i];
+      fds[i + 1].fd = c->fd;
+      fds[i + 1].events = (c->out_length - c->out_start < SERVER_OUT_LIMIT ? POLLIN : 0) | (c->out_start < c->out_length ? POLLOUT : 0);
+    }
+    int polled = s.session_count;
+    if(poll(fds, polled + 1, -1) < 0){
+      continue;
+    }
+
+    for(int i = polled - 1; i >= 0; i--){
+      session* c = s.sessions[i];
+      short events = fds[i + 1].revents;
+      bool failed = (events & POLLIN) != 0 && session_read(c) != 0;
+      failed = failed || ((events & (POLLERR | POLLNVAL)) != 0) || ((events & POLLHUP) != 0 && (events & POLLIN) == 0);
+      /* flush first so frames held back by SERVER_OUT_LIMIT are answered as soon as the client drains its replies */
+      failed = failed || session_flush(c) != 0;
+      failed = failed || session_dispatch(&s, c) != 0 || session_flush(c) != 0;
+      if(failed){
+        session_free(c);
+        s.sessions[i] = s.sessions[--s.session_count];
+      }
+    }
+    if(fds[0].revents & POLLIN){
+      server_accept(&s);
+    }
+  }
+
+  for(int i = 0; i < s.session_count; i++){
+    session_free(s.sessions[i]);
+  }
+  free(s.sessions);
+  free(fds);
+  close(s.listener);
+  unlink(argv[2]);
+  free_esn(s.esn);
+  return 0;
+}
@@ -0,0 +1,116 @@
+#include "server_protocol.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**server_connect - SERVER CONNECT
+  * Connects to a server's Unix domain socket. Returns the connected descriptor, or -1 (after printing why).
+    * path. The socket path.
+*/
+int server_connect(const char* path){
+  struct sockaddr_un address;
+  if(strlen(path) >= sizeof(address.sun_path)){
+    printf("server_connect: socket path %s is too long.\n", path);
+    return -1;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(fd < 0){
+    printf("server_connect: could not create a socket.\n");
+    return -1;
+  }
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path);
+  if(connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0){
+    printf("server_connect: could not connect to %s.\n", path);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**server_send - SERVER SEND
+  * Writes a frame to a blocking descriptor with a single system call where possible. Returns 0, or -1 if the connection failed.
+    * fd. The descriptor.
+    * type. The frame type.
+    * id. The frame id.
+    * count. The frame count.
+    * payload. The payload, or NULL if length is 0.
+    * length. The length of the payload in bytes.
+*/
+int server_send(int fd, uint32_t type, uint32_t id, uint32_t count, const void* payload, uint32_t length){
+  server_frame frame = {type, id, count, length};
+  struct iovec parts[2];
+  parts[0].iov_base = &frame;
+  parts[0].iov_len = sizeof(frame);
+  parts[1].iov_base = (void*)payload;
+  parts[1].iov_len = length;
+  int part = 0;
+  while(part < 2){
+    ssize_t written = writev(fd, parts + part, 2 - part);
+    if(written < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      return -1;
+    }
+    while(part < 2 && (size_t)written >= parts[part].iov_len){
+      written -= parts[part].iov_len;
+      part++;
+    }
+    if(part < 2){
+      parts[part].iov_base = (char*)parts[part].iov_base + written;
+      parts[part].iov_len -= written;
+    }
+  }
+  return 0;
+}
+
+/**server_read_all - SERVER READ ALL
+  * Reads exactly bytes bytes from a blocking descriptor. Returns 0, or -1 if the connection closed or failed first.
+    * fd. The descriptor.
+    * data. Where to read to.
+    * bytes. The number of bytes to read.
+*/
+static int server_read_all(int fd, void* data, size_t bytes){
+  size_t done = 0;
+  while(done < bytes){
+    ssize_t got = read(fd, (char*)data + done, bytes - done);
+    if(got < 0 && errno == EINTR){
+      continue;
+    }
+    if(got <= 0){
+      return -1;
+    }
+    done += got;
+  }
+  return 0;
+}
+
+/**server_recv - SERVER RECV
+  * Reads one frame from a blocking descriptor. The payload is read into *payload, which is grown with realloc as needed. Returns 0, or -1 if the connection
+  * closed or failed or the frame was larger than SERVER_MAX_PAYLOAD.
+    * fd. The descriptor.
+    * frame. Set to the frame's header.
+    * payload. A buffer from malloc (or NULL) of *capacity bytes, replaced if it is grown.
+    * capacity. The size of *payload, updated.
+*/
+int server_recv(int fd, server_frame* frame, void** payload, size_t* capacity){
+  if(server_read_all(fd, frame, sizeof(server_frame)) != 0 || frame->length > SERVER_MAX_PAYLOAD){
+    return -1;
+  }
+  if(frame->length > *capacity){
+    void* grown = realloc(*payload, frame->length);
+    if(grown == NULL){
+      return -1;
+    }
+    *payload = grown;
+    *capacity = frame->length;
+  }
+  return server_read_all(fd, *payload, frame->length);
+}
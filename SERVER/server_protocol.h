@@ -0,0 +1,73 @@
+#ifndef SP_H
+#define SP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** SERVER_STEP, SERVER_RESET, SERVER_SWAP, SERVER_INFO, SERVER_OUTPUT, SERVER_OK, SERVER_ERROR
+  * Frame types. Every frame is a server_frame header followed by length bytes of payload, in native byte order. Requests are answered in the order they
+  * arrive on a connection, so a client may pipeline any number of them and match replies by order or by id.
+  * SERVER_STEP - count steps of input, count x inputs doubles (no bias). Steps the session's state through them in order and replies SERVER_OUTPUT.
+  *   Rejected with SERVER_ERROR if the count x outputs doubles of the reply would exceed SERVER_MAX_PAYLOAD.
+  * SERVER_RESET - no payload. Zeros the session's state and replies SERVER_OK.
+  * SERVER_SWAP - a new wOut, outputs x (1 + inputs + nodes) doubles row major. Replaces wOut for every session between two steps and replies SERVER_OK.
+  * SERVER_INFO - no payload. Replies SERVER_INFO with four uint32s: inputs, outputs, nodes and the number of swaps so far.
+  * SERVER_OUTPUT - the reply to SERVER_STEP, count x outputs doubles, the readout wOut.[1; u; x] after each step.
+  * SERVER_OK - an empty acknowledgement.
+  * SERVER_ERROR - a message (not NUL terminated) saying why a request was rejected. The session's state is unchanged.
+*/
+static const uint32_t SERVER_STEP = 1;
+static const uint32_t SERVER_RESET = 2;
+static const uint32_t SERVER_SWAP = 3;
+static const uint32_t SERVER_INFO = 4;
+static const uint32_t SERVER_OUTPUT = 5;
+static const uint32_t SERVER_OK = 6;
+static const uint32_t SERVER_ERROR = 7;
+
+/** SERVER_MAX_PAYLOAD
+  * The largest payload the server accepts. A connection sending a larger frame is closed.
+*/
+static const uint32_t SERVER_MAX_PAYLOAD = 64u << 20;
+
+/** STRUCT server_frame - SERVER FRAME
+  * The header of every frame.
+    * type. One of the frame types above.
+    * id. Chosen by the client and echoed in the reply.
+    * count. The number of steps in a SERVER_STEP or SERVER_OUTPUT frame, otherwise 0.
+    * length. The length of the payload that follows, in bytes.
+*/
+typedef struct server_frame{
+  uint32_t type;
+  uint32_t id;
+  uint32_t count;
+  uint32_t length;
+} server_frame;
+
+/**server_connect - SERVER CONNECT
+  * Connects to a server's Unix domain socket. Returns the connected descriptor, or -1 (after printing why).
+    * path. The socket path.
+*/
+int server_connect(const char* path);
+
+/**server_send - SERVER SEND
+  * Writes a frame to a blocking descriptor with a single system call where possible. Returns 0, or -1 if the connection failed.
+    * fd. The descriptor.
+    * type. The frame type.
+    * id. The frame id.
+    * count. The frame count.
+    * payload. The payload, or NULL if length is 0.
+    * length. The length of the payload in bytes.
+*/
+int server_send(int fd, uint32_t type, uint32_t id, uint32_t count, const void* payload, uint32_t length);
+
+/**server_recv - SERVER RECV
+  * Reads one frame from a blocking descriptor. The payload is read into *payload, which is grown with realloc as needed. Returns 0, or -1 if the connection
+  * closed or failed or the frame was larger than SERVER_MAX_PAYLOAD.
+    * fd. The descriptor.
+    * frame. Set to the frame's header.
+    * payload. A buffer from malloc (or NULL) of *capacity bytes, replaced if it is grown.
+    * capacity. The size of *payload, updated.
+*/
+int server_recv(int fd, server_frame* frame, void** payload, size_t* capacity);
+
+#endif
@@ -0,0 +1,157 @@
+#include "activation.h"
+#include "esn.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ACTIVATION_X86 1
+#include <immintrin.h>
+#endif
+
+/* The numerator (odd, x.P(x^2)) and denominator (Q(x^2)) coefficients of activation_fast_tanh, lowest order first. */
+#define TANH_P1 4.89352455891786e-03
+#define TANH_P3 6.37261928875436e-04
+#define TANH_P5 1.48572235717979e-05
+#define TANH_P7 5.12229709037114e-08
+#define TANH_P9 -8.60467152213735e-11
+#define TANH_P11 2.00018790482477e-13
+#define TANH_P13 -2.76076847742355e-16
+#define TANH_Q0 4.89352518554385e-03
+#define TANH_Q2 2.26843463243900e-03
+#define TANH_Q4 1.18534705686654e-04
+#define TANH_Q6 1.19825839466702e-06
+
+/**activation_fast_tanh - ACTIVATION FAST TANH
+  * A rational approximation to tanh, x.P(x^2) / Q(x^2) with P of degree 6 and Q of degree 3, evaluated on x clamped to ACTIVATION_FAST_CLAMP. It has no
+  * branches or libm calls, so it vectorizes; the error is at most ACTIVATION_FAST_MAX_ERROR and the result is odd and within [-1, 1].
+    * x. The argument.
+*/
+double activation_fast_tanh(double x){
+  x = fmin(fmax(x, -ACTIVATION_FAST_CLAMP), ACTIVATION_FAST_CLAMP);
+  double x2 = x * x;
+  double p = TANH_P13;
+  p = p * x2 + TANH_P11;
+  p = p * x2 + TANH_P9;
+  p = p * x2 + TANH_P7;
+  p = p * x2 + TANH_P5;
+  p = p * x2 + TANH_P3;
+  p = p * x2 + TANH_P1;
+  double q = TANH_Q6;
+  q = q * x2 + TANH_Q4;
+  q = q * x2 + TANH_Q2;
+  q = q * x2 + TANH_Q0;
+  return (x * p) / q;
+}
+
+/**activation_fast_scalar - ACTIVATION FAST SCALAR
+  * The portable ESN_TANH_FAST kernel, an activation_kernel using activation_fast_tanh.
+    * leak_rate. The leak rate.
+    * prev. The previous states.
+    * pre. The pre-activations, overwritten with the new states.
+    * n. The number of entries in prev and pre.
+*/
+void activation_fast_scalar(double leak_rate, const double* prev, double* pre, size_t n){
+  double keep = 1.0 - leak_rate;
+  for(size_t i = 0; i < n; i++){
+    pre[i] = (keep * prev[i]) + (leak_rate * activation_fast_tanh(pre[i]));
+  }
+}
+
+#ifdef ACTIVATION_X86
+
+/**activation_fast_avx2 - ACTIVATION FAST AVX2
+  * activation_fast_scalar four nodes at a time. The tail is finished by the scalar kernel.
+*/
+__attribute__((target("avx2,fma")))
+static void activation_fast_avx2(double leak_rate, const double* prev, double* pre, size_t n){
+  const __m256d keep = _mm256_set1_pd(1.0 - leak_rate);
+  const __m256d leak = _mm256_set1_pd(leak_rate);
+  const __m256d hi = _mm256_set1_pd(ACTIVATION_FAST_CLAMP);
+  const __m256d lo = _mm256_set1_pd(-ACTIVATION_FAST_CLAMP);
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4){
+    __m256d x = _mm256_min_pd(_mm256_max_pd(_mm256_loadu_pd(pre + i), lo), hi);
+    __m256d x2 = _mm256_mul_pd(x, x);
+    __m256d p = _mm256_fmadd_pd(_mm256_set1_pd(TANH_P13), x2, _mm256_set1_pd(TANH_P11));
+    p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(TANH_P9));
+    p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(TANH_P7));
+    p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(TANH_P5));
+    p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(TANH_P3));
+    p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(TANH_P1));
+    __m256d q = _mm256_fmadd_pd(_mm256_set1_pd(TANH_Q6), x2, _mm256_set1_pd(TANH_Q4));
+    q = _mm256_fmadd_pd(q, x2, _mm256_set1_pd(TANH_Q2));
+    q = _mm256_fmadd_pd(q, x2, _mm256_set1_pd(TANH_Q0));
+    __m256d t = _mm256_div_pd(_mm256_mul_pd(x, p), q);
+    _mm256_storeu_pd(pre + i, _mm256_fmadd_pd(leak, t, _mm256_mul_pd(keep, _mm256_loadu_pd(prev + i))));
+  }
+  activation_fast_scalar(leak_rate, prev + i, pre + i, n - i);
+}
+
+/**activation_fast_avx512 - ACTIVATION FAST AVX512
+  * activation_fast_scalar eight nodes at a time, with the tail handled by a masked load and store.
+*/
+__attribute__((target("avx512f")))
+static void activation_fast_avx512(double leak_rate, const double* prev, double* pre, size_t n){
+  const __m512d keep = _mm512_set1_pd(1.0 - leak_rate);
+  const __m512d leak = _mm512_set1_pd(leak_rate);
+  const __m512d hi = _mm512_set1_pd(ACTIVATION_FAST_CLAMP);
+  const __m512d lo = _mm512_set1_pd(-ACTIVATION_FAST_CLAMP);
+  for(size_t i = 0; i < n; i += 8){
+    __mmask8 mask = n - i >= 8 ? 0xFF : (__mmask8)((1u << (n - i)) - 1);
+    __m512d x = _mm512_min_pd(_mm512_max_pd(_mm512_maskz_loadu_pd(mask, pre + i), lo), hi);
+    __m512d x2 = _mm512_mul_pd(x, x);
+    __m512d p = _mm512_fmadd_pd(_mm512_set1_pd(TANH_P13), x2, _mm512_set1_pd(TANH_P11));
+    p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(TANH_P9));
+    p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(TANH_P7));
+    p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(TANH_P5));
+    p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(TANH_P3));
+    p = _mm512_fmadd_pd(p, x2, _mm512_set1_pd(TANH_P1));
+    __m512d q = _mm512_fmadd_pd(_mm512_set1_pd(TANH_Q6), x2, _mm512_set1_pd(TANH_Q4));
+    q = _mm512_fmadd_pd(q, x2, _mm512_set1_pd(TANH_Q2));
+    q = _mm512_fmadd_pd(q, x2, _mm512_set1_pd(TANH_Q0));
+    __m512d t = _mm512_div_pd(_mm512_mul_pd(x, p), q);
+    __m512d out = _mm512_fmadd_pd(leak, t, _mm512_mul_pd(keep, _mm512_maskz_loadu_pd(mask, prev + i)));
+    _mm512_mask_storeu_pd(pre + i, mask, out);
+  }
+}
+
+#endif
+
+/**activation_select - ACTIVATION SELECT
+  * Returns the kernel for a tanh mode. ESN_TANH_EXACT always gives the scalar libm kernel (esn_activate). ESN_TANH_FAST gives the AVX-512 kernel if the CPU
+  * supports AVX-512F, else the AVX2 kernel if it supports AVX2 and FMA, else the scalar kernel. All fast kernels agree to within rounding.
+    * tanh_mode. ESN_TANH_EXACT or ESN_TANH_FAST.
+*/
+activation_kernel activation_select(int tanh_mode){
+  if(tanh_mode != ESN_TANH_FAST){
+    return esn_activate;
+  }
+#ifdef ACTIVATION_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx512f")){
+    return activation_fast_avx512;
+  }
+  if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+    return activation_fast_avx2;
+  }
+#endif
+  return activation_fast_scalar;
+}
+
+/**activation_name - ACTIVATION NAME
+  * Returns the name of the kernel activation_select gives for a tanh mode: "exact", "avx512", "avx2" or "scalar".
+    * tanh_mode. ESN_TANH_EXACT or ESN_TANH_FAST.
+*/
+const char* activation_name(int tanh_mode){
+  activation_kernel kernel = activation_select(tanh_mode);
+  if(kernel == esn_activate){
+    return "exact";
+  }
+#ifdef ACTIVATION_X86
+  if(kernel == activation_fast_avx512){
+    return "avx512";
+  }
+  if(kernel == activation_fast_avx2){
+    return "avx2";
+  }
+#endif
+  return "scalar";
+}
@@ -0,0 +1,56 @@
+#ifndef ACT_H
+#define ACT_H
+
+#include <stddef.h>
+#include <math.h>
+
+/** ESN_TANH_EXACT, ESN_TANH_FAST
+  * Activation modes for esn_set_tanh. ESN_TANH_EXACT - libm tanh, applied one node at a time. ESN_TANH_FAST - activation_fast_tanh, applied with the widest
+  * vector kernel the CPU supports (AVX-512, AVX2 or scalar).
+*/
+static const int ESN_TANH_EXACT = 0;
+static const int ESN_TANH_FAST = 1;
+
+/** ACTIVATION_FAST_CLAMP, ACTIVATION_FAST_MAX_ERROR
+  * activation_fast_tanh clamps its argument to [-ACTIVATION_FAST_CLAMP, ACTIVATION_FAST_CLAMP], beyond which tanh rounds to +-1 in single precision.
+  * ACTIVATION_FAST_MAX_ERROR bounds |activation_fast_tanh(x) - tanh(x)| over every double x (measured on a 1e-6 grid over [-10, 10]). The largest error is
+  * at the clamp, 1 - tanh(ACTIVATION_FAST_CLAMP); inside the clamp it is below 3e-8.
+*/
+static const double ACTIVATION_FAST_CLAMP = 7.90531110763549805;
+static const double ACTIVATION_FAST_MAX_ERROR = 3e-7;
+
+/**activation_kernel - ACTIVATION KERNEL
+  * A fused leaky tanh pass over contiguous arrays, pre[i] = (1 - leak_rate) * prev[i] + leak_rate * tanh(pre[i]). See esn_activate.
+*/
+typedef void (*activation_kernel)(double leak_rate, const double* prev, double* pre, size_t n);
+
+/**activation_fast_tanh - ACTIVATION FAST TANH
+  * A rational approximation to tanh, x.P(x^2) / Q(x^2) with P of degree 6 and Q of degree 3, evaluated on x clamped to ACTIVATION_FAST_CLAMP. It has no
+  * branches or libm calls, so it vectorizes; the error is at most ACTIVATION_FAST_MAX_ERROR and the result is odd and within [-1, 1].
+    * x. The argument.
+*/
+double activation_fast_tanh(double x);
+
+/**activation_select - ACTIVATION SELECT
+  * Returns the kernel for a tanh mode. ESN_TANH_EXACT always gives the scalar libm kernel (esn_activate). ESN_TANH_FAST gives the AVX-512 kernel if the CPU
+  * supports AVX-512F, else the AVX2 kernel if it supports AVX2 and FMA, else the scalar kernel. All fast kernels agree to within rounding.
+    * tanh_mode. ESN_TANH_EXACT or ESN_TANH_FAST.
+*/
+activation_kernel activation_select(int tanh_mode);
+
+/**activation_name - ACTIVATION NAME
+  * Returns the name of the kernel activation_select gives for a tanh mode: "exact", "avx512", "avx2" or "scalar".
+    * tanh_mode. ESN_TANH_EXACT or ESN_TANH_FAST.
+*/
+const char* activation_name(int tanh_mode);
+
+/**activation_fast_scalar - ACTIVATION FAST SCALAR
+  * The portable ESN_TANH_FAST kernel, an activation_kernel using activation_fast_tanh.
+    * leak_rate. The leak rate.
+    * prev. The previous states.
+    * pre. The pre-activations, overwritten with the new states.
+    * n. The number of entries in prev and pre.
+*/
+void activation_fast_scalar(double leak_rate, const double* prev, double* pre, size_t n);
+
+#endif
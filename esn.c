@@ -1,17 +1,13 @@
 #include "esn.h"
 #include "train.h"
 #include "included_datasets.h"
+#include <sys/mman.h>
 
-/**empty_esn - EMPTY ESN
-  * Generates an ESN. All matrices are zero'd.
-    * inputs. The number of inputs the ESN will handle.
-    * outputs. The number of outputs the ESN will handle.
-    * nodes. The number of nodes the ESN resevoir has.
-    * leak_rate. The leak rate of the ESN.
-    * input_scale. The input scaling of the ESN.
-    * spectral_radius. The spectral radius of the ESN.
+/**esn_alloc - ESN ALLOC
+  * Allocates an ESN as empty_esn, without any resevoir: w, w_sparse and w_topology are NULL.
+    * inputs, outputs, nodes, leak_rate, input_scale, spectral_radius. As empty_esn.
 */
-ESN* empty_esn(int inputs, int outputs, int nodes, double leak_rate, double input_scale, double spectral_radius){
+static ESN* esn_alloc(int inputs, int outputs, int nodes, double leak_rate, double input_scale, double spectral_radius){
   ESN* esn = malloc(sizeof(ESN));
   esn->inputs = inputs;
   esn->outputs = outputs;
@@ -20,9 +16,63 @@ ESN* empty_esn(int inputs, int outputs, int nodes, double leak_rate, double inpu
   esn->input_scale = input_scale;
   esn->spectral_radius = spectral_radius;
   esn->wIn = gsl_matrix_calloc(nodes, inputs + 1);
-  esn->w = gsl_matrix_calloc(nodes, nodes);
+  esn->w = NULL;
   esn->wOut = gsl_matrix_calloc(outputs, (1 + nodes + inputs));
   esn->state = gsl_matrix_calloc(nodes, 1);
+  esn->w_sparse = NULL;
+  esn->w_topology = NULL;
+  esn->state_next = gsl_matrix_calloc(nodes, 1);
+  esn->map = NULL;
+  esn->map_size = 0;
+  esn_set_tanh(esn, ESN_TANH_EXACT);
+  return esn;
+}
+
+/**empty_esn - EMPTY ESN
+  * Generates an ESN. All matrices are zero'd.
+    * inputs. The number of inputs the ESN will handle.
+    * outputs. The number of outputs the ESN will handle.
+    * nodes. The number of nodes the ESN resevoir has.
+    * leak_rate. The leak rate of the ESN.
+    * input_scale. The input scaling of the ESN.
+    * spectral_radius. The spectral radius of the ESN.
+*/
+ESN* empty_esn(int inputs, int outputs, int nodes, double leak_rate, double input_scale, double spectral_radius){
+  ESN* esn = esn_alloc(inputs, outputs, nodes, leak_rate, input_scale, spectral_radius);
+  esn->w = gsl_matrix_calloc(nodes, nodes);
+  return esn;
+}
+
+/**empty_sparse_esn - EMPTY SPARSE ESN
+  * Generates an ESN whose resevoir is held only in CSR form: w is NULL and w_sparse starts empty, so no [nodes x nodes] matrix is allocated. randomize_esn
+  * then draws the resevoir straight into w_sparse, in O(nnz) memory, whatever the density. wIn and wOut are zero'd. Use this for large sparse resevoirs;
+  * esn_use_sparse(esn, false) turns it into a dense ESN.
+    * inputs, outputs, nodes, leak_rate, input_scale, spectral_radius. As empty_esn.
+*/
+ESN* empty_sparse_esn(int inputs, int outputs, int nodes, double leak_rate, double input_scale, double spectral_radius){
+  ESN* esn = esn_alloc(inputs, outputs, nodes, leak_rate, input_scale, spectral_radius);
+  esn->w_sparse = csr_calloc(nodes, nodes);
+  return esn;
+}
+
+/**empty_structured_esn - EMPTY STRUCTURED ESN
+  * Generates an ESN with a structured resevoir, stored implicitly (see topology.h), so neither w nor any other [nodes x nodes] matrix is allocated and each
+  * step costs O(nodes). wIn and wOut are zero'd; randomize_esn fills wIn and leaves the resevoir as it is. The resevoir weights are scaled by spectral_radius,
+  * which is the resevoir's true spectral radius for TOPOLOGY_CYCLE and the weight of the line for TOPOLOGY_DELAY (whose spectral radius is 0); for
+  * TOPOLOGY_JUMPS the cycle and jump weights are spectral_radius and spectral_radius * jump_weight. Returns NULL (after printing why) if the topology is invalid.
+    * inputs, outputs, nodes, leak_rate, input_scale, spectral_radius. As empty_esn.
+    * kind. TOPOLOGY_CYCLE, TOPOLOGY_DELAY or TOPOLOGY_JUMPS.
+    * jump. For TOPOLOGY_JUMPS, the distance between the nodes joined by jumps. Otherwise ignored.
+    * jump_weight. For TOPOLOGY_JUMPS, the weight of each jump relative to the cycle's. Otherwise ignored.
+*/
+ESN* empty_structured_esn(int inputs, int outputs, int nodes, double leak_rate, double input_scale, double spectral_radius, int kind, int jump,
+  double jump_weight){
+  topology* t = topology_alloc(kind, nodes, jump, jump_weight);
+  if(t == NULL){
+    return NULL;
+  }
+  ESN* esn = esn_alloc(inputs, outputs, nodes, leak_rate, input_scale, spectral_radius);
+  esn->w_topology = t;
   return esn;
 }
 
@@ -45,7 +95,19 @@ void print_esn_full(ESN* esn){
   printf("\n wIn \n\n");
   print_matrix(esn->wIn);
   printf("\n w \n\n");
-  print_matrix(esn->w);
+  if(esn->w_topology != NULL){
+    gsl_matrix* w = topology_to_gsl_matrix(esn->w_topology);
+    print_matrix(w);
+    gsl_matrix_free(w);
+  }
+  else if(esn->w == NULL){
+    gsl_matrix* w = csr_to_gsl_matrix(esn->w_sparse);
+    print_matrix(w);
+    gsl_matrix_free(w);
+  }
+  else{
+    print_matrix(esn->w);
+  }
   printf("\n wOut \n\n");
   print_matrix(esn->wOut);
   printf("\n Current state \n\n");
@@ -53,14 +115,26 @@ void print_esn_full(ESN* esn){
 }
 
 /**free_esn - FREE ESN
-  * Frees an ESN including its various gsl_matrix weights.
+  * Frees an ESN including its various gsl_matrix weights, unmapping them if the ESN was opened with esn_mmap.
     * esn - The ESN to free.
 */
 void free_esn(ESN* esn){
   gsl_matrix_free(esn->wIn);
-  gsl_matrix_free(esn->w);
+  if(esn->w != NULL){
+    gsl_matrix_free(esn->w);
+  }
   gsl_matrix_free(esn->wOut);
   gsl_matrix_free(esn->state);
+  gsl_matrix_free(esn->state_next);
+  if(esn->w_sparse != NULL){
+    csr_free(esn->w_sparse);
+  }
+  if(esn->w_topology != NULL){
+    topology_free(esn->w_topology);
+  }
+  if(esn->map != NULL){
+    munmap(esn->map, esn->map_size);
+  }
   free(esn);
 }
 
@@ -71,51 +145,249 @@ void free_esn(ESN* esn){
   * x'(t - 1) is the old state at time t
     * esn. The ESN to update.
     * uN. The inputs to the ESN to update. uN is assumed to be prefaced with the bias e.g. [1; inputs]
+  * This is a wrapper for step_esn and makes no allocations.
 */
 void update_esn(ESN* esn, gsl_matrix* uN){
-  gsl_matrix* new_state = gsl_matrix_multiply(esn->wIn, uN);
-  gsl_matrix_scale(new_state, esn->input_scale);
-  gsl_matrix* res_state = gsl_matrix_multiply(esn->w, esn->state);
-  gsl_matrix_scale(res_state, esn->spectral_radius);
-  gsl_matrix_add(new_state, res_state);
+  gsl_vector_const_view uN_v = gsl_matrix_const_column(uN, 0);
+  step_esn(esn, &uN_v.vector);
+}
+
+/**step_esn - STEP ESN
+  * Steps an ESN along according to input uN, as update_esn, without any heap allocation. The new state is written into esn->state_next, which is then swapped
+  * with esn->state, so any pointer to the old esn->state now refers to the scratch buffer.
+    * esn. The ESN to update.
+    * uN. The inputs to the ESN to update, of length inputs + 1. uN is assumed to be prefaced with the bias e.g. [1; inputs]
+*/
+void step_esn(ESN* esn, const gsl_vector* uN){
+  gsl_vector_const_view state_v = gsl_matrix_const_column(esn->state, 0);
+  gsl_vector_view next_v = gsl_matrix_column(esn->state_next, 0);
+  esn_step_into(esn, uN, &state_v.vector, &next_v.vector);
+  gsl_matrix* old_state = esn->state;
+  esn->state = esn->state_next;
+  esn->state_next = old_state;
+}
+
+/**esn_step_into - ESN STEP INTO
+  * Computes the state which follows state under input uN, x'(t) = (1 - leak_rate) * state + leak_rate * tanh((wIn * input_scale).uN + (w * spectral_radius).state),
+  * and writes it to next. The ESN itself is not modified, so several states may be stepped against the same weights. Makes no allocations.
+    * esn. The ESN whose weights to use.
+    * uN. The inputs, of length inputs + 1, prefaced with the bias e.g. [1; inputs].
+    * state. The current state, of length nodes.
+    * next. The vector to write the next state to, of length nodes. Must not overlap state.
+*/
+void esn_step_into(const ESN* esn, const gsl_vector* uN, const gsl_vector* state, gsl_vector* next){
+  PROFILE_BEGIN(PROFILE_STEP);
+  gsl_blas_dgemv(CblasNoTrans, esn->input_scale, esn->wIn, uN, 0.0, next);
+  if(esn->w_topology != NULL){
+    topology_mv(esn->w_topology, esn->spectral_radius, state, 1.0, next);
+  }
+  else if(esn->w_sparse != NULL){
+    csr_mv(esn->w_sparse, esn->spectral_radius, state, 1.0, next);
+  }
+  else{
+    gsl_blas_dgemv(CblasNoTrans, esn->spectral_radius, esn->w, state, 1.0, next);
+  }
+  if(next->stride == 1 && state->stride == 1){
+    esn->activate(esn->leak_rate, state->data, next->data, esn->nodes);
+  }
+  else{
+    double leak_rate = esn->leak_rate;
+    for(int i = 0; i < esn->nodes; i++){
+      double pre = gsl_vector_get(next, i);
+      double activation = esn->tanh_mode == ESN_TANH_FAST ? activation_fast_tanh(pre) : tanh(pre);
+      gsl_vector_set(next, i, ((1.0 - leak_rate) * gsl_vector_get(state, i)) + (leak_rate * activation));
+    }
+  }
+  PROFILE_END(PROFILE_STEP, 2.0 * ((esn->nodes * (esn->inputs + 1.0))
+    + (esn->w_topology != NULL ? topology_nnz(esn->w_topology) : esn->w_sparse != NULL ? esn->w_sparse->nnz : (double)esn->nodes * esn->nodes)), 0);
+}
+
+/**esn_activate - ESN ACTIVATE
+  * Applies the leaky tanh activation in a single pass over contiguous arrays, pre[i] = (1 - leak_rate) * prev[i] + leak_rate * tanh(pre[i]).
+    * leak_rate. The leak rate.
+    * prev. The previous states.
+    * pre. The pre-activations (resevoir and input contributions), overwritten with the new states.
+    * n. The number of entries in prev and pre.
+*/
+void esn_activate(double leak_rate, const double* prev, double* pre, size_t n){
+  for(size_t i = 0; i < n; i++){
+    pre[i] = ((1.0 - leak_rate) * prev[i]) + (leak_rate * tanh(pre[i]));
+  }
+}
+
+/**esn_set_tanh - ESN SET TANH
+  * Selects the tanh an ESN's updates use. ESN_TANH_FAST replaces libm tanh with activation_fast_tanh in a vectorized kernel, changing each state by at most
+  * ACTIVATION_FAST_MAX_ERROR per step. Retrain wOut after switching.
+    * esn. The esn to modify.
+    * tanh_mode. ESN_TANH_EXACT or ESN_TANH_FAST.
+*/
+void esn_set_tanh(ESN* esn, int tanh_mode){
+  esn->tanh_mode = tanh_mode == ESN_TANH_FAST ? ESN_TANH_FAST : ESN_TANH_EXACT;
+  esn->activate = activation_select(esn->tanh_mode);
+}
+
+/**esn_select_resevoir - ESN SELECT RESEVOIR
+  * Switches an ESN with a dense w to its sparse resevoir if at most ESN_SPARSE_DENSITY of w is nonzero, and to its dense resevoir otherwise.
+    * esn. The esn to modify.
+*/
+static void esn_select_resevoir(ESN* esn){
+  esn_use_sparse(esn, true);
+  if(csr_density(esn->w_sparse) > ESN_SPARSE_DENSITY){
+    esn_use_sparse(esn, false);
+  }
+}
+
+/**esn_fill_sparse - ESN FILL SPARSE
+  * Replaces the w_sparse of an ESN from empty_sparse_esn with a newly drawn one, built row by row straight from the draws so that no [nodes x nodes] matrix is allocated and the
+  * cost is O(nodes^2) draws but only O(nnz) memory. The weights are those the dense fill would draw from the same stream.
+    * esn. The esn to modify.
+    * density. The probability of each weight being present.
+    * rng. The stream to draw from.
+    * draws. Scratch for 2 x nodes draws.
+*/
+static void esn_fill_sparse(ESN* esn, double density, rand_stream* rng, double* draws){
+  int nodes = esn->nodes;
+  csr_free(esn->w_sparse);
+  csr_matrix* a = csr_calloc(nodes, nodes);
+  size_t capacity = (size_t)(1.25 * density * nodes * nodes) + nodes;
+  a->col_idx = realloc(a->col_idx, capacity * sizeof(int));
+  a->values = realloc(a->values, capacity * sizeof(double));
+  for(int i = 0; i < nodes; i++){
+    rand_stream_fill(rng, draws, 2 * nodes);
+    a->row_ptr[i] = a->nnz;
+    for(int j = 0; j < nodes; j++){
+      double v = (draws[j] < density) ? (-0.5 + draws[nodes + j]) : 0.0;
+      if(v == 0.0){
+        continue;
+      }
+      if((size_t)a->nnz == capacity){
+        capacity *= 2;
+        a->col_idx = realloc(a->col_idx, capacity * sizeof(int));
+        a->values = realloc(a->values, capacity * sizeof(double));
+      }
+      a->col_idx[a->nnz] = j;
+      a->values[a->nnz] = v;
+      a->nnz++;
+    }
+  }
+  a->row_ptr[nodes] = a->nnz;
+  esn->w_sparse = a;
+}
+
+/**esn_fill_dense - ESN FILL DENSE
+  * Fills an ESN's dense w with newly drawn weights, one bulk rand_stream_fill per row.
+    * esn. The esn to modify.
+    * density. The probability of each weight being present.
+    * rng. The stream to draw from.
+    * draws. Scratch for 2 x nodes draws.
+*/
+static void esn_fill_dense(ESN* esn, double density, rand_stream* rng, double* draws){
   for(int i = 0; i < esn->nodes; i++){
-    gsl_matrix_set(new_state, i, 0, tanh(gsl_matrix_get(new_state, i, 0)));
+    rand_stream_fill(rng, draws, 2 * esn->nodes);
+    double* row = gsl_matrix_ptr(esn->w, i, 0);
+    for(int j = 0; j < esn->nodes; j++){
+      row[j] = (draws[j] < density) ? (-0.5 + draws[esn->nodes + j]) : 0.0;
+    }
   }
-  gsl_matrix_scale(esn->state, 1.0 - esn->leak_rate);
-  gsl_matrix_scale(new_state, esn->leak_rate);
-  gsl_matrix_add(new_state, esn->state);
-  gsl_matrix_free(esn->state);
-  gsl_matrix_free(res_state);
-  esn->state = new_state;
 }
 
 /**randomize_esn - RANDOMIZE ESN
   * Randomizes an ESN's weight matrices. Input weights (wIn) are uniformally chosen from the interval [-1, 1]. Resevoir weights (w) occur with probability (density) and
-  * are uniformally chosen from the interval [-0.5, 0.5]. The resevoir weights (w) are then scaled by their (1 / maximum eigenvalue).
+  * are uniformally chosen from the interval [-0.5, 0.5]. The resevoir weights (w) are then scaled by (1 / their spectral radius). If at most ESN_SPARSE_DENSITY
+  * of the resevoir weights are nonzero, the ESN is switched to its sparse resevoir (see esn_use_sparse), otherwise to its dense resevoir. An ESN from
+  * empty_sparse_esn has its resevoir drawn straight into w_sparse instead, so no [nodes x nodes] matrix is allocated. An ESN with a structured resevoir
+  * (w_topology) only has wIn randomized.
+  * This is a wrapper for randomize_esn_rng using a stream seeded from C's inbuilt RNG.
     * esn. The esn to randomize
     * density. How sparse the esn should be.
 */
 void randomize_esn(ESN* esn, double density){
+  rand_stream rng;
+  rand_stream_from_rand(&rng);
+  randomize_esn_rng(esn, density, &rng);
+}
+
+/**randomize_esn_rng - RANDOMIZE ESN RNG
+  * Randomizes an ESN's weight matrices as randomize_esn, drawing every weight from an explicit rand_stream. The weights are a pure function of the stream's
+  * (seed, stream id) and position, so an ESN can be regenerated bit-exactly from them on any thread. Each row is filled with one bulk rand_stream_fill.
+    * esn. The esn to randomize
+    * density. How sparse the esn should be.
+    * rng. The stream to draw from.
+*/
+void randomize_esn_rng(ESN* esn, double density, rand_stream* rng){
+  PROFILE_BEGIN(PROFILE_RANDOMIZE);
   for(int i = 0; i < esn->nodes; i++){
-    for(int j = 0; j < esn->inputs + 1; j++){
-      gsl_matrix_set(esn->wIn, i, j, rand_range(-1.0, 1.0));
-    }
+    rand_stream_fill_range(rng, gsl_matrix_ptr(esn->wIn, i, 0), esn->inputs + 1, -1.0, 1.0);
   }
-  bool first = true;
-  if(density != 0.0){
-    while(first || gsl_matrix_max_eigenvalue(esn->w) == 0.0){
-      first = false;
-      for(int i = 0; i < esn->nodes; i++){
-        for(int j = 0; j < esn->nodes; j++){
-          if(rand_bool(density)){
-            gsl_matrix_set(esn->w, i, j, rand_range(-0.5, 0.5));
-          }
-          else{
-            gsl_matrix_set(esn->w, i, j, 0);
-          }
-        }
+  double radius = 0.0;
+  if(esn->w_topology == NULL && density != 0.0){
+    double* draws = malloc(2 * esn->nodes * sizeof(double));
+    while(radius == 0.0){
+      if(esn->w == NULL){
+        esn_fill_sparse(esn, density, rng, draws);
+      }
+      else{
+        esn_fill_dense(esn, density, rng, draws);
+        esn_select_resevoir(esn);
       }
+      radius = esn_spectral_radius(esn, SPECTRAL_RADIUS_TOL, SPECTRAL_RADIUS_MAX_ITER);
+    }
+    free(draws);
+    if(esn->w != NULL){
+      gsl_matrix_scale(esn->w, 1.0 / radius);
+    }
+    if(esn->w_sparse != NULL){
+      csr_scale(esn->w_sparse, 1.0 / radius);
+    }
+  }
+  else if(esn->w_topology == NULL && esn->w != NULL){
+    esn_select_resevoir(esn);
+  }
+  PROFILE_END(PROFILE_RANDOMIZE, 0, esn->w_sparse != NULL ? (size_t)esn->w_sparse->nnz * (sizeof(double) + sizeof(int)) : 0);
+}
+
+/**esn_use_sparse - ESN USE SPARSE
+  * Selects how an ESN's resevoir weights are applied during updates. If the ESN has a dense w: if sparse is true, w is compressed into w_sparse (replacing
+  * any existing copy) and updates use the sparse kernel; if sparse is false, w_sparse is freed and updates use w. If the resevoir is held only in w_sparse
+  * (see empty_sparse_esn), sparse being false expands it into a dense w and frees w_sparse. Both produce the same states. Does nothing to an ESN with a
+  * structured resevoir.
+    * esn. The esn to modify.
+    * sparse. Whether to use the sparse resevoir.
+*/
+void esn_use_sparse(ESN* esn, bool sparse){
+  if(esn->w_topology != NULL){
+    return;
+  }
+  if(esn->w == NULL){
+    if(!sparse){
+      esn->w = csr_to_gsl_matrix(esn->w_sparse);
+      csr_free(esn->w_sparse);
+      esn->w_sparse = NULL;
     }
-    gsl_matrix_scale(esn->w, 1.0 / gsl_matrix_max_eigenvalue(esn->w));
+    return;
+  }
+  if(esn->w_sparse != NULL){
+    csr_free(esn->w_sparse);
+    esn->w_sparse = NULL;
+  }
+  if(sparse){
+    esn->w_sparse = csr_from_gsl_matrix(esn->w);
+  }
+}
+
+/**esn_spectral_radius - ESN SPECTRAL RADIUS
+  * Estimates the spectral radius of an ESN's (unscaled) resevoir weights by restarted Arnoldi iteration, using w_sparse when present so that each
+  * iteration costs O(nnz), or of its structured resevoir by topology_spectral_radius. See spectral_radius_arnoldi.
+    * esn. The esn to measure.
+    * tol. The relative tolerance, e.g. SPECTRAL_RADIUS_TOL.
+    * max_iter. The maximum number of matrix-vector products, e.g. SPECTRAL_RADIUS_MAX_ITER.
+*/
+double esn_spectral_radius(const ESN* esn, double tol, int max_iter){
+  if(esn->w_topology != NULL){
+    return topology_spectral_radius(esn->w_topology, tol, max_iter);
+  }
+  if(esn->w_sparse != NULL){
+    return csr_spectral_radius(esn->w_sparse, tol, max_iter);
   }
+  return gsl_matrix_spectral_radius(esn->w, tol, max_iter);
 }
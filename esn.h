@@ -6,21 +6,39 @@
 #include <gsl/gsl_vector.h>
 #include "matrix_util.h"
 #include "rand_util.h"
+#include "sparse_util.h"
+#include "topology.h"
+#include "activation.h"
+#include "profile.h"
 #include <time.h>
 
+/**ESN_SPARSE_DENSITY
+  * randomize_esn stores the resevoir weights (w) as a csr_matrix as well whenever at most this fraction of them are nonzero.
+*/
+static const double ESN_SPARSE_DENSITY = 0.1;
+
 /**STRUCT ESN
  * The ESN struct stores all of the information required to run an ESN. The components are:
   * inputs - The number of inputs the ESN has.
   * outputs - The number of outputs the ESN has.
   * nodes - The number of nodes in the ESN's resevoir.
   * wIn - A [nodes x (inputs + 1)] GSL Matrix describing the weights between the ESN's resevoir nodes and the ESN's inputs. The first weight is the node's bias.
-  * w - A [nodes x nodes] GSL Matrix describing the weights between the ESN's resevoir nodes.
+  * w - A [nodes x nodes] GSL Matrix describing the weights between the ESN's resevoir nodes, or NULL if the resevoir is held only in w_sparse (see
+    empty_sparse_esn) or is structured (w_topology).
   * wOut - A [outputs x (inputs + nodes + 1)] GSL Matrix describing the weights between the ESN's outputs and all other nodes. The first wieght is the output's bias,
     The next #input weights are the weights for the inputs and the final #nodes weights are the weights for the resevoir nodes.
   * leak_rate - The ESN's leak rate for updates.
   * input_scale - The ESN's input scaling for updates.
   * spectral_radius - The spectral radius of the esn
   * state - A #nodes long vector ([#nodes x 1] gsl_matrix) describing the current state of every node in the ESN resevoir.
+  * w_sparse - Either NULL or the resevoir weights in CSR form. When present, updates use it in place of w so that each step costs O(nnz) rather than
+    O(nodes^2). If w is not NULL it is a copy - call esn_use_sparse again after modifying w directly; otherwise it is the only copy of the resevoir.
+  * w_topology - Either NULL or the structured resevoir (see topology.h) used in place of w, which is then NULL, as is w_sparse. Each step costs O(nodes).
+  * state_next - A [#nodes x 1] gsl_matrix the next state is written into by step_esn before it is swapped with state. Its contents are scratch.
+  * map - Either NULL or the model file mapping that wIn, w, wOut and w_sparse point into, when the ESN was opened with esn_mmap (see esn_file.h).
+  * map_size - The length of map in bytes.
+  * tanh_mode - ESN_TANH_EXACT (the default) or ESN_TANH_FAST. Set with esn_set_tanh.
+  * activate - The activation_kernel for tanh_mode, chosen for the running CPU by activation_select.
 */
 typedef struct ESN{
   int inputs;
@@ -33,6 +51,13 @@ typedef struct ESN{
   double input_scale;
   double spectral_radius;
   gsl_matrix* state;
+  csr_matrix* w_sparse;
+  topology* w_topology;
+  gsl_matrix* state_next;
+  void* map;
+  size_t map_size;
+  int tanh_mode;
+  activation_kernel activate;
 } ESN;
 
 /**PRINT ESN
@@ -58,6 +83,27 @@ void print_esn_full(ESN* esn);
 */
 ESN* empty_esn(int inputs, int outputs, int nodes, double leak_rate, double input_scale, double spectral_radius);
 
+/**empty_sparse_esn - EMPTY SPARSE ESN
+  * Generates an ESN whose resevoir is held only in CSR form: w is NULL and w_sparse starts empty, so no [nodes x nodes] matrix is allocated. randomize_esn
+  * then draws the resevoir straight into w_sparse, in O(nnz) memory, whatever the density. wIn and wOut are zero'd. Use this for large sparse resevoirs;
+  * esn_use_sparse(esn, false) turns it into a dense ESN.
+    * inputs, outputs, nodes, leak_rate, input_scale, spectral_radius. As empty_esn.
+*/
+ESN* empty_sparse_esn(int inputs, int outputs, int nodes, double leak_rate, double input_scale, double spectral_radius);
+
+/**empty_structured_esn - EMPTY STRUCTURED ESN
+  * Generates an ESN with a structured resevoir, stored implicitly (see topology.h), so neither w nor any other [nodes x nodes] matrix is allocated and each
+  * step costs O(nodes). wIn and wOut are zero'd; randomize_esn fills wIn and leaves the resevoir as it is. The resevoir weights are scaled by spectral_radius,
+  * which is the resevoir's true spectral radius for TOPOLOGY_CYCLE and the weight of the line for TOPOLOGY_DELAY (whose spectral radius is 0); for
+  * TOPOLOGY_JUMPS the cycle and jump weights are spectral_radius and spectral_radius * jump_weight. Returns NULL (after printing why) if the topology is invalid.
+    * inputs, outputs, nodes, leak_rate, input_scale, spectral_radius. As empty_esn.
+    * kind. TOPOLOGY_CYCLE, TOPOLOGY_DELAY or TOPOLOGY_JUMPS.
+    * jump. For TOPOLOGY_JUMPS, the distance between the nodes joined by jumps. Otherwise ignored.
+    * jump_weight. For TOPOLOGY_JUMPS, the weight of each jump relative to the cycle's. Otherwise ignored.
+*/
+ESN* empty_structured_esn(int inputs, int outputs, int nodes, double leak_rate, double input_scale, double spectral_radius, int kind, int jump,
+  double jump_weight);
+
 /**update_esn - UPDATE ESN
   * Steps an ESN along according to input uN.
   * Update x(t) = tanh((wIn * input_scale).uN + w.x'(t - 1))
@@ -65,21 +111,88 @@ ESN* empty_esn(int inputs, int outputs, int nodes, double leak_rate, double inpu
   * x'(t - 1) is the old state at time t
     * esn. The ESN to update.
     * uN. The inputs to the ESN to update. uN is assumed to be prefaced with the bias e.g. [1; inputs]
+  * This is a wrapper for step_esn and makes no allocations.
 */
 void update_esn(ESN* esn, gsl_matrix* uN);
 
+/**step_esn - STEP ESN
+  * Steps an ESN along according to input uN, as update_esn, without any heap allocation. The new state is written into esn->state_next, which is then swapped
+  * with esn->state, so any pointer to the old esn->state now refers to the scratch buffer.
+    * esn. The ESN to update.
+    * uN. The inputs to the ESN to update, of length inputs + 1. uN is assumed to be prefaced with the bias e.g. [1; inputs]
+*/
+void step_esn(ESN* esn, const gsl_vector* uN);
+
+/**esn_step_into - ESN STEP INTO
+  * Computes the state which follows state under input uN, x'(t) = (1 - leak_rate) * state + leak_rate * tanh((wIn * input_scale).uN + (w * spectral_radius).state),
+  * and writes it to next. The ESN itself is not modified, so several states may be stepped against the same weights. Makes no allocations.
+    * esn. The ESN whose weights to use.
+    * uN. The inputs, of length inputs + 1, prefaced with the bias e.g. [1; inputs].
+    * state. The current state, of length nodes.
+    * next. The vector to write the next state to, of length nodes. Must not overlap state.
+*/
+void esn_step_into(const ESN* esn, const gsl_vector* uN, const gsl_vector* state, gsl_vector* next);
+
+/**esn_activate - ESN ACTIVATE
+  * Applies the leaky tanh activation in a single pass over contiguous arrays, pre[i] = (1 - leak_rate) * prev[i] + leak_rate * tanh(pre[i]).
+    * leak_rate. The leak rate.
+    * prev. The previous states.
+    * pre. The pre-activations (resevoir and input contributions), overwritten with the new states.
+    * n. The number of entries in prev and pre.
+*/
+void esn_activate(double leak_rate, const double* prev, double* pre, size_t n);
+
+/**esn_set_tanh - ESN SET TANH
+  * Selects the tanh an ESN's updates use. ESN_TANH_FAST replaces libm tanh with activation_fast_tanh in a vectorized kernel, changing each state by at most
+  * ACTIVATION_FAST_MAX_ERROR per step. Retrain wOut after switching.
+    * esn. The esn to modify.
+    * tanh_mode. ESN_TANH_EXACT or ESN_TANH_FAST.
+*/
+void esn_set_tanh(ESN* esn, int tanh_mode);
+
 /**free_esn - FREE ESN
-  * Frees an ESN including its various gsl_matrix weights.
+  * Frees an ESN including its various gsl_matrix weights, unmapping them if the ESN was opened with esn_mmap.
     * esn - The ESN to free.
 */
 void free_esn(ESN* esn);
 
 /**randomize_esn - RANDOMIZE ESN_H
   * Randomizes an ESN's weight matrices. Input weights (wIn) are uniformally chosen from the interval [-1, 1]. Resevoir weights (w) occur with probability (density) and
-  * are uniformally chosen from the interval [-0.5, 0.5].
+  * are uniformally chosen from the interval [-0.5, 0.5]. The resevoir weights are then scaled to a spectral radius of 1. If at most ESN_SPARSE_DENSITY of the resevoir weights are nonzero, the ESN is switched to its sparse
+  * resevoir (see esn_use_sparse), otherwise to its dense resevoir. An ESN from empty_sparse_esn has its resevoir drawn straight into w_sparse instead, so no
+  * [nodes x nodes] matrix is allocated. An ESN with a structured resevoir (w_topology) only has wIn randomized.
+  * This is a wrapper for randomize_esn_rng using a stream seeded from C's inbuilt RNG.
     * esn. The esn to randomize
     * density. How sparse the esn should be.
 */
 void randomize_esn(ESN* esn, double density);
 
+/**randomize_esn_rng - RANDOMIZE ESN RNG
+  * Randomizes an ESN's weight matrices as randomize_esn, drawing every weight from an explicit rand_stream. The weights are a pure function of the stream's
+  * (seed, stream id) and position, so an ESN can be regenerated bit-exactly from them on any thread. Each row is filled with one bulk rand_stream_fill.
+    * esn. The esn to randomize
+    * density. How sparse the esn should be.
+    * rng. The stream to draw from.
+*/
+void randomize_esn_rng(ESN* esn, double density, rand_stream* rng);
+
+/**esn_use_sparse - ESN USE SPARSE
+  * Selects how an ESN's resevoir weights are applied during updates. If the ESN has a dense w: if sparse is true, w is compressed into w_sparse (replacing
+  * any existing copy) and updates use the sparse kernel; if sparse is false, w_sparse is freed and updates use w. If the resevoir is held only in w_sparse
+  * (see empty_sparse_esn), sparse being false expands it into a dense w and frees w_sparse. Both produce the same states. Does nothing to an ESN with a
+  * structured resevoir.
+    * esn. The esn to modify.
+    * sparse. Whether to use the sparse resevoir.
+*/
+void esn_use_sparse(ESN* esn, bool sparse);
+
+/**esn_spectral_radius - ESN SPECTRAL RADIUS
+  * Estimates the spectral radius of an ESN's (unscaled) resevoir weights by restarted Arnoldi iteration, using w_sparse when present so that each
+  * iteration costs O(nnz), or of its structured resevoir by topology_spectral_radius. See spectral_radius_arnoldi.
+    * esn. The esn to measure.
+    * tol. The relative tolerance, e.g. SPECTRAL_RADIUS_TOL.
+    * max_iter. The maximum number of matrix-vector products, e.g. SPECTRAL_RADIUS_MAX_ITER.
+*/
+double esn_spectral_radius(const ESN* esn, double tol, int max_iter);
+
 #endif
@@ -0,0 +1,100 @@
+#include "esn_batch.h"
+
+/**esn_batch_alloc - ESN BATCH ALLOC
+  * Allocates a batch of streams over an ESN with every stream's state zero'd.
+    * esn. The ESN whose weights to use.
+    * streams. The number of streams.
+*/
+esn_batch* esn_batch_alloc(ESN* esn, int streams){
+  esn_batch* batch = malloc(sizeof(esn_batch));
+  batch->esn = esn;
+  batch->streams = streams;
+  batch->state = gsl_matrix_calloc(esn->nodes, streams);
+  batch->state_next = gsl_matrix_calloc(esn->nodes, streams);
+  batch->output = gsl_matrix_calloc(esn->outputs, streams);
+  return batch;
+}
+
+/**esn_batch_free - ESN BATCH FREE
+  * Frees a batch and its state and output matrices. The ESN is not freed.
+    * batch. The batch to free.
+*/
+void esn_batch_free(esn_batch* batch){
+  gsl_matrix_free(batch->state);
+  gsl_matrix_free(batch->state_next);
+  gsl_matrix_free(batch->output);
+  free(batch);
+}
+
+/**esn_batch_reset - ESN BATCH RESET
+  * Zeros the state of every stream in a batch.
+    * batch. The batch to reset.
+*/
+void esn_batch_reset(esn_batch* batch){
+  gsl_matrix_set_zero(batch->state);
+}
+
+/**esn_batch_reset_stream - ESN BATCH RESET STREAM
+  * Zeros the state of a single stream in a batch, leaving the others untouched.
+    * batch. The batch to modify.
+    * stream. The index of the stream to reset.
+*/
+void esn_batch_reset_stream(esn_batch* batch, int stream){
+  gsl_vector_view column = gsl_matrix_column(batch->state, stream);
+  gsl_vector_set_zero(&column.vector);
+}
+
+/**esn_batch_step - ESN BATCH STEP
+  * Steps every stream of a batch along by one input, as update_esn does for a single stream. Makes no allocations.
+    * batch. The batch to step.
+    * uN. A [(inputs + 1) x streams] matrix. Column b is the input to stream b, prefaced with the bias e.g. [1; inputs].
+*/
+void esn_batch_step(esn_batch* batch, const gsl_matrix* uN){
+  esn_batch_step_into(batch->esn, uN, batch->state, batch->state_next);
+  gsl_matrix* old_state = batch->state;
+  batch->state = batch->state_next;
+  batch->state_next = old_state;
+}
+
+/**esn_batch_readout - ESN BATCH READOUT
+  * Computes the output of every stream, wOut.[1; uN; state], into batch->output and returns it. Makes no allocations.
+    * batch. The batch to read.
+    * uN. The [(inputs + 1) x streams] inputs last passed to esn_batch_step.
+*/
+gsl_matrix* esn_batch_readout(esn_batch* batch, const gsl_matrix* uN){
+  ESN* esn = batch->esn;
+  gsl_matrix_const_view wOut_in = gsl_matrix_const_submatrix(esn->wOut, 0, 0, esn->outputs, 1 + esn->inputs);
+  gsl_matrix_const_view wOut_res = gsl_matrix_const_submatrix(esn->wOut, 0, 1 + esn->inputs, esn->outputs, esn->nodes);
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, &wOut_in.matrix, uN, 0.0, batch->output);
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, &wOut_res.matrix, batch->state, 1.0, batch->output);
+  return batch->output;
+}
+
+/**esn_batch_step_into - ESN BATCH STEP INTO
+  * Computes the states which follow the columns of state under the columns of uN and writes them to next, using a single resevoir GEMM (or csr_mm, or topology_mm) followed
+  * by one fused leaky tanh pass. The ESN is not modified. Makes no allocations.
+    * esn. The ESN whose weights to use.
+    * uN. A [(inputs + 1) x n] matrix of inputs, each prefaced with the bias.
+    * state. A [nodes x n] matrix of current states.
+    * next. A [nodes x n] matrix to write the next states to. Must not overlap state.
+*/
+void esn_batch_step_into(const ESN* esn, const gsl_matrix* uN, const gsl_matrix* state, gsl_matrix* next){
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, esn->input_scale, esn->wIn, uN, 0.0, next);
+  if(esn->w_topology != NULL){
+    topology_mm(esn->w_topology, esn->spectral_radius, state, 1.0, next);
+  }
+  else if(esn->w_sparse != NULL){
+    csr_mm(esn->w_sparse, esn->spectral_radius, state, 1.0, next);
+  }
+  else{
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, esn->spectral_radius, esn->w, state, 1.0, next);
+  }
+  if(next->tda == next->size2 && state->tda == state->size2){
+    esn->activate(esn->leak_rate, state->data, next->data, next->size1 * next->size2);
+  }
+  else{
+    for(size_t i = 0; i < next->size1; i++){
+      esn->activate(esn->leak_rate, state->data + (i * state->tda), next->data + (i * next->tda), next->size2);
+    }
+  }
+}
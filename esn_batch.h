@@ -0,0 +1,74 @@
+#ifndef EB_H
+#define EB_H
+
+#include <gsl/gsl_matrix.h>
+#include "esn.h"
+
+/**STRUCT esn_batch - ESN BATCH
+ * Steps B independent input streams through one ESN at once. The streams share the ESN's weights but each has its own state, held as one column of a
+ * [nodes x streams] matrix, so every step is a single matrix-matrix product rather than B matrix-vector products. The components are:
+  * esn - The ESN whose weights are used. It is not owned by the batch and may be retrained between steps.
+  * streams - The number of streams (B).
+  * state - A [nodes x streams] gsl_matrix. Column b is the current state of stream b.
+  * state_next - A [nodes x streams] gsl_matrix the next states are written into before being swapped with state. Its contents are scratch.
+  * output - A [outputs x streams] gsl_matrix holding the readout written by esn_batch_readout. Column b is the output of stream b.
+*/
+typedef struct esn_batch{
+  ESN* esn;
+  int streams;
+  gsl_matrix* state;
+  gsl_matrix* state_next;
+  gsl_matrix* output;
+} esn_batch;
+
+/**esn_batch_alloc - ESN BATCH ALLOC
+  * Allocates a batch of streams over an ESN with every stream's state zero'd.
+    * esn. The ESN whose weights to use.
+    * streams. The number of streams.
+*/
+esn_batch* esn_batch_alloc(ESN* esn, int streams);
+
+/**esn_batch_free - ESN BATCH FREE
+  * Frees a batch and its state and output matrices. The ESN is not freed.
+    * batch. The batch to free.
+*/
+void esn_batch_free(esn_batch* batch);
+
+/**esn_batch_reset - ESN BATCH RESET
+  * Zeros the state of every stream in a batch.
+    * batch. The batch to reset.
+*/
+void esn_batch_reset(esn_batch* batch);
+
+/**esn_batch_reset_stream - ESN BATCH RESET STREAM
+  * Zeros the state of a single stream in a batch, leaving the others untouched.
+    * batch. The batch to modify.
+    * stream. The index of the stream to reset.
+*/
+void esn_batch_reset_stream(esn_batch* batch, int stream);
+
+/**esn_batch_step - ESN BATCH STEP
+  * Steps every stream of a batch along by one input, as update_esn does for a single stream. Makes no allocations.
+    * batch. The batch to step.
+    * uN. A [(inputs + 1) x streams] matrix. Column b is the input to stream b, prefaced with the bias e.g. [1; inputs].
+*/
+void esn_batch_step(esn_batch* batch, const gsl_matrix* uN);
+
+/**esn_batch_readout - ESN BATCH READOUT
+  * Computes the output of every stream, wOut.[1; uN; state], into batch->output and returns it. Makes no allocations.
+    * batch. The batch to read.
+    * uN. The [(inputs + 1) x streams] inputs last passed to esn_batch_step.
+*/
+gsl_matrix* esn_batch_readout(esn_batch* batch, const gsl_matrix* uN);
+
+/**esn_batch_step_into - ESN BATCH STEP INTO
+  * Computes the states which follow the columns of state under the columns of uN and writes them to next, using a single resevoir GEMM (or csr_mm) followed
+  * by one fused leaky tanh pass. The ESN is not modified. Makes no allocations.
+    * esn. The ESN whose weights to use.
+    * uN. A [(inputs + 1) x n] matrix of inputs, each prefaced with the bias.
+    * state. A [nodes x n] matrix of current states.
+    * next. A [nodes x n] matrix to write the next states to. Must not overlap state.
+*/
+void esn_batch_step_into(const ESN* esn, const gsl_matrix* uN, const gsl_matrix* state, gsl_matrix* next);
+
+#endif
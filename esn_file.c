@@ -0,0 +1,307 @@
+#include "esn_file.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**esn_file_align - ESN FILE ALIGN
+  * Rounds an offset up to the next multiple of ESN_FILE_ALIGN.
+    * offset. The offset to round.
+*/
+static uint64_t esn_file_align(uint64_t offset){
+  return (offset + ESN_FILE_ALIGN - 1) / ESN_FILE_ALIGN * ESN_FILE_ALIGN;
+}
+
+/**esn_file_pad - ESN FILE PAD
+  * Writes zeros from the current position up to an offset. Returns 0 or -1.
+    * file. The file to write to, positioned at *position.
+    * position. The current position in the file, updated.
+    * offset. The position to pad to.
+*/
+static int esn_file_pad(FILE* file, uint64_t* position, uint64_t offset){
+  static const char zeros[64] = {0};
+  while(*position < offset){
+    uint64_t pad = offset - *position;
+    pad = pad < sizeof(zeros) ? pad : sizeof(zeros);
+    if(fwrite(zeros, 1, pad, file) != pad){
+      return -1;
+    }
+    *position += pad;
+  }
+  return 0;
+}
+
+/**esn_file_write - ESN FILE WRITE
+  * Writes an array at an offset, padding up to it first. Returns 0 or -1.
+    * file. The file to write to, positioned at *position.
+    * position. The current position in the file, updated.
+    * offset. Where the array goes.
+    * data. The array.
+    * bytes. The length of the array in bytes.
+*/
+static int esn_file_write(FILE* file, uint64_t* position, uint64_t offset, const void* data, size_t bytes){
+  if(esn_file_pad(file, position, offset) != 0 || fwrite(data, 1, bytes, file) != bytes){
+    return -1;
+  }
+  *position += bytes;
+  return 0;
+}
+
+/**esn_file_write_matrix - ESN FILE WRITE MATRIX
+  * Writes a matrix at an offset as esn_file_write, with rows packed whatever the matrix's tda. Returns 0 or -1.
+    * file. The file to write to, positioned at *position.
+    * position. The current position in the file, updated.
+    * offset. Where the matrix goes.
+    * m. The matrix to write.
+*/
+static int esn_file_write_matrix(FILE* file, uint64_t* position, uint64_t offset, const gsl_matrix* m){
+  if(esn_file_pad(file, position, offset) != 0){
+    return -1;
+  }
+  for(size_t i = 0; i < m->size1; i++){
+    if(esn_file_write(file, position, *position, gsl_matrix_const_ptr(m, i, 0), m->size2 * sizeof(double)) != 0){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/**esn_save - ESN SAVE
+  * Writes an ESN's weights, hyperparameters, current state and (if it has one) sparse or structured resevoir to a model file. Returns 0, or -1 (after printing why) if the
+  * file could not be written.
+    * esn. The ESN to save.
+    * path. The file to write.
+*/
+int esn_save(const ESN* esn, const char* path){
+  uint64_t nodes = esn->nodes;
+
+  esn_file_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, ESN_FILE_MAGIC, sizeof(header.magic));
+  header.version = ESN_FILE_VERSION;
+  header.endian = ESN_FILE_ENDIAN;
+  header.inputs = esn->inputs;
+  header.outputs = esn->outputs;
+  header.nodes = esn->nodes;
+  header.flags = ESN_FILE_STATE | (esn->w_sparse != NULL ? ESN_FILE_SPARSE : 0) | (esn->tanh_mode == ESN_TANH_FAST ? ESN_FILE_FAST_TANH : 0);
+  if(esn->w_topology != NULL){
+    header.topology = esn->w_topology->kind;
+    header.jump = esn->w_topology->jump;
+    header.jump_weight = esn->w_topology->jump_weight;
+  }
+  header.leak_rate = esn->leak_rate;
+  header.input_scale = esn->input_scale;
+  header.spectral_radius = esn->spectral_radius;
+
+  header.wIn_offset = esn_file_align(sizeof(header));
+  header.wOut_offset = esn_file_align(header.wIn_offset + nodes * (esn->inputs + 1) * sizeof(double));
+  if(esn->w != NULL){
+    header.w_offset = header.wOut_offset;
+    header.wOut_offset = esn_file_align(header.w_offset + nodes * nodes * sizeof(double));
+  }
+  header.state_offset = esn_file_align(header.wOut_offset + esn->outputs * (1 + esn->inputs + nodes) * sizeof(double));
+  if(esn->w_sparse != NULL){
+    header.nnz = esn->w_sparse->nnz;
+    header.row_ptr_offset = esn_file_align(header.state_offset + nodes * sizeof(double));
+    header.col_idx_offset = esn_file_align(header.row_ptr_offset + (nodes + 1) * sizeof(int));
+    header.values_offset = esn_file_align(header.col_idx_offset + header.nnz * sizeof(int));
+  }
+
+  FILE* file = fopen(path, "wb");
+  if(file == NULL){
+    printf("esn_save: could not open %s for writing.\n", path);
+    return -1;
+  }
+
+  uint64_t position = 0;
+  int status = esn_file_write(file, &position, 0, &header, sizeof(header));
+  status |= esn_file_write_matrix(file, &position, header.wIn_offset, esn->wIn);
+  if(esn->w != NULL){
+    status |= esn_file_write_matrix(file, &position, header.w_offset, esn->w);
+  }
+  status |= esn_file_write_matrix(file, &position, header.wOut_offset, esn->wOut);
+  status |= esn_file_write_matrix(file, &position, header.state_offset, esn->state);
+  if(esn->w_sparse != NULL){
+    const csr_matrix* a = esn->w_sparse;
+    status |= esn_file_write(file, &position, header.row_ptr_offset, a->row_ptr, (nodes + 1) * sizeof(int));
+    status |= esn_file_write(file, &position, header.col_idx_offset, a->col_idx, header.nnz * sizeof(int));
+    status |= esn_file_write(file, &position, header.values_offset, a->values, header.nnz * sizeof(double));
+  }
+  if(fclose(file) != 0){
+    status = -1;
+  }
+  if(status != 0){
+    printf("esn_save: could not write %s.\n", path);
+  }
+  return status;
+}
+
+/**esn_file_check_block - ESN FILE CHECK BLOCK
+  * Checks that a block is aligned to its element size and lies inside the file after the header. Returns 0 if so.
+    * offset. The offset of the block.
+    * count. The number of elements.
+    * size. The element size in bytes.
+    * file_size. The length of the file.
+*/
+static int esn_file_check_block(uint64_t offset, uint64_t count, uint64_t size, uint64_t file_size){
+  if(offset % size != 0 || offset < sizeof(esn_file_header) || offset > file_size || count > (file_size - offset) / size){
+    return -1;
+  }
+  return 0;
+}
+
+/**esn_file_check_csr - ESN FILE CHECK CSR
+  * Checks a mapped csr_matrix's pattern in O(nnz), as csr_mv trusts it: row_ptr must run from 0 to nnz without decreasing, and every col_idx must be a
+  * node. Returns 0 if so.
+    * row_ptr. The (nodes + 1) row pointers.
+    * col_idx. The nnz column indices.
+    * nodes. The number of rows and columns.
+    * nnz. The number of stored entries.
+*/
+static int esn_file_check_csr(const int* row_ptr, const int* col_idx, uint64_t nodes, uint64_t nnz){
+  if(row_ptr[0] != 0 || (uint64_t)row_ptr[nodes] != nnz){
+    return -1;
+  }
+  for(uint64_t i = 0; i < nodes; i++){
+    if(row_ptr[i + 1] < row_ptr[i]){
+      return -1;
+    }
+  }
+  for(uint64_t k = 0; k < nnz; k++){
+    if(col_idx[k] < 0 || (uint64_t)col_idx[k] >= nodes){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/**esn_mmap - ESN MMAP
+  * Opens a model file without reading or copying its weights: the file is mapped privately and wIn, w, wOut and w_sparse are wrapped in place, so opening
+  * costs O(1) whatever the resevoir size (beyond one O(nnz) pass checking a sparse resevoir's pattern) and processes mapping the same file share its pages. The mapping is copy on write, so the ESN may still be retrained
+  * or modified - only the pages written are copied, and the file is never changed. state is copied into memory of its own. Free with free_esn, which unmaps
+  * the file. Returns NULL (after printing why) on failure.
+    * path. The file to open.
+*/
+ESN* esn_mmap(const char* path){
+  int fd = open(path, O_RDONLY);
+  if(fd < 0){
+    printf("esn_mmap: could not open %s.\n", path);
+    return NULL;
+  }
+  struct stat st;
+  if(fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(esn_file_header)){
+    printf("esn_mmap: %s is too short to be a model file.\n", path);
+    close(fd);
+    return NULL;
+  }
+  size_t size = st.st_size;
+  void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED){
+    printf("esn_mmap: could not map %s.\n", path);
+    return NULL;
+  }
+
+  const esn_file_header* header = map;
+  uint64_t nodes = header->nodes;
+  bool sparse = (header->flags & ESN_FILE_SPARSE) != 0;
+  bool state = (header->flags & ESN_FILE_STATE) != 0;
+  bool structured = header->topology != 0;
+  bool valid = memcmp(header->magic, ESN_FILE_MAGIC, sizeof(header->magic)) == 0 && header->version == ESN_FILE_VERSION
+    && header->endian == ESN_FILE_ENDIAN && header->nodes > 0 && header->outputs > 0 && header->inputs < INT32_MAX && header->outputs < INT32_MAX
+    && header->nodes < INT32_MAX;
+  valid = valid && esn_file_check_block(header->wIn_offset, nodes * (header->inputs + 1), sizeof(double), size) == 0
+    && (structured ? !sparse && header->w_offset == 0
+      : header->w_offset == 0 ? sparse : esn_file_check_block(header->w_offset, nodes * nodes, sizeof(double), size) == 0)
+    && esn_file_check_block(header->wOut_offset, header->outputs * (1 + header->inputs + nodes), sizeof(double), size) == 0
+    && (!state || esn_file_check_block(header->state_offset, nodes, sizeof(double), size) == 0);
+  if(valid && sparse){
+    valid = header->nnz <= nodes * nodes && esn_file_check_block(header->row_ptr_offset, nodes + 1, sizeof(int), size) == 0
+      && esn_file_check_block(header->col_idx_offset, header->nnz, sizeof(int), size) == 0
+      && esn_file_check_block(header->values_offset, header->nnz, sizeof(double), size) == 0;
+    if(valid){
+      valid = esn_file_check_csr((const int*)((char*)map + header->row_ptr_offset), (const int*)((char*)map + header->col_idx_offset), nodes,
+        header->nnz) == 0;
+    }
+  }
+  topology* t = NULL;
+  if(valid && structured){
+    t = topology_alloc(header->topology, header->nodes, header->jump, header->jump_weight);
+    valid = t != NULL;
+  }
+  if(!valid){
+    printf("esn_mmap: %s is not a valid version %u model file for this machine.\n", path, ESN_FILE_VERSION);
+    munmap(map, size);
+    return NULL;
+  }
+
+  ESN* esn = malloc(sizeof(ESN));
+  esn->inputs = header->inputs;
+  esn->outputs = header->outputs;
+  esn->nodes = header->nodes;
+  esn->leak_rate = header->leak_rate;
+  esn->input_scale = header->input_scale;
+  esn->spectral_radius = header->spectral_radius;
+  esn->wIn = gsl_matrix_wrap((double*)((char*)map + header->wIn_offset), nodes, header->inputs + 1);
+  esn->w = header->w_offset == 0 ? NULL : gsl_matrix_wrap((double*)((char*)map + header->w_offset), nodes, nodes);
+  esn->wOut = gsl_matrix_wrap((double*)((char*)map + header->wOut_offset), header->outputs, 1 + header->inputs + nodes);
+  esn->state = gsl_matrix_calloc(nodes, 1);
+  esn->state_next = gsl_matrix_calloc(nodes, 1);
+  if(state){
+    memcpy(esn->state->data, (char*)map + header->state_offset, nodes * sizeof(double));
+  }
+  esn->w_sparse = NULL;
+  esn->w_topology = t;
+  if(sparse){
+    csr_matrix* a = malloc(sizeof(csr_matrix));
+    a->rows = nodes;
+    a->cols = nodes;
+    a->nnz = header->nnz;
+    a->row_ptr = (int*)((char*)map + header->row_ptr_offset);
+    a->col_idx = (int*)((char*)map + header->col_idx_offset);
+    a->values = (double*)((char*)map + header->values_offset);
+    a->owner = 0;
+    esn->w_sparse = a;
+  }
+  esn->map = map;
+  esn->map_size = size;
+  esn_set_tanh(esn, (header->flags & ESN_FILE_FAST_TANH) != 0 ? ESN_TANH_FAST : ESN_TANH_EXACT);
+  return esn;
+}
+
+/**esn_load - ESN LOAD
+  * Reads a model file written by esn_save into a newly allocated ESN that owns all of its matrices. Returns NULL (after printing why) on failure.
+    * path. The file to read.
+*/
+ESN* esn_load(const char* path){
+  ESN* mapped = esn_mmap(path);
+  if(mapped == NULL){
+    return NULL;
+  }
+  ESN* esn;
+  if(mapped->w_topology != NULL){
+    const topology* t = mapped->w_topology;
+    esn = empty_structured_esn(mapped->inputs, mapped->outputs, mapped->nodes, mapped->leak_rate, mapped->input_scale, mapped->spectral_radius, t->kind,
+      t->jump, t->jump_weight);
+  }
+  else if(mapped->w == NULL){
+    esn = empty_sparse_esn(mapped->inputs, mapped->outputs, mapped->nodes, mapped->leak_rate, mapped->input_scale, mapped->spectral_radius);
+  }
+  else{
+    esn = empty_esn(mapped->inputs, mapped->outputs, mapped->nodes, mapped->leak_rate, mapped->input_scale, mapped->spectral_radius);
+    gsl_matrix_memcpy(esn->w, mapped->w);
+  }
+  if(mapped->w_sparse != NULL){
+    if(esn->w_sparse != NULL){
+      csr_free(esn->w_sparse);
+    }
+    esn->w_sparse = csr_copy(mapped->w_sparse);
+  }
+  gsl_matrix_memcpy(esn->wIn, mapped->wIn);
+  gsl_matrix_memcpy(esn->wOut, mapped->wOut);
+  gsl_matrix_memcpy(esn->state, mapped->state);
+  esn_set_tanh(esn, mapped->tanh_mode);
+  free_esn(mapped);
+  return esn;
+}
@@ -0,0 +1,83 @@
+#ifndef EF_H
+#define EF_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "esn.h"
+
+/** ESN_FILE_MAGIC, ESN_FILE_VERSION, ESN_FILE_ENDIAN, ESN_FILE_ALIGN
+  * A model file starts with an esn_file_header: the magic, the format version, ESN_FILE_ENDIAN as written by the saving machine (files are native endian),
+  * the shape and hyperparameters, and the offset of every block. Each block starts on an ESN_FILE_ALIGN byte boundary and holds a matrix exactly as it is
+  * laid out in memory (row major, rows packed), so a mapped file is used in place.
+*/
+static const char ESN_FILE_MAGIC[8] = {'E', 'S', 'N', 'M', 'O', 'D', 'L', '\0'};
+static const uint32_t ESN_FILE_VERSION = 3;
+static const uint32_t ESN_FILE_ENDIAN = 0x01020304;
+static const uint64_t ESN_FILE_ALIGN = 64;
+
+/** ESN_FILE_SPARSE, ESN_FILE_STATE, ESN_FILE_FAST_TANH
+  * esn_file_header flags. ESN_FILE_SPARSE - the file holds w_sparse, either as a copy of w or, when there is no w block (w_offset is 0), as the only copy of the resevoir. ESN_FILE_STATE - the file holds the resevoir state.
+  * ESN_FILE_FAST_TANH - the ESN was trained with ESN_TANH_FAST (see esn_set_tanh).
+*/
+static const uint32_t ESN_FILE_SPARSE = 1;
+static const uint32_t ESN_FILE_STATE = 2;
+static const uint32_t ESN_FILE_FAST_TANH = 4;
+
+/** STRUCT esn_file_header - ESN FILE HEADER
+  * The start of a model file. Offsets are in bytes from the start of the file, and are 0 for blocks the flags say are absent.
+    * inputs, outputs, nodes, leak_rate, input_scale, spectral_radius. As the ESN struct.
+    * flags. Any of ESN_FILE_SPARSE, ESN_FILE_STATE and ESN_FILE_FAST_TANH.
+    * topology, jump, jump_weight. 0 for a random resevoir (held in the w block, the w_sparse blocks, or both), or the kind and parameters
+      of a structured resevoir (see topology.h), for which there is no w block.
+    * nnz. The number of stored entries of w_sparse.
+    * wIn_offset, w_offset, wOut_offset, state_offset. The [nodes x (inputs + 1)], [nodes x nodes], [outputs x (1 + inputs + nodes)] and [nodes x 1] blocks.
+    * row_ptr_offset, col_idx_offset, values_offset. The (nodes + 1) int, nnz int and nnz double arrays of w_sparse.
+*/
+typedef struct esn_file_header{
+  char magic[8];
+  uint32_t version;
+  uint32_t endian;
+  uint32_t inputs;
+  uint32_t outputs;
+  uint32_t nodes;
+  uint32_t flags;
+  uint32_t topology;
+  uint32_t jump;
+  double jump_weight;
+  double leak_rate;
+  double input_scale;
+  double spectral_radius;
+  uint64_t nnz;
+  uint64_t wIn_offset;
+  uint64_t w_offset;
+  uint64_t wOut_offset;
+  uint64_t state_offset;
+  uint64_t row_ptr_offset;
+  uint64_t col_idx_offset;
+  uint64_t values_offset;
+} esn_file_header;
+
+/**esn_save - ESN SAVE
+  * Writes an ESN's weights, hyperparameters, current state and (if it has one) sparse or structured resevoir to a model file. Returns 0, or -1 (after printing why) if the
+  * file could not be written.
+    * esn. The ESN to save.
+    * path. The file to write.
+*/
+int esn_save(const ESN* esn, const char* path);
+
+/**esn_load - ESN LOAD
+  * Reads a model file written by esn_save into a newly allocated ESN that owns all of its matrices. Returns NULL (after printing why) on failure.
+    * path. The file to read.
+*/
+ESN* esn_load(const char* path);
+
+/**esn_mmap - ESN MMAP
+  * Opens a model file without reading or copying its weights: the file is mapped privately and wIn, w, wOut and w_sparse are wrapped in place, so opening
+  * costs O(1) whatever the resevoir size (beyond one O(nnz) pass checking a sparse resevoir's pattern) and processes mapping the same file share its pages. The mapping is copy on write, so the ESN may still be retrained
+  * or modified - only the pages written are copied, and the file is never changed. state is copied into memory of its own. Free with free_esn, which unmaps
+  * the file. Returns NULL (after printing why) on failure.
+    * path. The file to open.
+*/
+ESN* esn_mmap(const char* path);
+
+#endif
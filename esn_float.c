@@ -0,0 +1,303 @@
+#include "esn_float.h"
+#include <string.h>
+
+/**esn_float_from_esn - ESN FLOAT FROM ESN
+  * Allocates a single precision copy of an ESN's weights and readout, with a zero'd state. If the ESN has a sparse or structured resevoir, so does the copy.
+    * esn. The ESN to copy.
+*/
+esn_float* esn_float_from_esn(const ESN* esn){
+  esn_float* f = malloc(sizeof(esn_float));
+  f->inputs = esn->inputs;
+  f->outputs = esn->outputs;
+  f->nodes = esn->nodes;
+  f->leak_rate = esn->leak_rate;
+  f->input_scale = esn->input_scale;
+  f->spectral_radius = esn->spectral_radius;
+  f->wIn = gsl_matrix_float_alloc(esn->nodes, esn->inputs + 1);
+  /* a sparse resevoir is applied from w_sparse alone, so only a dense one needs a float copy of w */
+  f->w = esn->w != NULL && esn->w_sparse == NULL ? gsl_matrix_float_alloc(esn->nodes, esn->nodes) : NULL;
+  for(int i = 0; i < esn->nodes; i++){
+    for(int j = 0; j < esn->inputs + 1; j++){
+      gsl_matrix_float_set(f->wIn, i, j, (float)gsl_matrix_get(esn->wIn, i, j));
+    }
+    for(int j = 0; f->w != NULL && j < esn->nodes; j++){
+      gsl_matrix_float_set(f->w, i, j, (float)gsl_matrix_get(esn->w, i, j));
+    }
+  }
+  f->w_sparse = NULL;
+  f->values = NULL;
+  f->w_topology = NULL;
+  if(esn->w_topology != NULL){
+    const topology* t = esn->w_topology;
+    f->w_topology = topology_alloc(t->kind, t->nodes, t->jump, t->jump_weight);
+  }
+  if(esn->w_sparse != NULL){
+    const csr_matrix* a = esn->w_sparse;
+    csr_matrix* pattern = malloc(sizeof(csr_matrix));
+    pattern->rows = a->rows;
+    pattern->cols = a->cols;
+    pattern->nnz = a->nnz;
+    pattern->row_ptr = malloc((a->rows + 1) * sizeof(int));
+    pattern->col_idx = malloc((a->nnz > 0 ? a->nnz : 1) * sizeof(int));
+    pattern->values = NULL;
+    pattern->owner = 1;
+    memcpy(pattern->row_ptr, a->row_ptr, (a->rows + 1) * sizeof(int));
+    memcpy(pattern->col_idx, a->col_idx, a->nnz * sizeof(int));
+    f->w_sparse = pattern;
+    f->values = malloc((a->nnz > 0 ? a->nnz : 1) * sizeof(float));
+    for(int k = 0; k < a->nnz; k++){
+      f->values[k] = (float)a->values[k];
+    }
+  }
+  f->wOut = gsl_matrix_alloc(esn->wOut->size1, esn->wOut->size2);
+  gsl_matrix_memcpy(f->wOut, esn->wOut);
+  f->state = gsl_vector_float_calloc(esn->nodes);
+  f->state_next = gsl_vector_float_calloc(esn->nodes);
+  f->input = gsl_vector_float_calloc(esn->inputs + 1);
+  return f;
+}
+
+/**esn_float_free - ESN FLOAT FREE
+  * Frees an esn_float and its matrices.
+    * esn. The esn_float to free.
+*/
+void esn_float_free(esn_float* esn){
+  gsl_matrix_float_free(esn->wIn);
+  if(esn->w != NULL){
+    gsl_matrix_float_free(esn->w);
+  }
+  if(esn->w_sparse != NULL){
+    csr_free(esn->w_sparse);
+    free(esn->values);
+  }
+  if(esn->w_topology != NULL){
+    topology_free(esn->w_topology);
+  }
+  gsl_matrix_free(esn->wOut);
+  gsl_vector_float_free(esn->state);
+  gsl_vector_float_free(esn->state_next);
+  gsl_vector_float_free(esn->input);
+  free(esn);
+}
+
+/**esn_float_reset - ESN FLOAT RESET
+  * Zeros an esn_float's state.
+    * esn. The esn_float to reset.
+*/
+void esn_float_reset(esn_float* esn){
+  gsl_vector_float_set_zero(esn->state);
+}
+
+/**esn_float_activate - ESN FLOAT ACTIVATE
+  * The single precision esn_activate: pre[i] = (1 - leak_rate) * prev[i] + leak_rate * tanh(pre[i]).
+    * leak_rate. The leak rate.
+    * prev. The n long previous state.
+    * pre. The n long preactivation, overwritten with the new state.
+    * n. The number of nodes.
+*/
+void esn_float_activate(float leak_rate, const float* prev, float* pre, size_t n){
+  float keep = 1.0f - leak_rate;
+  for(size_t i = 0; i < n; i++){
+    pre[i] = (keep * prev[i]) + (leak_rate * tanhf(pre[i]));
+  }
+}
+
+/**esn_float_step - ESN FLOAT STEP
+  * Steps an esn_float along according to input uN, as step_esn, in single precision. Makes no allocations.
+    * esn. The esn_float to update.
+    * uN. The inputs, of length inputs + 1, prefaced with the bias e.g. [1; inputs].
+*/
+void esn_float_step(esn_float* esn, const gsl_vector* uN){
+  for(int j = 0; j < esn->inputs + 1; j++){
+    esn->input->data[j] = (float)gsl_vector_get(uN, j);
+  }
+  float* next = esn->state_next->data;
+  const float* state = esn->state->data;
+  gsl_blas_sgemv(CblasNoTrans, (float)esn->input_scale, esn->wIn, esn->input, 0.0f, esn->state_next);
+  if(esn->w_topology != NULL){
+    topology_mv_float(esn->w_topology, (float)esn->spectral_radius, state, next);
+  }
+  else if(esn->w_sparse != NULL){
+    const csr_matrix* a = esn->w_sparse;
+    float sr = (float)esn->spectral_radius;
+    for(int i = 0; i < a->rows; i++){
+      float sum = 0.0f;
+      for(int k = a->row_ptr[i]; k < a->row_ptr[i + 1]; k++){
+        sum += esn->values[k] * state[a->col_idx[k]];
+      }
+      next[i] += sr * sum;
+    }
+  }
+  else{
+    gsl_blas_sgemv(CblasNoTrans, (float)esn->spectral_radius, esn->w, esn->state, 1.0f, esn->state_next);
+  }
+  esn_float_activate((float)esn->leak_rate, state, next, esn->nodes);
+
+  gsl_vector_float* old_state = esn->state;
+  esn->state = esn->state_next;
+  esn->state_next = old_state;
+}
+
+/**esn_float_warmup - ESN FLOAT WARMUP
+  * Starts one sequence of a table, as train_warmup: zeros the state (unless it is the first sequence), then runs the table's warmup input and the sequence's
+  * washout. train_warmup_into cannot be shared, as it steps double states with esn_step_into.
+    * esn. The esn_float to run.
+    * table. The table whose warmups to run.
+    * sequence. The sequence to start.
+*/
+static void esn_float_warmup(esn_float* esn, train_table* table, int sequence){
+  PROFILE_BEGIN(PROFILE_WARMUP);
+  if(sequence > 0){
+    esn_float_reset(esn);
+  }
+  gsl_vector_const_view warmup_v = gsl_matrix_const_column(table->warmup_m, 0);
+  for(int i = 0; i < table->warmups; i++){
+    esn_float_step(esn, &warmup_v.vector);
+  }
+  if(table->washout_uN != NULL){
+    for(int i = table->washout_starts[sequence]; i < table->washout_starts[sequence + 1]; i++){
+      gsl_vector_const_view washout_v = gsl_matrix_const_row(table->washout_uN, i);
+      esn_float_step(esn, &washout_v.vector);
+    }
+  }
+  PROFILE_END(PROFILE_WARMUP, 0, 0);
+}
+
+/**esn_float_get_gram - ESN FLOAT GET GRAM
+  * As train_get_gram, running the resevoir in float. Harvested states are stored in float TRAIN_GRAM_BLOCK timesteps at a time and widened to double for the
+  * rank-k updates, so X.Xt and y_target.Xt are accumulated in double.
+    * esn. The esn_float to run.
+    * table. The table to run it over.
+    * XXt. The [(1 + inputs + nodes) x (1 + inputs + nodes)] matrix to write X.Xt to. Both triangles are written.
+    * y_Xt. The [outputs x (1 + inputs + nodes)] matrix to write y_target.Xt to.
+*/
+void esn_float_get_gram(esn_float* esn, train_table* table, gsl_matrix* XXt, gsl_matrix* y_Xt){
+  int rows = 1 + esn->inputs + esn->nodes;
+  gsl_matrix_float* X_block = gsl_matrix_float_alloc(TRAIN_GRAM_BLOCK, rows);
+  gsl_matrix* X_wide = gsl_matrix_alloc(TRAIN_GRAM_BLOCK, rows);
+  gsl_matrix_set_zero(XXt);
+  gsl_matrix_set_zero(y_Xt);
+
+  esn_float_warmup(esn, table, 0);
+  for(int start = 0; start < table->entries;){
+    int filled = table->entries - start < TRAIN_GRAM_BLOCK ? table->entries - start : TRAIN_GRAM_BLOCK;
+    PROFILE_BEGIN(PROFILE_HARVEST);
+    for(int i = 0; i < filled; i++){
+      int sequence = train_table_opens(table, start + i);
+      if(sequence > 0){
+        esn_float_warmup(esn, table, sequence);
+      }
+      gsl_vector_const_view uN_v = gsl_matrix_const_row(table->uN, start + i);
+      esn_float_step(esn, &uN_v.vector);
+      float* row = X_block->data + (i * X_block->tda);
+      for(int j = 0; j < esn->inputs + 1; j++){
+        row[j] = esn->input->data[j];
+      }
+      for(int j = 0; j < esn->nodes; j++){
+        row[j + 1 + esn->inputs] = esn->state->data[j];
+      }
+    }
+    for(int i = 0; i < filled; i++){
+      const float* row = X_block->data + (i * X_block->tda);
+      double* wide = gsl_matrix_ptr(X_wide, i, 0);
+      for(int j = 0; j < rows; j++){
+        wide[j] = row[j];
+      }
+    }
+    PROFILE_END(PROFILE_HARVEST, 0, 0);
+    gsl_matrix_const_view X_v = gsl_matrix_const_submatrix(X_wide, 0, 0, filled, rows);
+    gsl_matrix_const_view y_v = gsl_matrix_const_submatrix(table->y_target, start, 0, filled, table->y_target->size2);
+    train_gram_add(&X_v.matrix, &y_v.matrix, XXt, y_Xt);
+    start += filled;
+  }
+  train_symmetrize(XXt);
+  gsl_matrix_float_free(X_block);
+  gsl_matrix_free(X_wide);
+}
+
+/**esn_float_nmse - ESN FLOAT NMSE
+  * Computes the NMSE of an esn_float, as nmse: the resevoir runs in float and each output is computed in double. state is reset to zeros at start and end.
+    * esn. The esn_float to score.
+    * dataset. The dataset to use.
+    * type. The table of the dataset to use.
+*/
+double esn_float_nmse(esn_float* esn, train_dataset* dataset, const int type){
+  train_table* table = get_table(dataset, type);
+  esn_float_reset(esn);
+  esn_float_warmup(esn, table, 0);
+
+  gsl_vector* sum = gsl_vector_calloc(esn->outputs);
+  PROFILE_BEGIN(PROFILE_HARVEST);
+  for(int i = 0; i < table->entries; i++){
+    int sequence = train_table_opens(table, i);
+    if(sequence > 0){
+      esn_float_warmup(esn, table, sequence);
+    }
+    gsl_vector_const_view uN_v = gsl_matrix_const_row(table->uN, i);
+    esn_float_step(esn, &uN_v.vector);
+    for(int o = 0; o < esn->outputs; o++){
+      const double* w = gsl_matrix_const_ptr(esn->wOut, o, 0);
+      double y = 0.0;
+      for(int j = 0; j < esn->inputs + 1; j++){
+        y += w[j] * gsl_vector_get(&uN_v.vector, j);
+      }
+      for(int j = 0; j < esn->nodes; j++){
+        y += w[j + 1 + esn->inputs] * esn->state->data[j];
+      }
+      double diff = gsl_matrix_get(table->y_target, i, o) - y;
+      *gsl_vector_ptr(sum, o) += diff * diff;
+    }
+  }
+  PROFILE_END(PROFILE_HARVEST, 0, 0);
+  PROFILE_COUNT(PROFILE_SCORE, 2.0 * esn->outputs * (1 + esn->inputs + esn->nodes) * table->entries, 0);
+
+  gsl_vector* variance = train_target_variance(table->y_target);
+  double score = 0.0;
+  for(int o = 0; o < esn->outputs; o++){
+    score += gsl_vector_get(sum, o) / gsl_vector_get(variance, o) / (double)table->entries;
+  }
+  gsl_vector_free(variance);
+  gsl_vector_free(sum);
+  esn_float_reset(esn);
+  return score / (double)esn->outputs;
+}
+
+/**train_esn_float_ridge_regression - TRAIN ESN FLOAT RIDGE REGRESSION
+  * Trains an esn_float's readout as train_esn_ridge_regression_solver. Both tables are harvested in float into double Gram matrices, and the readout is
+  * solved and scored in double. state is reset to zeros at start and end.
+    * esn. The esn_float to train.
+    * dataset. The dataset to train against.
+    * train_type. The table to train on. Typically 0 (train).
+    * beta_type. The table to choose beta on. Typically 1 (validate).
+    * betas. The beta parameters to try.
+    * beta_count. The number of beta parameters.
+    * solver. RIDGE_AUTO, RIDGE_CHOLESKY or RIDGE_PATH.
+*/
+void train_esn_float_ridge_regression(esn_float* esn, train_dataset* dataset, const int train_type, const int beta_type, double* betas, int beta_count,
+  const int solver){
+  int rows = 1 + esn->inputs + esn->nodes;
+
+  gsl_matrix* XXt = gsl_matrix_alloc(rows, rows);
+  gsl_matrix* y_Xt = gsl_matrix_alloc(esn->outputs, rows);
+  esn_float_reset(esn);
+  esn_float_get_gram(esn, get_table(dataset, train_type), XXt, y_Xt);
+
+  /* candidates are scored from the validation table's Gram statistics, as train_harvest_table_gram */
+  train_table* beta_table = get_table(dataset, beta_type);
+  gsl_matrix* beta_XXt = gsl_matrix_alloc(rows, rows);
+  gsl_matrix* beta_yXt = gsl_matrix_alloc(esn->outputs, rows);
+  esn_float_reset(esn);
+  esn_float_get_gram(esn, beta_table, beta_XXt, beta_yXt);
+  train_harvest* beta_h = train_harvest_from_gram(beta_XXt, beta_yXt, beta_table->y_target);
+
+  gsl_matrix* best_wOut = train_ridge_select(XXt, y_Xt, beta_h, betas, beta_count, solver);
+  if(best_wOut != NULL){
+    gsl_matrix_free(esn->wOut);
+    esn->wOut = best_wOut;
+  }
+
+  train_harvest_free(beta_h);
+  gsl_matrix_free(XXt);
+  gsl_matrix_free(y_Xt);
+  esn_float_reset(esn);
+}
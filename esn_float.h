@@ -0,0 +1,110 @@
+#ifndef EF32_H
+#define EF32_H
+
+#include <math.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_matrix_float.h>
+#include <gsl/gsl_vector_float.h>
+#include "esn.h"
+#include "train.h"
+
+/**STRUCT esn_float - ESN FLOAT
+ * A single precision copy of an ESN for inference and state harvesting. The resevoir runs entirely in float, halving the memory traffic of every step, while
+ * the readout, Gram accumulation and readout solves stay in double. The components are:
+  * inputs, outputs, nodes, leak_rate, input_scale, spectral_radius - As the ESN struct.
+  * wIn - A [nodes x (inputs + 1)] gsl_matrix_float copy of the ESN's wIn.
+  * w - A [nodes x nodes] gsl_matrix_float copy of the ESN's w, or NULL if the ESN has a sparse or structured resevoir.
+  * w_sparse - Either NULL or a csr_matrix holding only the pattern (row_ptr and col_idx, values is NULL) of values (below). Present when the ESN was sparse.
+  * values - The nnz float values of w_sparse, or NULL.
+  * w_topology - Either NULL or a copy of the ESN's structured resevoir, applied with topology_mv_float.
+  * wOut - A [outputs x (1 + inputs + nodes)] double readout.
+  * state - The nodes long float state.
+  * state_next - A nodes long float vector the next state is written into before it is swapped with state. Its contents are scratch.
+  * input - An (inputs + 1) long float scratch vector for the current input.
+*/
+typedef struct esn_float{
+  int inputs;
+  int outputs;
+  int nodes;
+  double leak_rate;
+  double input_scale;
+  double spectral_radius;
+  gsl_matrix_float* wIn;
+  gsl_matrix_float* w;
+  csr_matrix* w_sparse;
+  float* values;
+  topology* w_topology;
+  gsl_matrix* wOut;
+  gsl_vector_float* state;
+  gsl_vector_float* state_next;
+  gsl_vector_float* input;
+} esn_float;
+
+/**esn_float_from_esn - ESN FLOAT FROM ESN
+  * Allocates a single precision copy of an ESN's weights and readout, with a zero'd state. If the ESN has a sparse or structured resevoir, so does the copy.
+    * esn. The ESN to copy.
+*/
+esn_float* esn_float_from_esn(const ESN* esn);
+
+/**esn_float_free - ESN FLOAT FREE
+  * Frees an esn_float and its matrices.
+    * esn. The esn_float to free.
+*/
+void esn_float_free(esn_float* esn);
+
+/**esn_float_reset - ESN FLOAT RESET
+  * Zeros an esn_float's state.
+    * esn. The esn_float to reset.
+*/
+void esn_float_reset(esn_float* esn);
+
+/**esn_float_step - ESN FLOAT STEP
+  * Steps an esn_float along according to input uN, as step_esn, in single precision. Makes no allocations.
+    * esn. The esn_float to update.
+    * uN. The inputs, of length inputs + 1, prefaced with the bias e.g. [1; inputs].
+*/
+void esn_float_step(esn_float* esn, const gsl_vector* uN);
+
+/**esn_float_activate - ESN FLOAT ACTIVATE
+  * The single precision esn_activate: pre[i] = (1 - leak_rate) * prev[i] + leak_rate * tanh(pre[i]).
+    * leak_rate. The leak rate.
+    * prev. The n long previous state.
+    * pre. The n long preactivation, overwritten with the new state.
+    * n. The number of nodes.
+*/
+void esn_float_activate(float leak_rate, const float* prev, float* pre, size_t n);
+
+/**esn_float_get_gram - ESN FLOAT GET GRAM
+  * As train_get_gram, running the resevoir in float. Harvested states are stored in float TRAIN_GRAM_BLOCK timesteps at a time and widened to double for the
+  * rank-k updates, so X.Xt and y_target.Xt are accumulated in double.
+    * esn. The esn_float to run.
+    * table. The table to run it over.
+    * XXt. The [(1 + inputs + nodes) x (1 + inputs + nodes)] matrix to write X.Xt to. Both triangles are written.
+    * y_Xt. The [outputs x (1 + inputs + nodes)] matrix to write y_target.Xt to.
+*/
+void esn_float_get_gram(esn_float* esn, train_table* table, gsl_matrix* XXt, gsl_matrix* y_Xt);
+
+/**esn_float_nmse - ESN FLOAT NMSE
+  * Computes the NMSE of an esn_float, as nmse: the resevoir runs in float and each output is computed in double. state is reset to zeros at start and end.
+    * esn. The esn_float to score.
+    * dataset. The dataset to use.
+    * type. The table of the dataset to use.
+*/
+double esn_float_nmse(esn_float* esn, train_dataset* dataset, const int type);
+
+/**train_esn_float_ridge_regression - TRAIN ESN FLOAT RIDGE REGRESSION
+  * Trains an esn_float's readout as train_esn_ridge_regression_solver. Both tables are harvested in float into double Gram matrices, and the readout is
+  * solved and scored in double. state is reset to zeros at start and end.
+    * esn. The esn_float to train.
+    * dataset. The dataset to train against.
+    * train_type. The table to train on. Typically 0 (train).
+    * beta_type. The table to choose beta on. Typically 1 (validate).
+    * betas. The beta parameters to try.
+    * beta_count. The number of beta parameters.
+    * solver. RIDGE_AUTO, RIDGE_CHOLESKY or RIDGE_PATH.
+*/
+void train_esn_float_ridge_regression(esn_float* esn, train_dataset* dataset, const int train_type, const int beta_type, double* betas, int beta_count,
+  const int solver);
+
+#endif
@@ -0,0 +1,153 @@
+#include "esn_rollout.h"
+
+/**esn_rollout_end - ESN ROLLOUT END
+  * Returns the entry after the last of the sequence an entry belongs to, beyond which a forecast from it has no target.
+    * table. The table.
+    * entry. The entry.
+*/
+static int esn_rollout_end(const train_table* table, int entry){
+  if(table->starts == NULL){
+    return table->entries;
+  }
+  int low = 0;
+  int high = table->sequences;
+  /* the first start after entry */
+  while(low < high){
+    int mid = (low + high) / 2;
+    if(table->starts[mid] <= entry){
+      low = mid + 1;
+    }
+    else{
+      high = mid;
+    }
+  }
+  return table->starts[low];
+}
+
+/**esn_rollout - ESN ROLLOUT
+  * Forecasts a table in closed loop from many origins at once. The ESN is run teacher forced over the table's warmup and entries 0 to origin, as nmse does
+  * (starting each sequence afresh), and its state is forked at every origin. From there each trajectory runs free, its readout wOut.[1; u; x] being fed
+  * back as its next input, and all of the trajectories are stepped together as one esn_batch, so each step of the horizon is a single matrix-matrix
+  * product. The ESN must have been trained to predict its next input, so it needs as many outputs as inputs; output o is fed back to input o.
+  * Returns a newly allocated [count x (horizon * outputs)] matrix, or NULL on error. Entry (k, h * outputs + o) is output o h steps after origin k: column
+  * h = 0 is the teacher forced readout at the origin, and column h is the forecast of y_target row origins[k] + h. It is the responsibility of the caller
+  * to free it. The ESN's state is not used or modified.
+    * esn. The trained ESN.
+    * table. The table to run over.
+    * origins. The count entries of the table to forecast from, in any order. Each must be in [0, entries).
+    * count. The number of origins.
+    * horizon. How many outputs to predict from each origin.
+*/
+gsl_matrix* esn_rollout(ESN* esn, train_table* table, const int* origins, int count, int horizon){
+  if(esn->outputs != esn->inputs){
+    printf("esn_rollout: feeding outputs back needs as many outputs as inputs, not %d and %d.\n", esn->outputs, esn->inputs);
+    return NULL;
+  }
+  if(count < 1 || horizon < 1){
+    printf("esn_rollout: needs at least one origin and a horizon of at least one step.\n");
+    return NULL;
+  }
+  int last = 0;
+  for(int k = 0; k < count; k++){
+    if(origins[k] < 0 || origins[k] >= table->entries){
+      printf("esn_rollout: origin %d is outside the table's %d entries.\n", origins[k], table->entries);
+      return NULL;
+    }
+    if(origins[k] > last){
+      last = origins[k];
+    }
+  }
+
+  /* the origins forked at each entry, as linked lists through next_origin */
+  int* first_origin = malloc((last + 1) * sizeof(int));
+  int* next_origin = malloc(count * sizeof(int));
+  for(int i = 0; i <= last; i++){
+    first_origin[i] = -1;
+  }
+  for(int k = count - 1; k >= 0; k--){
+    next_origin[k] = first_origin[origins[k]];
+    first_origin[origins[k]] = k;
+  }
+
+  esn_batch* batch = esn_batch_alloc(esn, count);
+  gsl_matrix* uN = gsl_matrix_alloc(1 + esn->inputs, count);
+  gsl_vector* state = gsl_vector_calloc(esn->nodes);
+  gsl_vector* state_next = gsl_vector_alloc(esn->nodes);
+
+  train_warmup_into(esn, table, 0, &state, &state_next);
+  PROFILE_BEGIN(PROFILE_HARVEST);
+  for(int i = 0; i <= last; i++){
+    int sequence = train_table_opens(table, i);
+    if(sequence > 0){
+      train_warmup_into(esn, table, sequence, &state, &state_next);
+    }
+    gsl_vector_const_view uN_v = gsl_matrix_const_row(table->uN, i);
+    esn_step_into(esn, &uN_v.vector, state, state_next);
+    gsl_vector* old_state = state;
+    state = state_next;
+    state_next = old_state;
+    for(int k = first_origin[i]; k != -1; k = next_origin[k]){
+      gsl_vector_view state_k = gsl_matrix_column(batch->state, k);
+      gsl_vector_view uN_k = gsl_matrix_column(uN, k);
+      gsl_vector_memcpy(&state_k.vector, state);
+      gsl_vector_memcpy(&uN_k.vector, &uN_v.vector);
+    }
+  }
+  PROFILE_END(PROFILE_HARVEST, 0, batch->state->size1 * batch->state->size2 * sizeof(double));
+
+  gsl_matrix* predictions = gsl_matrix_alloc(count, (size_t)horizon * esn->outputs);
+  gsl_matrix_view feedback = gsl_matrix_submatrix(uN, 1, 0, esn->inputs, count);
+  for(int h = 0; h < horizon; h++){
+    gsl_matrix* output = esn_batch_readout(batch, uN);
+    gsl_matrix_view predictions_h = gsl_matrix_submatrix(predictions, 0, (size_t)h * esn->outputs, count, esn->outputs);
+    gsl_matrix_transpose_memcpy(&predictions_h.matrix, output);
+    if(h + 1 < horizon){
+      gsl_matrix_memcpy(&feedback.matrix, output);
+      esn_batch_step(batch, uN);
+    }
+  }
+
+  free(first_origin);
+  free(next_origin);
+  gsl_vector_free(state);
+  gsl_vector_free(state_next);
+  gsl_matrix_free(uN);
+  esn_batch_free(batch);
+  return predictions;
+}
+
+/**esn_rollout_nmse - ESN ROLLOUT NMSE
+  * Scores the forecasts of esn_rollout at every horizon against the table's targets, giving the multi-horizon error curve. Entry h is the NMSE, as nmse,
+  * of the forecasts h steps ahead, taken over the origins whose target origins[k] + h lies within the origin's sequence and normalized by the variance of the
+  * whole table's targets, or NAN if no origin does. It is the responsibility of the caller to free the vector.
+    * predictions. The matrix returned by esn_rollout.
+    * table. The table the predictions were made over.
+    * origins. The origins the predictions were made from.
+    * count. The number of origins.
+*/
+gsl_vector* esn_rollout_nmse(const gsl_matrix* predictions, train_table* table, const int* origins, int count){
+  size_t outputs = table->y_target->size2;
+  size_t horizon = predictions->size2 / outputs;
+  gsl_vector* variance = train_target_variance(table->y_target);
+  gsl_vector* scores = gsl_vector_alloc(horizon);
+
+  for(size_t h = 0; h < horizon; h++){
+    double score = 0.0;
+    int scored = 0;
+    for(int k = 0; k < count; k++){
+      size_t row = origins[k] + h;
+      if(row >= (size_t)esn_rollout_end(table, origins[k])){
+        continue;
+      }
+      for(size_t o = 0; o < outputs; o++){
+        double diff = gsl_matrix_get(table->y_target, row, o) - gsl_matrix_get(predictions, k, (h * outputs) + o);
+        score += diff * diff / gsl_vector_get(variance, o);
+      }
+      scored++;
+    }
+    gsl_vector_set(scores, h, scored > 0 ? score / (double)scored / (double)outputs : NAN);
+  }
+
+  gsl_vector_free(variance);
+  return scores;
+}
@@ -0,0 +1,37 @@
+#ifndef ER_H
+#define ER_H
+
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+#include "esn.h"
+#include "esn_batch.h"
+#include "train.h"
+
+/**esn_rollout - ESN ROLLOUT
+  * Forecasts a table in closed loop from many origins at once. The ESN is run teacher forced over the table's warmup and entries 0 to origin, as nmse does
+  * (starting each sequence afresh), and its state is forked at every origin. From there each trajectory runs free, its readout wOut.[1; u; x] being fed
+  * back as its next input, and all of the trajectories are stepped together as one esn_batch, so each step of the horizon is a single matrix-matrix
+  * product. The ESN must have been trained to predict its next input, so it needs as many outputs as inputs; output o is fed back to input o.
+  * Returns a newly allocated [count x (horizon * outputs)] matrix, or NULL on error. Entry (k, h * outputs + o) is output o h steps after origin k: column
+  * h = 0 is the teacher forced readout at the origin, and column h is the forecast of y_target row origins[k] + h. It is the responsibility of the caller
+  * to free it. The ESN's state is not used or modified.
+    * esn. The trained ESN.
+    * table. The table to run over.
+    * origins. The count entries of the table to forecast from, in any order. Each must be in [0, entries).
+    * count. The number of origins.
+    * horizon. How many outputs to predict from each origin.
+*/
+gsl_matrix* esn_rollout(ESN* esn, train_table* table, const int* origins, int count, int horizon);
+
+/**esn_rollout_nmse - ESN ROLLOUT NMSE
+  * Scores the forecasts of esn_rollout at every horizon against the table's targets, giving the multi-horizon error curve. Entry h is the NMSE, as nmse,
+  * of the forecasts h steps ahead, taken over the origins whose target origins[k] + h lies within the origin's sequence and normalized by the variance of the
+  * whole table's targets, or NAN if no origin does. It is the responsibility of the caller to free the vector.
+    * predictions. The matrix returned by esn_rollout.
+    * table. The table the predictions were made over.
+    * origins. The origins the predictions were made from.
+    * count. The number of origins.
+*/
+gsl_vector* esn_rollout_nmse(const gsl_matrix* predictions, train_table* table, const int* origins, int count);
+
+#endif
@@ -16,13 +16,28 @@
     *d. The d component of the above formula.
     *iMin. The minimum value of x.
     *iMax. The maximum value of x.
+  *This is a wrapper for NARMA_10_dataset_rng using a stream seeded from C's inbuilt RNG.
 */
 train_dataset* NARMA__10_dataset(int train_entries, int validation_entries, int test_entries, int warmup, double a, double b, double c, double d, double iMin, double iMax){
+  rand_stream rng;
+  rand_stream_from_rand(&rng);
+  return NARMA_10_dataset_rng(train_entries, validation_entries, test_entries, warmup, a, b, c, d, iMin, iMax, &rng);
+}
+
+/**NARMA_10_dataset_rng - NARMA 10 DATASET RNG
+  *Generates a train_dataset as NARMA__10_dataset, drawing every input from an explicit rand_stream. The train, validation and test tables are drawn in that
+  *order from the same stream.
+    *rng. The stream to draw from.
+  *The remaining arguments are as NARMA__10_dataset.
+*/
+train_dataset* NARMA_10_dataset_rng(int train_entries, int validation_entries, int test_entries, int warmup, double a, double b, double c, double d, double iMin, double iMax, rand_stream* rng){
   train_dataset* dataset = malloc(sizeof(train_dataset));
 
-  dataset->train = NARMA_10_table(train_entries, warmup, a, b, c, d, iMin, iMax);
-  dataset->validate = NARMA_10_table(validation_entries, warmup, a, b, c, d, iMin, iMax);
-  dataset->test = NARMA_10_table(test_entries, warmup, a, b, c, d, iMin, iMax);
+  dataset->train = NARMA_10_table_rng(train_entries, warmup, a, b, c, d, iMin, iMax, rng);
+  dataset->validate = NARMA_10_table_rng(validation_entries, warmup, a, b, c, d, iMin, iMax, rng);
+  dataset->test = NARMA_10_table_rng(test_entries, warmup, a, b, c, d, iMin, iMax, rng);
+  dataset->map = NULL;
+  dataset->map_size = 0;
 
   return dataset;
 }
@@ -38,48 +53,145 @@ train_dataset* NARMA__10_dataset(int train_entries, int validation_entries, int
     *d. The d component of the above formula.
     *iMin. The minimum value of x.
     *iMax. The maximum value of x.
+  *This is a wrapper for NARMA_10_table_rng using a stream seeded from C's inbuilt RNG.
 */
 train_table* NARMA_10_table(int entries, int warmup, double a, double b, double c, double d, double iMin, double iMax){
-  train_table* table = malloc(sizeof(train_table));
-
-  table->entries = entries;
-  table->warmups = warmup;
+  rand_stream rng;
+  rand_stream_from_rand(&rng);
+  return NARMA_10_table_rng(entries, warmup, a, b, c, d, iMin, iMax, &rng);
+}
 
-  gsl_matrix* warmup_m = gsl_matrix_alloc(2, 1);
-  gsl_matrix_set(warmup_m, 0, 0, 1.0);
-  gsl_matrix_set(warmup_m, 1, 0, 0.0);
+/**NARMA_10_table_rng - NARMA 10 TABLE RNG
+  *Generates a train_table as NARMA_10_table, drawing every input x with a single bulk fill from an explicit rand_stream.
+    *rng. The stream to draw from.
+  *The remaining arguments are as NARMA_10_table.
+*/
+train_table* NARMA_10_table_rng(int entries, int warmup, double a, double b, double c, double d, double iMin, double iMax, rand_stream* rng){
+  train_table* table = train_table_alloc(1, 1, entries, warmup);
 
-  table->warmup_m = warmup_m;
+  /* a single output, so y_target is one contiguous column */
+  double* ys = gsl_matrix_ptr(table->y_target, 0, 0);
 
-  table->uN = malloc(entries * sizeof(gsl_matrix*));
-  table->y_target = malloc(entries * sizeof(double));
+  double* xs = malloc(entries * sizeof(double));
+  rand_stream_fill_range(rng, xs, entries, iMin, iMax);
 
   for(int i = 0; i < entries; i++){
-    table->uN[i] = gsl_matrix_alloc(2, 1);
-    double x = rand_range(iMin, iMax);
-    gsl_matrix_set(table->uN[i], 0, 0, 1.0);
-    gsl_matrix_set(table->uN[i], 1, 0, x);
+    double x = xs[i];
+    gsl_matrix_set(table->uN, i, 1, x);
 
     double x10 = 0.0;
     if(i - 10 >= 0){
-      x10 = gsl_matrix_get(table->uN[i - 10], 1, 0);
+      x10 = xs[i - 10];
     }
 
     double sum = 0.0;
     for(int j = 2; j <= 10; j++){
       if(i - j >= 0){
-        sum += table->y_target[i - j];
+        sum += ys[i - j];
       }
     }
     double last = 0.0;
 
     if(i != 0){
-      last = table->y_target[i - 1];
+      last = ys[i - 1];
     }
 
-    table->y_target[i] = d * ((a * last) + (b * last * sum) + (1.5 * x * x10) + c);
+    ys[i] = d * ((a * last) + (b * last * sum) + (1.5 * x * x10) + c);
+  }
+
+  free(xs);
+
+  return table;
+
+}
+
+/** MACKEY_GLASS_SUBSTEPS, MACKEY_GLASS_TRANSIENT
+  *The Euler steps taken per sample, and how many samples are discarded before the series is used so it has settled onto its attractor.
+*/
+static const int MACKEY_GLASS_SUBSTEPS = 10;
+static const int MACKEY_GLASS_TRANSIENT = 1000;
+
+/**mackey_glass_series - MACKEY GLASS SERIES
+  *Writes count samples of the squashed Mackey-Glass series described by mackey_glass_dataset.
+    *series. Where to write the samples.
+    *count. The number of samples.
+    *tau. The delay.
+*/
+static void mackey_glass_series(double* series, int count, int tau){
+  int delay = tau * MACKEY_GLASS_SUBSTEPS;
+  double dt = 1.0 / MACKEY_GLASS_SUBSTEPS;
+  /* the last delay + 1 values of x, as a ring buffer */
+  double* history = malloc((delay + 1) * sizeof(double));
+  for(int i = 0; i <= delay; i++){
+    history[i] = 1.2;
   }
+  int now = delay;
+  for(int t = -MACKEY_GLASS_TRANSIENT; t < count; t++){
+    for(int i = 0; i < MACKEY_GLASS_SUBSTEPS; i++){
+      double x = history[now];
+      double x_tau = history[(now + 1) % (delay + 1)];
+      now = (now + 1) % (delay + 1);
+      history[now] = x + (dt * ((0.2 * x_tau / (1.0 + pow(x_tau, 10))) - (0.1 * x)));
+    }
+    if(t >= 0){
+      series[t] = tanh(history[now] - 1.0);
+    }
+  }
+  free(history);
+}
 
+/**mackey_glass_fill - MACKEY GLASS FILL
+  *Allocates a forecasting table over entries + 1 consecutive samples of a series.
+    *series. The samples.
+    *entries. The number of entries.
+    *warmup. The number of warmup steps for the ESN.
+*/
+static train_table* mackey_glass_fill(const double* series, int entries, int warmup){
+  train_table* table = train_table_alloc(1, 1, entries, warmup);
+  for(int i = 0; i < entries; i++){
+    gsl_matrix_set(table->uN, i, 1, series[i]);
+    gsl_matrix_set(table->y_target, i, 0, series[i + 1]);
+  }
   return table;
+}
+
+/**mackey_glass_dataset - MACKEY GLASS DATASET
+  *Generates a one step ahead forecasting train_dataset from the Mackey-Glass delay differential equation
+  dx/dt = 0.2.x(t - tau) / (1 + x(t - tau)^10) - 0.1.x(t), integrated with Euler steps of 0.1 from a constant history of 1.2 and sampled once per time unit.
+  The series is squashed to s(t) = tanh(x(t) - 1). Every table has a single input s(t) and a single target s(t + 1), and the train, validation and test
+  tables are consecutive stretches of one series, so an ESN trained on it can be run in closed loop by esn_rollout.
+    *train_entries. The number of training entries.
+    *validation_entries. The number of validation entires.
+    *test_entries. The number of test entries.
+    *warmup. The number of warmup steps for the ESN.
+    *tau. The delay. 17 gives the usual mildly chaotic series.
+*/
+train_dataset* mackey_glass_dataset(int train_entries, int validation_entries, int test_entries, int warmup, int tau){
+  int count = train_entries + validation_entries + test_entries + 1;
+  double* series = malloc(count * sizeof(double));
+  mackey_glass_series(series, count, tau);
+
+  train_dataset* dataset = malloc(sizeof(train_dataset));
+  dataset->train = mackey_glass_fill(series, train_entries, warmup);
+  dataset->validate = mackey_glass_fill(series + train_entries, validation_entries, warmup);
+  dataset->test = mackey_glass_fill(series + train_entries + validation_entries, test_entries, warmup);
+  dataset->map = NULL;
+  dataset->map_size = 0;
+
+  free(series);
+  return dataset;
+}
 
+/**mackey_glass_table - MACKEY GLASS TABLE
+  *Generates a single one step ahead forecasting train_table, as mackey_glass_dataset.
+    *entries. The number of entries.
+    *warmup. The number of warmup steps for the ESN.
+    *tau. The delay.
+*/
+train_table* mackey_glass_table(int entries, int warmup, int tau){
+  double* series = malloc((entries + 1) * sizeof(double));
+  mackey_glass_series(series, entries + 1, tau);
+  train_table* table = mackey_glass_fill(series, entries, warmup);
+  free(series);
+  return table;
 }
@@ -15,6 +15,7 @@
     *d. The d component of the above formula.
     *iMin. The minimum value of x.
     *iMax. The maximum value of x.
+  *This is a wrapper for NARMA_10_dataset_rng using a stream seeded from C's inbuilt RNG.
 */
 train_dataset* NARMA__10_dataset(int train_entries, int validation_entries, int test_entries, int warmup, double a, double b, double c, double d, double iMin, double iMax);
 
@@ -29,6 +30,42 @@ train_dataset* NARMA__10_dataset(int train_entries, int validation_entries, int
     *d. The d component of the above formula.
     *iMin. The minimum value of x.
     *iMax. The maximum value of x.
+  *This is a wrapper for NARMA_10_table_rng using a stream seeded from C's inbuilt RNG.
 */
 train_table* NARMA_10_table(int entries, int warmup, double a, double b, double c, double d, double iMin, double iMax);
+
+/**NARMA_10_dataset_rng - NARMA 10 DATASET RNG
+  *Generates a train_dataset as NARMA__10_dataset, drawing every input from an explicit rand_stream. The train, validation and test tables are drawn in that
+  *order from the same stream.
+    *rng. The stream to draw from.
+  *The remaining arguments are as NARMA__10_dataset.
+*/
+train_dataset* NARMA_10_dataset_rng(int train_entries, int validation_entries, int test_entries, int warmup, double a, double b, double c, double d, double iMin, double iMax, rand_stream* rng);
+
+/**NARMA_10_table_rng - NARMA 10 TABLE RNG
+  *Generates a train_table as NARMA_10_table, drawing every input x with a single bulk fill from an explicit rand_stream.
+    *rng. The stream to draw from.
+  *The remaining arguments are as NARMA_10_table.
+*/
+train_table* NARMA_10_table_rng(int entries, int warmup, double a, double b, double c, double d, double iMin, double iMax, rand_stream* rng);
+/**mackey_glass_dataset - MACKEY GLASS DATASET
+  *Generates a one step ahead forecasting train_dataset from the Mackey-Glass delay differential equation
+  dx/dt = 0.2.x(t - tau) / (1 + x(t - tau)^10) - 0.1.x(t), integrated with Euler steps of 0.1 from a constant history of 1.2 and sampled once per time unit.
+  The series is squashed to s(t) = tanh(x(t) - 1). Every table has a single input s(t) and a single target s(t + 1), and the train, validation and test
+  tables are consecutive stretches of one series, so an ESN trained on it can be run in closed loop by esn_rollout.
+    *train_entries. The number of training entries.
+    *validation_entries. The number of validation entires.
+    *test_entries. The number of test entries.
+    *warmup. The number of warmup steps for the ESN.
+    *tau. The delay. 17 gives the usual mildly chaotic series.
+*/
+train_dataset* mackey_glass_dataset(int train_entries, int validation_entries, int test_entries, int warmup, int tau);
+
+/**mackey_glass_table - MACKEY GLASS TABLE
+  *Generates a single one step ahead forecasting train_table, as mackey_glass_dataset.
+    *entries. The number of entries.
+    *warmup. The number of warmup steps for the ESN.
+    *tau. The delay.
+*/
+train_table* mackey_glass_table(int entries, int warmup, int tau);
 #endif
@@ -0,0 +1,103 @@
+#include "linear_solve.h"
+
+/**linear_cholesky_panel - LINEAR CHOLESKY PANEL
+  * Unblocked Cholesky factorization of a diagonal block, as linear_cholesky_decomp. Rows are contiguous, so every inner product runs along two rows.
+    * a. The [n x n] block to factorize.
+*/
+static int linear_cholesky_panel(gsl_matrix* a){
+  size_t n = a->size1;
+  for(size_t j = 0; j < n; j++){
+    double* row_j = gsl_matrix_ptr(a, j, 0);
+    double d = row_j[j];
+    for(size_t k = 0; k < j; k++){
+      d -= row_j[k] * row_j[k];
+    }
+    if(!(d > 0.0)){
+      return GSL_EDOM;
+    }
+    double l_jj = sqrt(d);
+    row_j[j] = l_jj;
+    for(size_t i = j + 1; i < n; i++){
+      double* row_i = gsl_matrix_ptr(a, i, 0);
+      double s = row_i[j];
+      for(size_t k = 0; k < j; k++){
+        s -= row_i[k] * row_j[k];
+      }
+      row_i[j] = s / l_jj;
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+/**linear_cholesky_decomp - LINEAR CHOLESKY DECOMP
+  * Factorizes a symmetric positive definite matrix in place as L.Lt. Only the lower triangle of a is read and it is overwritten with L; the strict upper
+  * triangle is left untouched. Returns GSL_SUCCESS, or GSL_EDOM (with a partially overwritten a) if a is not positive definite.
+    * a. The [n x n] matrix to factorize.
+*/
+int linear_cholesky_decomp(gsl_matrix* a){
+  size_t n = a->size1;
+  size_t nb = LINEAR_CHOLESKY_BLOCK;
+  /* right looking: factor the diagonal panel, solve the panel below it, then a rank-nb update of the trailing lower triangle */
+  for(size_t j = 0; j < n; j += nb){
+    size_t jb = (n - j) < nb ? (n - j) : nb;
+    gsl_matrix_view a11 = gsl_matrix_submatrix(a, j, j, jb, jb);
+    if(linear_cholesky_panel(&a11.matrix) != GSL_SUCCESS){
+      return GSL_EDOM;
+    }
+    size_t rest = n - j - jb;
+    if(rest == 0){
+      break;
+    }
+    gsl_matrix_view a21 = gsl_matrix_submatrix(a, j + jb, j, rest, jb);
+    gsl_matrix_view a22 = gsl_matrix_submatrix(a, j + jb, j + jb, rest, rest);
+    gsl_blas_dtrsm(CblasRight, CblasLower, CblasTrans, CblasNonUnit, 1.0, &a11.matrix, &a21.matrix);
+    gsl_blas_dsyrk(CblasLower, CblasNoTrans, -1.0, &a21.matrix, 1.0, &a22.matrix);
+  }
+  return GSL_SUCCESS;
+}
+
+/**linear_cholesky_solve - LINEAR CHOLESKY SOLVE
+  * Overwrites b with inv(A).b, where L is the factor of A from linear_cholesky_decomp. Two triangular solves, no inverse is formed.
+    * L. The [n x n] Cholesky factor.
+    * b. The [n x k] right hand side.
+*/
+void linear_cholesky_solve(const gsl_matrix* L, gsl_matrix* b){
+  gsl_blas_dtrsm(CblasLeft, CblasLower, CblasNoTrans, CblasNonUnit, 1.0, L, b);
+  gsl_blas_dtrsm(CblasLeft, CblasLower, CblasTrans, CblasNonUnit, 1.0, L, b);
+}
+
+/**linear_cholesky_solve_right - LINEAR CHOLESKY SOLVE RIGHT
+  * Overwrites b with b.inv(A), where L is the factor of A from linear_cholesky_decomp. This is the form of the ridge regression normal equations
+  * wOut.(XXt + beta I) = y_Xt.
+    * L. The [n x n] Cholesky factor.
+    * b. The [k x n] right hand side.
+*/
+void linear_cholesky_solve_right(const gsl_matrix* L, gsl_matrix* b){
+  /* b.inv(L.Lt) = (b.inv(Lt)).inv(L) */
+  gsl_blas_dtrsm(CblasRight, CblasLower, CblasTrans, CblasNonUnit, 1.0, L, b);
+  gsl_blas_dtrsm(CblasRight, CblasLower, CblasNoTrans, CblasNonUnit, 1.0, L, b);
+}
+
+/**linear_cholesky_solve_vector - LINEAR CHOLESKY SOLVE VECTOR
+  * Overwrites x with inv(A).x, where L is the factor of A from linear_cholesky_decomp.
+    * L. The [n x n] Cholesky factor.
+    * x. The length n right hand side.
+*/
+void linear_cholesky_solve_vector(const gsl_matrix* L, gsl_vector* x){
+  gsl_blas_dtrsv(CblasLower, CblasNoTrans, CblasNonUnit, L, x);
+  gsl_blas_dtrsv(CblasLower, CblasTrans, CblasNonUnit, L, x);
+}
+
+/**linear_spd_solve_right - LINEAR SPD SOLVE RIGHT
+  * Overwrites b with b.inv(a) for a symmetric positive definite a, factorizing a in place. Returns as linear_cholesky_decomp; b is unchanged on failure.
+    * a. The [n x n] matrix. Only its lower triangle is read, and it is overwritten with its Cholesky factor.
+    * b. The [k x n] right hand side.
+*/
+int linear_spd_solve_right(gsl_matrix* a, gsl_matrix* b){
+  int status = linear_cholesky_decomp(a);
+  if(status != GSL_SUCCESS){
+    return status;
+  }
+  linear_cholesky_solve_right(a, b);
+  return GSL_SUCCESS;
+}
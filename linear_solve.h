@@ -0,0 +1,52 @@
+#ifndef LS_H
+#define LS_H
+
+#include <math.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+
+/** LINEAR_CHOLESKY_BLOCK
+  * The panel width of the blocked Cholesky factorization. Everything outside the diagonal panels is done with level 3 BLAS (dtrsm, dsyrk), so a
+  * threaded BLAS parallelizes the factorization.
+*/
+static const int LINEAR_CHOLESKY_BLOCK = 64;
+
+/**linear_cholesky_decomp - LINEAR CHOLESKY DECOMP
+  * Factorizes a symmetric positive definite matrix in place as L.Lt. Only the lower triangle of a is read and it is overwritten with L; the strict upper
+  * triangle is left untouched. Returns GSL_SUCCESS, or GSL_EDOM (with a partially overwritten a) if a is not positive definite.
+    * a. The [n x n] matrix to factorize.
+*/
+int linear_cholesky_decomp(gsl_matrix* a);
+
+/**linear_cholesky_solve - LINEAR CHOLESKY SOLVE
+  * Overwrites b with inv(A).b, where L is the factor of A from linear_cholesky_decomp. Two triangular solves, no inverse is formed.
+    * L. The [n x n] Cholesky factor.
+    * b. The [n x k] right hand side.
+*/
+void linear_cholesky_solve(const gsl_matrix* L, gsl_matrix* b);
+
+/**linear_cholesky_solve_right - LINEAR CHOLESKY SOLVE RIGHT
+  * Overwrites b with b.inv(A), where L is the factor of A from linear_cholesky_decomp. This is the form of the ridge regression normal equations
+  * wOut.(XXt + beta I) = y_Xt.
+    * L. The [n x n] Cholesky factor.
+    * b. The [k x n] right hand side.
+*/
+void linear_cholesky_solve_right(const gsl_matrix* L, gsl_matrix* b);
+
+/**linear_cholesky_solve_vector - LINEAR CHOLESKY SOLVE VECTOR
+  * Overwrites x with inv(A).x, where L is the factor of A from linear_cholesky_decomp.
+    * L. The [n x n] Cholesky factor.
+    * x. The length n right hand side.
+*/
+void linear_cholesky_solve_vector(const gsl_matrix* L, gsl_vector* x);
+
+/**linear_spd_solve_right - LINEAR SPD SOLVE RIGHT
+  * Overwrites b with b.inv(a) for a symmetric positive definite a, factorizing a in place. Returns as linear_cholesky_decomp; b is unchanged on failure.
+    * a. The [n x n] matrix. Only its lower triangle is read, and it is overwritten with its Cholesky factor.
+    * b. The [k x n] right hand side.
+*/
+int linear_spd_solve_right(gsl_matrix* a, gsl_matrix* b);
+
+#endif
@@ -1,4 +1,5 @@
 #include "matrix_util.h"
+#include "profile.h"
 
 /**print_matrix - PRINT MATRIX
   *Prints a gsl_matrix.
@@ -44,9 +45,11 @@ gsl_matrix* gsl_matrix_multiply(gsl_matrix* a, gsl_matrix* b){
 		//exit(0);
 	}
 
+	PROFILE_BEGIN(PROFILE_MATRIX);
 	gsl_matrix* c = gsl_matrix_alloc(a1, b2);
 
 	gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, a, b, 0.0, c);
+	PROFILE_END(PROFILE_MATRIX, 2.0 * a1 * a2 * b2, c->size1 * c->size2 * sizeof(double));
 
 	return c;
 }
@@ -67,9 +70,11 @@ gsl_matrix* gsl_matrix_multiply_transpose_a(gsl_matrix* a, gsl_matrix* b){
 		//exit(0);
 	}
 
+	PROFILE_BEGIN(PROFILE_MATRIX);
 	gsl_matrix* c = gsl_matrix_alloc(a2, b2);
 
 	gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, a, b, 0.0, c);
+	PROFILE_END(PROFILE_MATRIX, 2.0 * a1 * a2 * b2, c->size1 * c->size2 * sizeof(double));
 
 	return c;
 }
@@ -90,9 +95,11 @@ gsl_matrix* gsl_matrix_multiply_transpose_b(gsl_matrix* a, gsl_matrix* b){
 		//exit(0);
 	}
 
+	PROFILE_BEGIN(PROFILE_MATRIX);
 	gsl_matrix* c = gsl_matrix_alloc(a1, b1);
 
 	gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, a, b, 0.0, c);
+	PROFILE_END(PROFILE_MATRIX, 2.0 * a1 * a2 * b1, c->size1 * c->size2 * sizeof(double));
 
 	return c;
 }
@@ -103,6 +110,7 @@ gsl_matrix* gsl_matrix_multiply_transpose_b(gsl_matrix* a, gsl_matrix* b){
 */
 double gsl_matrix_det(gsl_matrix* a){
 	int signum;
+	PROFILE_BEGIN(PROFILE_MATRIX);
 
 	gsl_matrix* LU = gsl_matrix_alloc(a->size1, a->size2);
 	gsl_matrix_memcpy(LU, a);
@@ -115,6 +123,7 @@ double gsl_matrix_det(gsl_matrix* a){
 
 	gsl_matrix_free(LU);
 	gsl_permutation_free(p);
+	PROFILE_END(PROFILE_MATRIX, 2.0 * a->size1 * a->size1 * a->size1 / 3.0, a->size1 * a->size2 * sizeof(double));
 
 	return det;
 }
@@ -125,6 +134,7 @@ double gsl_matrix_det(gsl_matrix* a){
 */
 gsl_matrix* gsl_matrix_inverse(gsl_matrix* a){
 	int signum;
+	PROFILE_BEGIN(PROFILE_MATRIX);
 
 	gsl_matrix* LU = gsl_matrix_alloc(a->size1, a->size2);
 	gsl_matrix_memcpy(LU, a);
@@ -139,10 +149,29 @@ gsl_matrix* gsl_matrix_inverse(gsl_matrix* a){
 
 	gsl_matrix_free(LU);
 	gsl_permutation_free(p);
+	PROFILE_END(PROFILE_MATRIX, 2.0 * a->size1 * a->size1 * a->size1, 2 * a->size1 * a->size2 * sizeof(double));
 
 	return inverse;
 }
 
+/**gsl_matrix_wrap - GSL MATRIX WRAP
+	*Allocates a gsl_matrix struct over existing row major data without copying it. The matrix does not own the data, so gsl_matrix_free only frees the
+	*struct. Used to treat mapped files as matrices in place.
+		*data. The first element.
+		*rows. The number of rows.
+		*cols. The number of columns. Rows are packed, so the tda is cols.
+*/
+gsl_matrix* gsl_matrix_wrap(double* data, size_t rows, size_t cols){
+	gsl_matrix* m = malloc(sizeof(gsl_matrix));
+	m->size1 = rows;
+	m->size2 = cols;
+	m->tda = cols;
+	m->data = data;
+	m->block = NULL;
+	m->owner = 0;
+	return m;
+}
+
 /**gsl_matrix_pinv - GSL MATRIX PSEUDOINVERSE
   *A non-destructive wrapper for moore_penrose_pinv (see moore_penrose.c). moore_penrose_pinv destroys its input argument - this wrapper copies the input argument and frees the
 	*copy after the pseudoinverse takes place, preserving the original input argument.
@@ -150,37 +179,189 @@ gsl_matrix* gsl_matrix_inverse(gsl_matrix* a){
     * rcond. 	A real number specifying the singular value threshold for inclusion. NumPy default for ``rcond`` is 1E-15.
 */
 gsl_matrix* gsl_matrix_pinv(gsl_matrix* a, double rcond){
+	PROFILE_BEGIN(PROFILE_MATRIX);
 	gsl_matrix* new = gsl_matrix_alloc(a->size1, a->size2);
 	gsl_matrix_memcpy(new, a);
 	gsl_matrix* pinv = moore_penrose_pinv(new, rcond);
 	gsl_matrix_free(new);
+	PROFILE_END(PROFILE_MATRIX, 0, 2 * a->size1 * a->size2 * sizeof(double));
 	return pinv;
 }
 
 /** gsl_matrix_eigenvalues - GSL MATRIX EIGENVALUES
-	* A non-destructive computation of a matrix's eigenvalues using gsl_eigen_symm.
+	* A non-destructive computation of a symmetric matrix's eigenvalues using gsl_eigen_symm. Only the lower triangle of a is read.
 		* a. The matrix to get the eigenvalues of.
 */
 gsl_vector* gsl_matrix_eigen_values(gsl_matrix* a){
+	PROFILE_BEGIN(PROFILE_MATRIX);
+	gsl_matrix* copy = gsl_matrix_alloc(a->size1, a->size2);
+	gsl_matrix_memcpy(copy, a);
 	gsl_vector* k = gsl_vector_alloc(a->size1);
 	gsl_eigen_symm_workspace* w = gsl_eigen_symm_alloc(a->size1);
-	gsl_eigen_symm(a, k, w);
+	gsl_eigen_symm(copy, k, w);
 	gsl_eigen_symm_free(w);
+	gsl_matrix_free(copy);
+	PROFILE_END(PROFILE_MATRIX, 0, a->size1 * a->size2 * sizeof(double));
 	return k;
 }
 
 /** gsl_matrix_max_eigenvalue - GSL MATRIX MAX EIGENVALUE
-	* Computes the maximum eigenvalue of a matrix.
+	* Computes the largest eigenvalue magnitude of a symmetric matrix with a full O(n^3) decomposition. For general (e.g. resevoir) matrices use
+	* gsl_matrix_spectral_radius.
 		* a. The matrix to get the maximum eigenvalue of.
 */
 double gsl_matrix_max_eigenvalue(gsl_matrix* a){
 	gsl_vector* eigen = gsl_matrix_eigen_values(a);
-	double max = abs(gsl_vector_get(eigen, 0));
-	for(int i = 1; i < a->size1; i++){
-		if(abs(gsl_vector_get(eigen, i)) > max){
-			max = abs(gsl_vector_get(eigen, i));
+	double max = fabs(gsl_vector_get(eigen, 0));
+	for(size_t i = 1; i < a->size1; i++){
+		if(fabs(gsl_vector_get(eigen, i)) > max){
+			max = fabs(gsl_vector_get(eigen, i));
 		}
 	}
 	gsl_vector_free(eigen);
 	return max;
 }
+
+/* The Krylov basis size of each Arnoldi cycle, and the number of leading Ritz vectors combined into the next start vector. */
+#define ARNOLDI_KRYLOV_DIM 60
+#define ARNOLDI_RESTART_VECTORS 5
+
+/** spectral_radius_arnoldi - SPECTRAL RADIUS ARNOLDI
+	* Estimates the spectral radius (largest eigenvalue modulus) of a general square matrix, which is only touched through matrix-vector products, using
+	* explicitly restarted Arnoldi iteration. Each cycle builds a Krylov basis of up to 60 vectors, takes the largest-modulus Ritz value of the resulting
+	* Hessenberg matrix and restarts from the sum of the (real) Ritz vectors of the 5 largest-modulus Ritz values, so that a near-dominant eigenvalue which
+	* converges first does not crowd out the dominant one. Complex conjugate dominant pairs, which plain power iteration cannot resolve, are handled.
+	* Stops once the Ritz residual falls below tol relative to the estimate, once the Krylov space becomes invariant (the estimate is then exact), or once
+	* max_iter products have been spent. The start vector is fixed, so the estimate is deterministic.
+		* mv. The matrix-vector product.
+		* a. The matrix, passed to mv.
+		* n. The order of the matrix.
+		* tol. The relative tolerance.
+		* max_iter. The maximum number of matrix-vector products.
+*/
+double spectral_radius_arnoldi(matrix_util_mv mv, const void* a, size_t n, double tol, int max_iter){
+	if(n == 0){
+		return 0.0;
+	}
+	size_t m = n < ARNOLDI_KRYLOV_DIM ? n : ARNOLDI_KRYLOV_DIM;
+
+	/* Row j of Q is Krylov vector j. */
+	PROFILE_BEGIN(PROFILE_SPECTRAL_RADIUS);
+	gsl_matrix* Q = gsl_matrix_alloc(m + 1, n);
+	gsl_matrix* H = gsl_matrix_alloc(m + 1, m);
+	gsl_vector* start = gsl_vector_alloc(n);
+	gsl_vector_complex* ritz = gsl_vector_complex_alloc(m);
+	gsl_matrix_complex* ritz_vectors = gsl_matrix_complex_alloc(m, m);
+	gsl_matrix* Hk = gsl_matrix_alloc(m, m);
+
+	rand_stream rng;
+	rand_stream_init(&rng, 0x5EC7DA1ULL, 0);
+	for(size_t i = 0; i < n; i++){
+		gsl_vector_set(start, i, rand_stream_range(&rng, -1.0, 1.0));
+	}
+
+	double estimate = 0.0;
+	int products = 0;
+
+	while(true){
+		gsl_matrix_set_zero(H);
+		gsl_vector_view q0 = gsl_matrix_row(Q, 0);
+		gsl_vector_memcpy(&q0.vector, start);
+		gsl_vector_scale(&q0.vector, 1.0 / gsl_blas_dnrm2(start));
+
+		size_t k = m;
+		bool invariant = false;
+		for(size_t j = 0; j < m; j++){
+			gsl_vector_view qj = gsl_matrix_row(Q, j);
+			gsl_vector_view w = gsl_matrix_row(Q, j + 1);
+			mv(a, &qj.vector, &w.vector);
+			products++;
+			double w_norm = gsl_blas_dnrm2(&w.vector);
+			/* Modified Gram-Schmidt, twice for stability. */
+			for(int pass = 0; pass < 2; pass++){
+				for(size_t i = 0; i <= j; i++){
+					gsl_vector_view qi = gsl_matrix_row(Q, i);
+					double h;
+					gsl_blas_ddot(&qi.vector, &w.vector, &h);
+					gsl_blas_daxpy(-h, &qi.vector, &w.vector);
+					gsl_matrix_set(H, i, j, gsl_matrix_get(H, i, j) + h);
+				}
+			}
+			double h_next = gsl_blas_dnrm2(&w.vector);
+			gsl_matrix_set(H, j + 1, j, h_next);
+			if(h_next <= 1e-12 * w_norm || h_next == 0.0){
+				k = j + 1;
+				invariant = true;
+				break;
+			}
+			gsl_vector_scale(&w.vector, 1.0 / h_next);
+		}
+
+		gsl_matrix_view Hk_v = gsl_matrix_submatrix(Hk, 0, 0, k, k);
+		gsl_matrix_const_view H_top = gsl_matrix_const_submatrix(H, 0, 0, k, k);
+		gsl_matrix_memcpy(&Hk_v.matrix, &H_top.matrix);
+		gsl_vector_complex_view ritz_v = gsl_vector_complex_subvector(ritz, 0, k);
+		gsl_matrix_complex_view ritz_vectors_v = gsl_matrix_complex_submatrix(ritz_vectors, 0, 0, k, k);
+		gsl_eigen_nonsymmv_workspace* workspace = gsl_eigen_nonsymmv_alloc(k);
+		gsl_eigen_nonsymmv(&Hk_v.matrix, &ritz_v.vector, &ritz_vectors_v.matrix, workspace);
+		gsl_eigen_nonsymmv_free(workspace);
+
+		/* Order the Ritz values by decreasing modulus. */
+		size_t order[ARNOLDI_KRYLOV_DIM];
+		for(size_t i = 0; i < k; i++){
+			order[i] = i;
+			for(size_t l = i; l > 0 && gsl_complex_abs(gsl_vector_complex_get(&ritz_v.vector, order[l])) > gsl_complex_abs(gsl_vector_complex_get(&ritz_v.vector, order[l - 1])); l--){
+				size_t t = order[l];
+				order[l] = order[l - 1];
+				order[l - 1] = t;
+			}
+		}
+		size_t best = order[0];
+		estimate = gsl_complex_abs(gsl_vector_complex_get(&ritz_v.vector, best));
+
+		double residual = gsl_matrix_get(H, k, k - 1) * gsl_complex_abs(gsl_matrix_complex_get(&ritz_vectors_v.matrix, k - 1, best));
+		if(invariant || estimate == 0.0 || residual <= tol * estimate || products + (int)m > max_iter){
+			break;
+		}
+
+		/* Restart from the sum of the real Ritz vectors Q.(Re(s) + Im(s)) of the leading Ritz values. */
+		size_t keep = ARNOLDI_RESTART_VECTORS < k ? ARNOLDI_RESTART_VECTORS : k;
+		gsl_vector_set_zero(start);
+		for(size_t r = 0; r < keep; r++){
+			for(size_t i = 0; i < k; i++){
+				gsl_complex s = gsl_matrix_complex_get(&ritz_vectors_v.matrix, i, order[r]);
+				gsl_vector_view qi = gsl_matrix_row(Q, i);
+				gsl_blas_daxpy(GSL_REAL(s) + GSL_IMAG(s), &qi.vector, start);
+			}
+		}
+		if(gsl_blas_dnrm2(start) == 0.0){
+			break;
+		}
+	}
+
+	gsl_matrix_free(Hk);
+	gsl_matrix_complex_free(ritz_vectors);
+	gsl_vector_complex_free(ritz);
+	gsl_vector_free(start);
+	gsl_matrix_free(H);
+	gsl_matrix_free(Q);
+	PROFILE_END(PROFILE_SPECTRAL_RADIUS, 0, (m + 1) * (n + m) * sizeof(double));
+	return estimate;
+}
+
+/** gsl_matrix_mv - GSL MATRIX MV
+	* A matrix_util_mv for dense gsl_matrices, using gsl_blas_dgemv.
+*/
+static void gsl_matrix_mv(const void* a, const gsl_vector* x, gsl_vector* y){
+	gsl_blas_dgemv(CblasNoTrans, 1.0, (const gsl_matrix*)a, x, 0.0, y);
+}
+
+/** gsl_matrix_spectral_radius - GSL MATRIX SPECTRAL RADIUS
+	* Estimates the spectral radius of a square gsl_matrix with spectral_radius_arnoldi, at O(n^2) per iteration. Preserves the matrix.
+		* a. The matrix.
+		* tol. The relative tolerance.
+		* max_iter. The maximum number of matrix-vector products.
+*/
+double gsl_matrix_spectral_radius(const gsl_matrix* a, double tol, int max_iter){
+	return spectral_radius_arnoldi(gsl_matrix_mv, a, a->size1, tol, max_iter);
+}
@@ -5,7 +5,9 @@
 #include <gsl/gsl_blas.h>
 #include <gsl/gsl_eigen.h>
 #include <gsl/gsl_linalg.h>
+#include <gsl/gsl_complex_math.h>
 #include "moore_penrose.h"
+#include "rand_util.h"
 
 /**print_matrix - PRINT MATRIX
   *Prints a gsl_matrix.
@@ -38,6 +40,15 @@ double gsl_matrix_det(gsl_matrix* a);
 */
 gsl_matrix* gsl_matrix_inverse(gsl_matrix* a);
 
+/**gsl_matrix_wrap - GSL MATRIX WRAP
+	*Allocates a gsl_matrix struct over existing row major data without copying it. The matrix does not own the data, so gsl_matrix_free only frees the
+	*struct. Used to treat mapped files as matrices in place.
+		*data. The first element.
+		*rows. The number of rows.
+		*cols. The number of columns. Rows are packed, so the tda is cols.
+*/
+gsl_matrix* gsl_matrix_wrap(double* data, size_t rows, size_t cols);
+
 /**gsl_matrix_pinv - GSL MATRIX PSEUDOINVERSE
   *A non-destructive wrapper for moore_penrose_pinv (see moore_penrose.c).
     * a. The matrix to inverse.
@@ -60,15 +71,53 @@ gsl_matrix* gsl_matrix_multiply_transpose_a(gsl_matrix* a, gsl_matrix* b);
 gsl_matrix* gsl_matrix_multiply_transpose_b(gsl_matrix* a, gsl_matrix* b);
 
 /** gsl_matrix_eigenvalues - GSL MATRIX EIGENVALUES
-	* A non-destructive computation of a matrix's eigenvalues using gsl_eigen_symm.
+	* A non-destructive computation of a symmetric matrix's eigenvalues using gsl_eigen_symm. Only the lower triangle of a is read.
 		* The matrix to get the eigenvalues of.
 */
 gsl_vector* gsl_matrix_eigen_values(gsl_matrix* a);
 
 /** gsl_matrix_max_eigenvalue - GSL MATRIX MAX EIGENVALUE
-	* Computes the maximum eigenvalue of a matrix.
+	* Computes the largest eigenvalue magnitude of a symmetric matrix with a full O(n^3) decomposition. For general (e.g. resevoir) matrices use
+	* gsl_matrix_spectral_radius.
 		* a. The matrix to get the maximum eigenvalue of.
 */
 double gsl_matrix_max_eigenvalue(gsl_matrix* a);
 
+/** SPECTRAL_RADIUS_TOL, SPECTRAL_RADIUS_MAX_ITER
+	* The default relative tolerance and matrix-vector product budget for spectral radius estimates.
+*/
+static const double SPECTRAL_RADIUS_TOL = 1e-8;
+static const int SPECTRAL_RADIUS_MAX_ITER = 2000;
+
+/** matrix_util_mv - MATRIX UTIL MV
+	* A matrix-vector product y = A.x over some matrix representation, as used by spectral_radius_arnoldi.
+		* a. The matrix.
+		* x. The vector to multiply.
+		* y. The vector to write the product to.
+*/
+typedef void (*matrix_util_mv)(const void* a, const gsl_vector* x, gsl_vector* y);
+
+/** spectral_radius_arnoldi - SPECTRAL RADIUS ARNOLDI
+	* Estimates the spectral radius (largest eigenvalue modulus) of a general square matrix, which is only touched through matrix-vector products, using
+	* explicitly restarted Arnoldi iteration. Each cycle builds a Krylov basis of up to 60 vectors, takes the largest-modulus Ritz value of the resulting
+	* Hessenberg matrix and restarts from the sum of the (real) Ritz vectors of the 5 largest-modulus Ritz values, so that a near-dominant eigenvalue which
+	* converges first does not crowd out the dominant one. Complex conjugate dominant pairs, which plain power iteration cannot resolve, are handled.
+	* Stops once the Ritz residual falls below tol relative to the estimate, once the Krylov space becomes invariant (the estimate is then exact), or once
+	* max_iter products have been spent. The start vector is fixed, so the estimate is deterministic.
+		* mv. The matrix-vector product.
+		* a. The matrix, passed to mv.
+		* n. The order of the matrix.
+		* tol. The relative tolerance.
+		* max_iter. The maximum number of matrix-vector products.
+*/
+double spectral_radius_arnoldi(matrix_util_mv mv, const void* a, size_t n, double tol, int max_iter);
+
+/** gsl_matrix_spectral_radius - GSL MATRIX SPECTRAL RADIUS
+	* Estimates the spectral radius of a square gsl_matrix with spectral_radius_arnoldi, at O(n^2) per iteration. Preserves the matrix.
+		* a. The matrix.
+		* tol. The relative tolerance.
+		* max_iter. The maximum number of matrix-vector products.
+*/
+double gsl_matrix_spectral_radius(const gsl_matrix* a, double tol, int max_iter);
+
 #endif
@@ -36,12 +36,12 @@ typedef unsigned int bool;
 **/
 gsl_matrix* moore_penrose_pinv(gsl_matrix *A, const double rcond) {
 
-	gsl_matrix *V, *Sigma_pinv, *U, *A_pinv;
+	gsl_matrix *V, *A_pinv;
 	gsl_matrix *_tmp_mat = NULL;
 	gsl_vector *_tmp_vec;
 	gsl_vector *u;
 	double x, cutoff;
-	size_t i, j;
+	size_t i;
 	unsigned int n = A->size1;
 	unsigned int m = A->size2;
 	bool was_swapped = false;
@@ -65,9 +65,7 @@ gsl_matrix* moore_penrose_pinv(gsl_matrix *A, const double rcond) {
 	gsl_linalg_SV_decomp(A, V, u, _tmp_vec);
 	gsl_vector_free(_tmp_vec);
 
-	/* compute Σ⁻¹ */
-	Sigma_pinv = gsl_matrix_alloc(m, n);
-	gsl_matrix_set_zero(Sigma_pinv);
+	/* scale the columns of V by Σ⁻¹ - Σ is diagonal so it is never formed */
 	cutoff = rcond * gsl_vector_max(u);
 
 	for (i = 0; i < m; ++i) {
@@ -77,41 +75,108 @@ gsl_matrix* moore_penrose_pinv(gsl_matrix *A, const double rcond) {
 		else {
 			x = 0.;
 		}
-		gsl_matrix_set(Sigma_pinv, i, i, x);
+		gsl_vector_view column = gsl_matrix_column(V, i);
+		gsl_vector_scale(&column.vector, x);
 	}
 
-	/* libgsl SVD yields "thin" SVD - pad to full matrix by adding zeros */
-	U = gsl_matrix_alloc(n, n);
-	gsl_matrix_set_zero(U);
-
-	for (i = 0; i < n; ++i) {
-		for (j = 0; j < m; ++j) {
-			gsl_matrix_set(U, i, j, gsl_matrix_get(A, i, j));
-		}
+	/* libgsl SVD yields "thin" SVD - A now holds the first m columns of U, which is all of U that contributes */
+	if (was_swapped) {
+		A_pinv = gsl_matrix_alloc(n, m);
+		gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1., A, V, 0., A_pinv);
+	}
+	else {
+		A_pinv = gsl_matrix_alloc(m, n);
+		gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1., V, A, 0., A_pinv);
 	}
 
 	if (_tmp_mat != NULL) {
 		gsl_matrix_free(_tmp_mat);
 	}
+	gsl_vector_free(u);
+	gsl_matrix_free(V);
+
+	return A_pinv;
+}
+
+/**
+ * Solve the least squares problem min ||A.X - B|| with the (Moore-Penrose) pseudo-inverse, X = A⁻¹B, without forming A⁻¹.
+ *
+ * With the thin SVD A = UΣVᵀ, X = V.(Σ⁻¹.(UᵀB)), so only the thin U (which overwrites A), V and an m×k temporary are needed. Singular values smaller than
+ * ``rcond`` times the largest are treated as zero, as in moore_penrose_pinv.
+ *
+ * @parameter A		Input n×m matrix. **WARNING**: the input matrix ``A`` is destroyed when n >= m. However, it is still the responsibility of the caller to free it.
+ * @parameter B		The n×k right hand side. Preserved.
+ * @parameter rcond		A real number specifying the singular value threshold for inclusion. NumPy default for ``rcond`` is 1E-15.
+ *
+ * @returns X		The m×k solution. ``X`` is allocated in this function and it is the responsibility of the caller to free it.
+**/
+gsl_matrix* moore_penrose_lstsq(gsl_matrix *A, const gsl_matrix *B, const double rcond) {
+
+	gsl_matrix *V, *T, *X;
+	gsl_matrix *_tmp_mat = NULL;
+	gsl_vector *_tmp_vec;
+	gsl_vector *u;
+	double x, cutoff;
+	size_t i;
+	unsigned int n = A->size1;
+	unsigned int m = A->size2;
+	unsigned int k = B->size2;
+	unsigned int r = min(n, m);
+	bool was_swapped = false;
+
+	if (m > n) {
+		/* libgsl SVD can only handle tall matrices - decompose Aᵀ = UΣVᵀ, so A = VΣUᵀ */
+		was_swapped = true;
+		_tmp_mat = gsl_matrix_alloc(m, n);
+		gsl_matrix_transpose_memcpy(_tmp_mat, A);
+		A = _tmp_mat;
+	}
 
-	/* two dot products to obtain pseudoinverse */
-	_tmp_mat = gsl_matrix_alloc(m, n);
-	gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1., V, Sigma_pinv, 0., _tmp_mat);
+	/* do SVD */
+	V = gsl_matrix_alloc(r, r);
+	u = gsl_vector_alloc(r);
+	_tmp_vec = gsl_vector_alloc(r);
+	gsl_linalg_SV_decomp(A, V, u, _tmp_vec);
+	gsl_vector_free(_tmp_vec);
 
+	/* T = (left singular vectors)ᵀ.B, an r×k matrix */
+	T = gsl_matrix_alloc(r, k);
 	if (was_swapped) {
-		A_pinv = gsl_matrix_alloc(n, m);
-		gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1., U, _tmp_mat, 0., A_pinv);
+		gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1., V, B, 0., T);
 	}
 	else {
-		A_pinv = gsl_matrix_alloc(m, n);
-		gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1., _tmp_mat, U, 0., A_pinv);
+		gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1., A, B, 0., T);
 	}
 
-	gsl_matrix_free(_tmp_mat);
-	gsl_matrix_free(U);
-	gsl_matrix_free(Sigma_pinv);
+	/* T = Σ⁻¹T */
+	cutoff = rcond * gsl_vector_max(u);
+
+	for (i = 0; i < r; ++i) {
+		if (gsl_vector_get(u, i) > cutoff) {
+			x = 1. / gsl_vector_get(u, i);
+		}
+		else {
+			x = 0.;
+		}
+		gsl_vector_view row = gsl_matrix_row(T, i);
+		gsl_vector_scale(&row.vector, x);
+	}
+
+	/* X = (right singular vectors).T */
+	X = gsl_matrix_alloc(m, k);
+	if (was_swapped) {
+		gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1., A, T, 0., X);
+	}
+	else {
+		gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1., V, T, 0., X);
+	}
+
+	if (_tmp_mat != NULL) {
+		gsl_matrix_free(_tmp_mat);
+	}
+	gsl_matrix_free(T);
 	gsl_vector_free(u);
 	gsl_matrix_free(V);
 
-	return A_pinv;
+	return X;
 }
@@ -8,4 +8,6 @@
 
 gsl_matrix* moore_penrose_pinv(gsl_matrix *A, const double rcond);
 
+gsl_matrix* moore_penrose_lstsq(gsl_matrix *A, const gsl_matrix *B, const double rcond);
+
 #endif
@@ -0,0 +1,102 @@
+#include "profile.h"
+#include <string.h>
+#include <time.h>
+
+static _Thread_local profile_report profile_local;
+
+static const char* profile_names[PROFILE_PHASES] = {"step", "warmup", "harvest", "gram", "solve", "score", "randomize", "spectral_radius", "matrix"};
+
+/**profile_enabled - PROFILE ENABLED
+  * Returns whether the library was built with ESN_PROFILE. If not, every report is zeros.
+*/
+bool profile_enabled(){
+#ifdef ESN_PROFILE
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**profile_clock - PROFILE CLOCK
+  * The monotonic clock in nanoseconds.
+*/
+uint64_t profile_clock(){
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return ((uint64_t)t.tv_sec * 1000000000u) + (uint64_t)t.tv_nsec;
+}
+
+/**profile_record - PROFILE RECORD
+  * Adds to the calling thread's counter for a phase. Used by the PROFILE_ macros.
+    * phase. The phase.
+    * calls, nanoseconds, flops, bytes. The amounts to add.
+*/
+void profile_record(profile_phase phase, uint64_t calls, uint64_t nanoseconds, uint64_t flops, uint64_t bytes){
+  profile_counter* counter = &profile_local.phase[phase];
+  counter->calls += calls;
+  counter->nanoseconds += nanoseconds;
+  counter->flops += flops;
+  counter->bytes += bytes;
+}
+
+/**profile_get - PROFILE GET
+  * Copies the calling thread's counters. To attribute work to a task, profile_reset before it and profile_get after it on the thread that runs it, as
+  * hyperparameter_search does for each candidate.
+    * report. Where to copy the counters.
+*/
+void profile_get(profile_report* report){
+  *report = profile_local;
+}
+
+/**profile_reset - PROFILE RESET
+  * Zeros the calling thread's counters.
+*/
+void profile_reset(){
+  memset(&profile_local, 0, sizeof(profile_local));
+}
+
+/**profile_add - PROFILE ADD
+  * Adds one report into another, e.g. to total the reports of several threads or candidates.
+    * total. The report to add to.
+    * part. The report to add.
+*/
+void profile_add(profile_report* total, const profile_report* part){
+  for(int i = 0; i < PROFILE_PHASES; i++){
+    total->phase[i].calls += part->phase[i].calls;
+    total->phase[i].nanoseconds += part->phase[i].nanoseconds;
+    total->phase[i].bytes += part->phase[i].bytes;
+    total->phase[i].flops += part->phase[i].flops;
+  }
+}
+
+/**profile_merge - PROFILE MERGE
+  * Adds a report to the calling thread's counters, crediting it with work a helper thread did on its behalf.
+    * part. The report to add.
+*/
+void profile_merge(const profile_report* part){
+  profile_add(&profile_local, part);
+}
+
+/**profile_phase_name - PROFILE PHASE NAME
+  * Returns the name a phase is reported under, e.g. "harvest".
+    * phase. The phase.
+*/
+const char* profile_phase_name(profile_phase phase){
+  return phase < PROFILE_PHASES ? profile_names[phase] : "unknown";
+}
+
+/**profile_dump - PROFILE DUMP
+  * Writes a report as one JSON object: whether profiling is enabled and, for each phase, its calls, seconds, bytes, flops and flop rate.
+    * file. Where to write.
+    * report. The report to write.
+*/
+void profile_dump(FILE* file, const profile_report* report){
+  fprintf(file, "{\"enabled\": %s, \"phases\": {", profile_enabled() ? "true" : "false");
+  for(int i = 0; i < PROFILE_PHASES; i++){
+    const profile_counter* c = &report->phase[i];
+    double seconds = 1e-9 * c->nanoseconds;
+    fprintf(file, "%s\"%s\": {\"calls\": %llu, \"seconds\": %.9f, \"bytes\": %llu, \"flops\": %llu, \"gflops\": %.3f}", i == 0 ? "" : ", ", profile_names[i],
+      (unsigned long long)c->calls, seconds, (unsigned long long)c->bytes, (unsigned long long)c->flops, seconds > 0 ? 1e-9 * c->flops / seconds : 0.0);
+  }
+  fprintf(file, "}}\n");
+}
@@ -0,0 +1,128 @@
+#ifndef PR_H
+#define PR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/** profile_phase - PROFILE PHASE
+  * The phases timed by the instrumentation layer. Each is timed inclusively; PROFILE_STEP is nested inside PROFILE_WARMUP and PROFILE_HARVEST and
+  * PROFILE_SPECTRAL_RADIUS inside PROFILE_RANDOMIZE, while the other phases never overlap.
+  * PROFILE_STEP - esn_step_into, one call per resevoir update.
+  * PROFILE_WARMUP - running a table's warmup input.
+  * PROFILE_HARVEST - running a table and copying its states (train_get_X and the rows train_get_Xt, train_get_gram, esn_float_get_gram and train_esn_qr
+  * take), or reading them out as nmse and esn_float_nmse do.
+  * PROFILE_GRAM - forming X.Xt and y_target.Xt from harvested states.
+  * PROFILE_SOLVE - the readout solves (least squares, QR, Cholesky and ridge path).
+  * PROFILE_SCORE - scoring readouts against a harvest (train_harvest_nmse), as for every beta tried. nmse only counts its readout flops here.
+  * PROFILE_RANDOMIZE - randomize_esn_rng.
+  * PROFILE_SPECTRAL_RADIUS - spectral radius estimates.
+  * PROFILE_MATRIX - the dense helpers of matrix_util.c (products, inverses, determinants, pseudoinverses and eigenvalues).
+*/
+typedef enum profile_phase{
+  PROFILE_STEP,
+  PROFILE_WARMUP,
+  PROFILE_HARVEST,
+  PROFILE_GRAM,
+  PROFILE_SOLVE,
+  PROFILE_SCORE,
+  PROFILE_RANDOMIZE,
+  PROFILE_SPECTRAL_RADIUS,
+  PROFILE_MATRIX,
+  PROFILE_PHASES
+} profile_phase;
+
+/** STRUCT profile_counter - PROFILE COUNTER
+  * The totals for one phase.
+    * calls. How many times the phase ran.
+    * nanoseconds. The wall time spent in it.
+    * bytes. The bytes of the matrices it allocated.
+    * flops. An estimate of its floating point operations (counting a multiply-add as 2), or 0 where there is no useful estimate.
+*/
+typedef struct profile_counter{
+  uint64_t calls;
+  uint64_t nanoseconds;
+  uint64_t bytes;
+  uint64_t flops;
+} profile_counter;
+
+/** STRUCT profile_report - PROFILE REPORT
+  * The totals for every phase, indexed by profile_phase.
+*/
+typedef struct profile_report{
+  profile_counter phase[PROFILE_PHASES];
+} profile_report;
+
+/** PROFILE_BEGIN, PROFILE_END, PROFILE_COUNT
+  * The instrumentation hooks. They compile to nothing unless ESN_PROFILE is defined, so an uninstrumented build pays nothing. Counters are per thread, so
+  * instrumented code needs no locks; see profile_get.
+  * PROFILE_BEGIN(phase) - starts timing phase in the current block.
+  * PROFILE_END(phase, flops, bytes) - adds one call and the time since PROFILE_BEGIN(phase), flops and bytes to phase.
+  * PROFILE_COUNT(phase, flops, bytes) - adds flops and bytes to phase without a call or time, for work found part way through a phase.
+*/
+#ifdef ESN_PROFILE
+#define PROFILE_BEGIN(phase) uint64_t profile_start_##phase = profile_clock()
+#define PROFILE_END(phase, flops, bytes) profile_record(phase, 1, profile_clock() - profile_start_##phase, (uint64_t)(flops), (uint64_t)(bytes))
+#define PROFILE_COUNT(phase, flops, bytes) profile_record(phase, 0, 0, (uint64_t)(flops), (uint64_t)(bytes))
+#else
+#define PROFILE_BEGIN(phase)
+#define PROFILE_END(phase, flops, bytes) ((void)0)
+#define PROFILE_COUNT(phase, flops, bytes) ((void)0)
+#endif
+
+/**profile_enabled - PROFILE ENABLED
+  * Returns whether the library was built with ESN_PROFILE. If not, every report is zeros.
+*/
+bool profile_enabled();
+
+/**profile_clock - PROFILE CLOCK
+  * The monotonic clock in nanoseconds.
+*/
+uint64_t profile_clock();
+
+/**profile_record - PROFILE RECORD
+  * Adds to the calling thread's counter for a phase. Used by the PROFILE_ macros.
+    * phase. The phase.
+    * calls, nanoseconds, flops, bytes. The amounts to add.
+*/
+void profile_record(profile_phase phase, uint64_t calls, uint64_t nanoseconds, uint64_t flops, uint64_t bytes);
+
+/**profile_get - PROFILE GET
+  * Copies the calling thread's counters. To attribute work to a task, profile_reset before it and profile_get after it on the thread that runs it, as
+  * hyperparameter_search does for each candidate.
+    * report. Where to copy the counters.
+*/
+void profile_get(profile_report* report);
+
+/**profile_reset - PROFILE RESET
+  * Zeros the calling thread's counters.
+*/
+void profile_reset();
+
+/**profile_add - PROFILE ADD
+  * Adds one report into another, e.g. to total the reports of several threads or candidates.
+    * total. The report to add to.
+    * part. The report to add.
+*/
+void profile_add(profile_report* total, const profile_report* part);
+
+/**profile_merge - PROFILE MERGE
+  * Adds a report to the calling thread's counters, crediting it with work a helper thread did on its behalf.
+    * part. The report to add.
+*/
+void profile_merge(const profile_report* part);
+
+/**profile_phase_name - PROFILE PHASE NAME
+  * Returns the name a phase is reported under, e.g. "harvest".
+    * phase. The phase.
+*/
+const char* profile_phase_name(profile_phase phase);
+
+/**profile_dump - PROFILE DUMP
+  * Writes a report as one JSON object: whether profiling is enabled and, for each phase, its calls, seconds, bytes, flops and flop rate.
+    * file. Where to write.
+    * report. The report to write.
+*/
+void profile_dump(FILE* file, const profile_report* report);
+
+#endif
@@ -23,3 +23,132 @@ double rand_range(double min, double max){
 bool rand_bool(double p){
   return rand_double() <= p;
 }
+
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+/**philox_block - PHILOX BLOCK
+  *Computes Philox4x32-10 block (block) of stream (stream) under key (seed) and converts its 128 bits into two doubles in [0, 1).
+*/
+static inline void philox_block(uint64_t seed, uint64_t stream, uint64_t block, double* out){
+  uint32_t c0 = (uint32_t)block;
+  uint32_t c1 = (uint32_t)(block >> 32);
+  uint32_t c2 = (uint32_t)stream;
+  uint32_t c3 = (uint32_t)(stream >> 32);
+  uint32_t k0 = (uint32_t)seed;
+  uint32_t k1 = (uint32_t)(seed >> 32);
+  for(int r = 0; r < 10; r++){
+    uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+    uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+    uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+    uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+    c1 = (uint32_t)p1;
+    c3 = (uint32_t)p0;
+    c0 = n0;
+    c2 = n2;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+  uint64_t a = ((uint64_t)c1 << 32) | c0;
+  uint64_t b = ((uint64_t)c3 << 32) | c2;
+  out[0] = (double)(a >> 11) * 0x1.0p-53;
+  out[1] = (double)(b >> 11) * 0x1.0p-53;
+}
+
+/**rand_stream_init - RAND STREAM INIT
+  *Positions a rand_stream at the start of stream (stream) under key (seed).
+    * rng. The stream to initialise.
+    * seed. The key.
+    * stream. The stream id.
+*/
+void rand_stream_init(rand_stream* rng, uint64_t seed, uint64_t stream){
+  rng->seed = seed;
+  rng->stream = stream;
+  rng->counter = 0;
+  rng->cache_block = UINT64_MAX;
+}
+
+/**rand_stream_double - RAND STREAM DOUBLE
+  *Draws a random double from [0, 1) with 53 random bits.
+    * rng. The stream to draw from.
+*/
+double rand_stream_double(rand_stream* rng){
+  uint64_t block = rng->counter >> 1;
+  if(block != rng->cache_block){
+    philox_block(rng->seed, rng->stream, block, rng->cache);
+    rng->cache_block = block;
+  }
+  return rng->cache[rng->counter++ & 1];
+}
+
+/**rand_stream_range - RAND STREAM RANGE
+  *Draws a random double between min and max, as rand_range.
+    * rng. The stream to draw from.
+    * min. The minimum value
+    * max. The maximum value
+*/
+double rand_stream_range(rand_stream* rng, double min, double max){
+  return min + (rand_stream_double(rng) * fabs(max - min));
+}
+
+/**rand_stream_bool - RAND STREAM BOOLEAN
+  *Draws a random boolean which is true with probability p.
+    * rng. The stream to draw from.
+    * p. The probability of returning true
+*/
+bool rand_stream_bool(rand_stream* rng, double p){
+  return rand_stream_double(rng) < p;
+}
+
+/**rand_stream_fill - RAND STREAM FILL
+  *Fills an array with the next n doubles of a stream, exactly as n calls to rand_stream_double would. Whole Philox blocks are generated by a branch-free loop
+  *the compiler can vectorize.
+    * rng. The stream to draw from.
+    * out. The array to fill.
+    * n. The number of doubles to draw.
+*/
+void rand_stream_fill(rand_stream* rng, double* out, size_t n){
+  size_t i = 0;
+  if(n > 0 && (rng->counter & 1)){
+    out[i++] = rand_stream_double(rng);
+  }
+  uint64_t first = rng->counter >> 1;
+  size_t blocks = (n - i) / 2;
+  double* pairs = out + i;
+  for(size_t b = 0; b < blocks; b++){
+    philox_block(rng->seed, rng->stream, first + b, pairs + (2 * b));
+  }
+  rng->counter += 2 * blocks;
+  i += 2 * blocks;
+  if(i < n){
+    out[i] = rand_stream_double(rng);
+  }
+}
+
+/**rand_stream_fill_range - RAND STREAM FILL RANGE
+  *Fills an array with the next n doubles of a stream scaled to lie between min and max, exactly as n calls to rand_stream_range would.
+    * rng. The stream to draw from.
+    * out. The array to fill.
+    * n. The number of doubles to draw.
+    * min. The minimum value
+    * max. The maximum value
+*/
+void rand_stream_fill_range(rand_stream* rng, double* out, size_t n, double min, double max){
+  rand_stream_fill(rng, out, n);
+  double width = fabs(max - min);
+  for(size_t i = 0; i < n; i++){
+    out[i] = min + (out[i] * width);
+  }
+}
+
+/**rand_stream_from_rand - RAND STREAM FROM RAND
+  *Initialises a rand_stream with a seed drawn from C's inbuilt RNG, so that code which seeds with srand keeps doing so.
+    * rng. The stream to initialise.
+*/
+void rand_stream_from_rand(rand_stream* rng){
+  uint64_t seed = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
+  rand_stream_init(rng, seed, 0);
+}
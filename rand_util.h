@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <math.h>
 
 /**rand_double - RAND DOUBLE
@@ -24,4 +25,76 @@ double rand_range(double min, double max);
 */
 bool rand_bool(double p);
 
+/**STRUCT rand_stream - RAND STREAM
+ * An explicit, thread-safe random number stream based on the Philox4x32-10 counter-based generator. The n'th double of a stream is a pure function of
+ * (seed, stream, n), so streams never share hidden state, any number of threads can draw from their own streams without locking, and a result can be
+ * regenerated bit-exactly from its (seed, stream) whatever thread produced it. Distinct stream ids under the same seed give independent sequences.
+  * seed - The Philox key.
+  * stream - The stream id, occupying the upper half of the Philox counter.
+  * counter - The index of the next double to be drawn.
+  * cache - The last Philox block computed, which holds two doubles.
+  * cache_block - The index of the block held in cache, or UINT64_MAX if none.
+*/
+typedef struct rand_stream{
+  uint64_t seed;
+  uint64_t stream;
+  uint64_t counter;
+  double cache[2];
+  uint64_t cache_block;
+} rand_stream;
+
+/**rand_stream_init - RAND STREAM INIT
+  *Positions a rand_stream at the start of stream (stream) under key (seed).
+    * rng. The stream to initialise.
+    * seed. The key.
+    * stream. The stream id.
+*/
+void rand_stream_init(rand_stream* rng, uint64_t seed, uint64_t stream);
+
+/**rand_stream_double - RAND STREAM DOUBLE
+  *Draws a random double from [0, 1) with 53 random bits.
+    * rng. The stream to draw from.
+*/
+double rand_stream_double(rand_stream* rng);
+
+/**rand_stream_range - RAND STREAM RANGE
+  *Draws a random double between min and max, as rand_range.
+    * rng. The stream to draw from.
+    * min. The minimum value
+    * max. The maximum value
+*/
+double rand_stream_range(rand_stream* rng, double min, double max);
+
+/**rand_stream_bool - RAND STREAM BOOLEAN
+  *Draws a random boolean which is true with probability p.
+    * rng. The stream to draw from.
+    * p. The probability of returning true
+*/
+bool rand_stream_bool(rand_stream* rng, double p);
+
+/**rand_stream_fill - RAND STREAM FILL
+  *Fills an array with the next n doubles of a stream, exactly as n calls to rand_stream_double would. Whole Philox blocks are generated by a branch-free loop
+  *the compiler can vectorize.
+    * rng. The stream to draw from.
+    * out. The array to fill.
+    * n. The number of doubles to draw.
+*/
+void rand_stream_fill(rand_stream* rng, double* out, size_t n);
+
+/**rand_stream_fill_range - RAND STREAM FILL RANGE
+  *Fills an array with the next n doubles of a stream scaled to lie between min and max, exactly as n calls to rand_stream_range would.
+    * rng. The stream to draw from.
+    * out. The array to fill.
+    * n. The number of doubles to draw.
+    * min. The minimum value
+    * max. The maximum value
+*/
+void rand_stream_fill_range(rand_stream* rng, double* out, size_t n, double min, double max);
+
+/**rand_stream_from_rand - RAND STREAM FROM RAND
+  *Initialises a rand_stream with a seed drawn from C's inbuilt RNG, so that code which seeds with srand keeps doing so.
+    * rng. The stream to initialise.
+*/
+void rand_stream_from_rand(rand_stream* rng);
+
 #endif
@@ -0,0 +1,56 @@
+#include "ridge.h"
+
+/**ridge_path_alloc - RIDGE PATH ALLOC
+  * Factorizes XXt with gsl_eigen_symmv and projects y_Xt onto its eigenvectors. Preserves both inputs.
+    * XXt. The symmetric [n x n] matrix X.Xt.
+    * y_Xt. The [outputs x n] matrix y_target.Xt.
+*/
+ridge_path* ridge_path_alloc(const gsl_matrix* XXt, const gsl_matrix* y_Xt){
+  size_t n = XXt->size1;
+  ridge_path* path = malloc(sizeof(ridge_path));
+  path->eigenvalues = gsl_vector_alloc(n);
+  path->eigenvectors = gsl_matrix_alloc(n, n);
+  path->projected = gsl_matrix_alloc(y_Xt->size1, n);
+  path->scratch = gsl_matrix_alloc(y_Xt->size1, n);
+
+  gsl_matrix* A = gsl_matrix_alloc(n, n);
+  gsl_matrix_memcpy(A, XXt);
+  gsl_eigen_symmv_workspace* w = gsl_eigen_symmv_alloc(n);
+  gsl_eigen_symmv(A, path->eigenvalues, path->eigenvectors, w);
+  gsl_eigen_symmv_free(w);
+  gsl_matrix_free(A);
+
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, y_Xt, path->eigenvectors, 0.0, path->projected);
+  return path;
+}
+
+/**ridge_path_solve - RIDGE PATH SOLVE
+  * Writes the ridge regression solution y_Xt.inv(XXt + beta I) for a single beta into wOut in O(outputs x n^2). Directions in which XXt + beta I is not
+  * positive are dropped, as in a pseudoinverse.
+    * path. The factorization.
+    * beta. The regularization parameter.
+    * wOut. The [outputs x n] matrix to write the solution to.
+*/
+void ridge_path_solve(ridge_path* path, double beta, gsl_matrix* wOut){
+  size_t n = path->eigenvalues->size;
+  for(size_t j = 0; j < n; j++){
+    double shifted = gsl_vector_get(path->eigenvalues, j) + beta;
+    double scale = shifted > 0.0 ? 1.0 / shifted : 0.0;
+    for(size_t i = 0; i < path->projected->size1; i++){
+      gsl_matrix_set(path->scratch, i, j, gsl_matrix_get(path->projected, i, j) * scale);
+    }
+  }
+  gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, path->scratch, path->eigenvectors, 0.0, wOut);
+}
+
+/**ridge_path_free - RIDGE PATH FREE
+  * Frees a ridge_path and its matrices.
+    * path. The ridge_path to free.
+*/
+void ridge_path_free(ridge_path* path){
+  gsl_vector_free(path->eigenvalues);
+  gsl_matrix_free(path->eigenvectors);
+  gsl_matrix_free(path->projected);
+  gsl_matrix_free(path->scratch);
+  free(path);
+}
@@ -0,0 +1,45 @@
+#ifndef RIDGE_H
+#define RIDGE_H
+
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+#include "matrix_util.h"
+
+/**STRUCT ridge_path - RIDGE PATH
+ * A factorization of the ridge regression normal equations wOut.(XXt + beta I) = y_Xt which can be solved for any number of betas. XXt is factorized once
+ * as Q.diag(lambda).Qt (O(n^3)), after which each beta costs O(outputs x n^2): wOut = (y_Xt.Q).diag(1 / (lambda + beta)).Qt. The components are:
+  * eigenvalues - The n eigenvalues (lambda) of XXt.
+  * eigenvectors - A [n x n] gsl_matrix (Q) whose columns are the eigenvectors of XXt.
+  * projected - A [outputs x n] gsl_matrix holding y_Xt.Q.
+  * scratch - A [outputs x n] gsl_matrix used by ridge_path_solve.
+*/
+typedef struct ridge_path{
+  gsl_vector* eigenvalues;
+  gsl_matrix* eigenvectors;
+  gsl_matrix* projected;
+  gsl_matrix* scratch;
+} ridge_path;
+
+/**ridge_path_alloc - RIDGE PATH ALLOC
+  * Factorizes XXt with gsl_eigen_symmv and projects y_Xt onto its eigenvectors. Preserves both inputs.
+    * XXt. The symmetric [n x n] matrix X.Xt.
+    * y_Xt. The [outputs x n] matrix y_target.Xt.
+*/
+ridge_path* ridge_path_alloc(const gsl_matrix* XXt, const gsl_matrix* y_Xt);
+
+/**ridge_path_solve - RIDGE PATH SOLVE
+  * Writes the ridge regression solution y_Xt.inv(XXt + beta I) for a single beta into wOut in O(outputs x n^2). Directions in which XXt + beta I is not
+  * positive are dropped, as in a pseudoinverse.
+    * path. The factorization.
+    * beta. The regularization parameter.
+    * wOut. The [outputs x n] matrix to write the solution to.
+*/
+void ridge_path_solve(ridge_path* path, double beta, gsl_matrix* wOut);
+
+/**ridge_path_free - RIDGE PATH FREE
+  * Frees a ridge_path and its matrices.
+    * path. The ridge_path to free.
+*/
+void ridge_path_free(ridge_path* path);
+
+#endif
@@ -0,0 +1,141 @@
+#include "rls.h"
+
+/**rls_alloc - RLS ALLOC
+  * Allocates an RLS trainer for an ESN, starting from a copy of its wOut with P = I / delta.
+    * esn. The ESN to train.
+    * forget. The forgetting factor, in (0, 1]. Typically 0.999 to 1.
+    * delta. The initial regularization. Small values (e.g. 1e-4) adapt fastest but trust the first samples most.
+*/
+rls* rls_alloc(ESN* esn, double forget, double delta){
+  rls* r = malloc(sizeof(rls));
+  r->esn = esn;
+  r->size = 1 + esn->inputs + esn->nodes;
+  r->forget = forget;
+  r->P = gsl_matrix_alloc(r->size, r->size);
+  r->wOut = gsl_matrix_alloc(esn->outputs, r->size);
+  r->x = gsl_vector_alloc(r->size);
+  r->gain = gsl_vector_alloc(r->size);
+  r->y = gsl_vector_calloc(esn->outputs);
+  r->error = gsl_vector_calloc(esn->outputs);
+  rls_reset(r, delta);
+  gsl_matrix_memcpy(r->wOut, esn->wOut);
+  return r;
+}
+
+/**rls_free - RLS FREE
+  * Frees an RLS trainer. The ESN is not freed.
+    * r. The trainer to free.
+*/
+void rls_free(rls* r){
+  gsl_matrix_free(r->P);
+  gsl_matrix_free(r->wOut);
+  gsl_vector_free(r->x);
+  gsl_vector_free(r->gain);
+  gsl_vector_free(r->y);
+  gsl_vector_free(r->error);
+  free(r);
+}
+
+/**rls_reset - RLS RESET
+  * Restarts learning from wOut = 0 and P = I / delta. The ESN's state is not changed.
+    * r. The trainer to reset.
+    * delta. The initial regularization, as rls_alloc.
+*/
+void rls_reset(rls* r, double delta){
+  gsl_matrix_set_identity(r->P);
+  gsl_matrix_scale(r->P, 1.0 / delta);
+  gsl_matrix_set_zero(r->wOut);
+  r->samples = 0;
+}
+
+/**rls_step - RLS STEP
+  * Steps the ESN along by uN (as step_esn), predicts r->y with the learnt readout, then updates the readout towards y_target. Returns the a priori squared
+  * error summed over outputs. Makes no allocations.
+    * r. The trainer.
+    * uN. The input vector, prefaced with the bias e.g. [1; inputs].
+    * y_target. The outputs long target for this step.
+*/
+double rls_step(rls* r, const gsl_vector* uN, const gsl_vector* y_target){
+  ESN* esn = r->esn;
+  step_esn(esn, uN);
+
+  gsl_vector_view x_in = gsl_vector_subvector(r->x, 0, esn->inputs + 1);
+  gsl_vector_view x_state = gsl_vector_subvector(r->x, esn->inputs + 1, esn->nodes);
+  gsl_vector_const_view state = gsl_matrix_const_column(esn->state, 0);
+  gsl_vector_memcpy(&x_in.vector, uN);
+  gsl_vector_memcpy(&x_state.vector, &state.vector);
+
+  /* a priori output and error */
+  gsl_blas_dgemv(CblasNoTrans, 1.0, r->wOut, r->x, 0.0, r->y);
+  gsl_vector_memcpy(r->error, y_target);
+  gsl_vector_sub(r->error, r->y);
+
+  /* gain = P.x / (forget + x.P.x) */
+  gsl_blas_dsymv(CblasLower, 1.0, r->P, r->x, 0.0, r->gain);
+  double xPx;
+  gsl_blas_ddot(r->x, r->gain, &xPx);
+  double denom = r->forget + xPx;
+
+  /* wOut += error.gaint */
+  gsl_blas_dger(1.0 / denom, r->error, r->gain, r->wOut);
+
+  /* P = (P - P.x.xt.P / denom) / forget */
+  gsl_blas_dsyr(CblasLower, -1.0 / denom, r->gain, r->P);
+  if(r->forget != 1.0){
+    gsl_matrix_scale(r->P, 1.0 / r->forget);
+  }
+
+  r->samples++;
+
+  double err;
+  gsl_blas_ddot(r->error, r->error, &err);
+  return err;
+}
+
+/**rls_train_table - RLS TRAIN TABLE
+  * Runs rls_step over every entry of a dataset table (after its warmups), continuing from the ESN's current state. Each further sequence of the table starts
+  * from a zero state, after the warmups and its washout, while the readout keeps learning across them. Returns the a priori NMSE over the table, averaged over outputs as nmse.
+    * r. The trainer.
+    * dataset. The dataset to use.
+    * type. The table of the dataset to use.
+*/
+double rls_train_table(rls* r, train_dataset* dataset, const int type){
+  ESN* esn = r->esn;
+  train_table* table = get_table(dataset, type);
+
+  train_warmup(esn, table, 0);
+
+  gsl_vector* sum = gsl_vector_calloc(esn->outputs);
+  for(int i = 0; i < table->entries; i++){
+    int sequence = train_table_opens(table, i);
+    if(sequence > 0){
+      train_warmup(esn, table, sequence);
+    }
+    gsl_vector_const_view uN_v = gsl_matrix_const_row(table->uN, i);
+    gsl_vector_const_view y_v = gsl_matrix_const_row(table->y_target, i);
+    rls_step(r, &uN_v.vector, &y_v.vector);
+    for(int o = 0; o < esn->outputs; o++){
+      double e = gsl_vector_get(r->error, o);
+      *gsl_vector_ptr(sum, o) += e * e;
+    }
+  }
+
+  gsl_vector* variance = train_target_variance(table->y_target);
+  double score = 0.0;
+  for(int o = 0; o < esn->outputs; o++){
+    score += gsl_vector_get(sum, o) / gsl_vector_get(variance, o) / (double)table->entries;
+  }
+  gsl_vector_free(variance);
+  gsl_vector_free(sum);
+
+  return score / (double)esn->outputs;
+}
+
+/**rls_snapshot - RLS SNAPSHOT
+  * Copies the learnt readout into an ESN's wOut, so it can be used, saved or scored with nmse as any other trained ESN.
+    * r. The trainer.
+    * esn. The ESN to write to. Usually r->esn, but any ESN with the same shape may be used.
+*/
+void rls_snapshot(const rls* r, ESN* esn){
+  gsl_matrix_memcpy(esn->wOut, r->wOut);
+}
@@ -0,0 +1,84 @@
+#ifndef RLS_H
+#define RLS_H
+
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+#include "esn.h"
+#include "train.h"
+
+/**STRUCT rls - RLS
+ * Trains an ESN's readout online by recursive least squares. Each sample steps the ESN and updates a private readout towards the target in O(N^2),
+ * N = 1 + inputs + nodes, whatever how many samples have been seen, and makes no allocations. Older samples are discounted by the forgetting factor, so the
+ * readout tracks a drifting stream; with forget = 1 it converges to the (lightly regularized) least squares readout. The components are:
+  * esn - The ESN being stepped. It is not owned, and its wOut is only written by rls_snapshot.
+  * size - N.
+  * forget - The forgetting factor (lambda), in (0, 1]. Samples are weighted by forget^age, a memory of about 1 / (1 - forget) samples.
+  * P - The [N x N] inverse of the forgetting-weighted correlation matrix of x. Only its lower triangle is kept.
+  * wOut - The [outputs x N] readout being learnt.
+  * x - The current regressor [uN; state].
+  * gain - Scratch, P.x.
+  * y - The a priori output wOut.x of the last sample, before wOut was updated.
+  * error - The a priori error y_target - y of the last sample.
+  * samples - How many samples have been learnt.
+*/
+typedef struct rls{
+  ESN* esn;
+  int size;
+  double forget;
+  gsl_matrix* P;
+  gsl_matrix* wOut;
+  gsl_vector* x;
+  gsl_vector* gain;
+  gsl_vector* y;
+  gsl_vector* error;
+  long samples;
+} rls;
+
+/**rls_alloc - RLS ALLOC
+  * Allocates an RLS trainer for an ESN, starting from a copy of its wOut with P = I / delta.
+    * esn. The ESN to train.
+    * forget. The forgetting factor, in (0, 1]. Typically 0.999 to 1.
+    * delta. The initial regularization. Small values (e.g. 1e-4) adapt fastest but trust the first samples most.
+*/
+rls* rls_alloc(ESN* esn, double forget, double delta);
+
+/**rls_free - RLS FREE
+  * Frees an RLS trainer. The ESN is not freed.
+    * r. The trainer to free.
+*/
+void rls_free(rls* r);
+
+/**rls_reset - RLS RESET
+  * Restarts learning from wOut = 0 and P = I / delta. The ESN's state is not changed.
+    * r. The trainer to reset.
+    * delta. The initial regularization, as rls_alloc.
+*/
+void rls_reset(rls* r, double delta);
+
+/**rls_step - RLS STEP
+  * Steps the ESN along by uN (as step_esn), predicts r->y with the learnt readout, then updates the readout towards y_target. Returns the a priori squared
+  * error summed over outputs. Makes no allocations.
+    * r. The trainer.
+    * uN. The input vector, prefaced with the bias e.g. [1; inputs].
+    * y_target. The outputs long target for this step.
+*/
+double rls_step(rls* r, const gsl_vector* uN, const gsl_vector* y_target);
+
+/**rls_train_table - RLS TRAIN TABLE
+  * Runs rls_step over every entry of a dataset table (after its warmups), continuing from the ESN's current state. Each further sequence of the table starts
+  * from a zero state, after the warmups and its washout, while the readout keeps learning across them. Returns the a priori NMSE over the table, averaged over outputs as nmse.
+    * r. The trainer.
+    * dataset. The dataset to use.
+    * type. The table of the dataset to use.
+*/
+double rls_train_table(rls* r, train_dataset* dataset, const int type);
+
+/**rls_snapshot - RLS SNAPSHOT
+  * Copies the learnt readout into an ESN's wOut, so it can be used, saved or scored with nmse as any other trained ESN.
+    * r. The trainer.
+    * esn. The ESN to write to. Usually r->esn, but any ESN with the same shape may be used.
+*/
+void rls_snapshot(const rls* r, ESN* esn);
+
+#endif
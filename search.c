@@ -0,0 +1,185 @@
+#include "search.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+/** STRUCT search_job - SEARCH JOB
+  *The state shared by the workers of one hyperparameter_search.
+    *dataset. The dataset, read-only.
+    *config. The search config, read-only.
+    *results. The results array. Each worker only writes the entries it has claimed.
+    *table_threads. The threads each candidate's tables are harvested on (see nmse_tables), so cores left idle by too few candidates are still used.
+    *next. The index of the next unclaimed candidate.
+*/
+typedef struct search_job{
+  train_dataset* dataset;
+  search_config* config;
+  search_result* results;
+  int table_threads;
+  atomic_int next;
+} search_job;
+
+static pthread_mutex_t search_print_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**search_config_init - SEARCH CONFIG INIT
+  *Fills a search_config with the ranges used by the demo: leak rate [0, 1], input scale [-1, 1], spectral radius [-1, 1] and density [0.005, 1], using every core.
+  *The seed is drawn from C's inbuilt RNG, so it follows srand.
+    *config. The config to fill.
+    *inputs. The number of inputs of every candidate ESN.
+    *outputs. The number of outputs of every candidate ESN.
+    *nodes. The number of resevoir nodes of every candidate ESN.
+    *candidates. How many candidates to evaluate.
+    *betas. The ridge regression betas. Not copied.
+    *beta_count. The number of betas.
+*/
+void search_config_init(search_config* config, int inputs, int outputs, int nodes, int candidates, double* betas, int beta_count){
+  config->inputs = inputs;
+  config->outputs = outputs;
+  config->nodes = nodes;
+  config->candidates = candidates;
+  config->leak_rate_min = 0.0;
+  config->leak_rate_max = 1.0;
+  config->input_scale_min = -1.0;
+  config->input_scale_max = 1.0;
+  config->spectral_radius_min = -1.0;
+  config->spectral_radius_max = 1.0;
+  config->density_min = 0.005;
+  config->density_max = 1.0;
+  config->betas = betas;
+  config->beta_count = beta_count;
+  config->threads = 0;
+  config->seed = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
+  config->verbose = false;
+}
+
+/**search_build_candidate - SEARCH BUILD CANDIDATE
+  *Regenerates candidate (index) of a search bit-exactly: draws its hyperparameters into result and returns its newly allocated, randomized (untrained) ESN.
+    *config. The search config.
+    *index. The candidate's index.
+    *result. Filled with the candidate's index and hyperparameters. Its scores are not touched.
+*/
+ESN* search_build_candidate(search_config* config, int index, search_result* result){
+  rand_stream rng;
+  rand_stream_init(&rng, config->seed, (uint64_t)index);
+  result->index = index;
+  result->leak_rate = rand_stream_range(&rng, config->leak_rate_min, config->leak_rate_max);
+  result->input_scale = rand_stream_range(&rng, config->input_scale_min, config->input_scale_max);
+  result->spectral_radius = rand_stream_range(&rng, config->spectral_radius_min, config->spectral_radius_max);
+  result->density = rand_stream_range(&rng, config->density_min, config->density_max);
+  ESN* esn = empty_esn(config->inputs, config->outputs, config->nodes, result->leak_rate, result->input_scale, result->spectral_radius);
+  randomize_esn_rng(esn, result->density, &rng);
+  return esn;
+}
+
+/**search_evaluate - SEARCH EVALUATE
+  *Builds, trains and scores the ESN for candidate (index), filling in its result.
+    *job. The search job.
+    *index. The candidate's index.
+*/
+static void search_evaluate(search_job* job, int index){
+  search_config* config = job->config;
+  search_result* result = &job->results[index];
+  profile_reset();
+  ESN* esn = search_build_candidate(config, index, result);
+
+  train_esn_ridge_regression_concurrent(esn, job->dataset, TRAIN_CONST, VALIDATE_CONST, config->betas, config->beta_count, RIDGE_AUTO, job->table_threads);
+  static const int types[3] = {TRAIN_CONST, VALIDATE_CONST, TEST_CONST};
+  double scores[3];
+  nmse_tables(esn, job->dataset, types, 3, job->table_threads, scores);
+  result->train_nmse = scores[0];
+  result->validate_nmse = scores[1];
+  result->test_nmse = scores[2];
+  free_esn(esn);
+  profile_get(&result->profile);
+
+  if(config->verbose){
+    pthread_mutex_lock(&search_print_lock);
+    printf("ESN %d: sparsity = %lf | leak rate = %lf | input scale = %lf | spectral radius = %lf\n", result->index, result->density, result->leak_rate, result->input_scale, result->spectral_radius);
+    printf("  scores: %lf | %lf | %lf\n", result->train_nmse, result->validate_nmse, result->test_nmse);
+    pthread_mutex_unlock(&search_print_lock);
+  }
+}
+
+/**search_worker - SEARCH WORKER
+  *Claims and evaluates candidates until none remain.
+    *arg. The search_job.
+*/
+static void* search_worker(void* arg){
+  search_job* job = arg;
+  int i;
+  while((i = atomic_fetch_add(&job->next, 1)) < job->config->candidates){
+    search_evaluate(job, i);
+  }
+  return NULL;
+}
+
+/**search_compare - SEARCH COMPARE
+  *Orders search_results by ascending validation NMSE, with NaN scores last.
+*/
+static int search_compare(const void* a, const void* b){
+  double x = ((const search_result*)a)->validate_nmse;
+  double y = ((const search_result*)b)->validate_nmse;
+  if(isnan(x) || isnan(y)){
+    return isnan(x) - isnan(y);
+  }
+  return (x > y) - (x < y);
+}
+
+/**hyperparameter_search - HYPERPARAMETER SEARCH
+  *Evaluates config->candidates random ESNs concurrently on config->threads worker threads. Each worker repeatedly takes the next unevaluated candidate,
+  *builds and randomizes its ESN, trains it with train_esn_ridge_regression against the train and validate tables and scores it on all three tables.
+  *When there are fewer candidates than cores, each candidate's tables are also run concurrently (see nmse_tables), which leaves the scores unchanged.
+  *The dataset is shared read-only between the workers. Every candidate is drawn from its own rand_stream, so the whole search is reproducible from
+  *config->seed regardless of thread count or scheduling. When linking a multithreaded BLAS, limit its own threads (e.g. OPENBLAS_NUM_THREADS=1) to avoid oversubscription.
+  *Returns a newly allocated array of config->candidates results ranked by ascending validation NMSE. It is the responsibility of the caller to free it.
+    *dataset. The dataset to train and score against.
+    *config. The search to run.
+*/
+search_result* hyperparameter_search(train_dataset* dataset, search_config* config){
+  search_result* results = malloc(config->candidates * sizeof(search_result));
+
+  int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int threads = config->threads;
+  if(threads <= 0){
+    threads = cores;
+  }
+  if(threads > config->candidates){
+    threads = config->candidates;
+  }
+  if(threads < 1){
+    threads = 1;
+  }
+
+  search_job job;
+  job.dataset = dataset;
+  job.config = config;
+  job.results = results;
+  job.table_threads = cores / threads;
+  if(job.table_threads > 3){
+    job.table_threads = 3;
+  }
+  if(job.table_threads < 1){
+    job.table_threads = 1;
+  }
+  atomic_init(&job.next, 0);
+
+  pthread_t* workers = malloc(threads * sizeof(pthread_t));
+  int started = 0;
+  for(int i = 0; i < threads; i++){
+    if(pthread_create(&workers[i], NULL, search_worker, &job) != 0){
+      printf("Error: Could not start search thread %d.\n", i);
+      break;
+    }
+    started++;
+  }
+  if(started == 0){
+    search_worker(&job);
+  }
+  for(int i = 0; i < started; i++){
+    pthread_join(workers[i], NULL);
+  }
+  free(workers);
+
+  qsort(results, config->candidates, sizeof(search_result), search_compare);
+  return results;
+}
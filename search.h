@@ -0,0 +1,101 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdbool.h>
+#include "esn.h"
+#include "train.h"
+#include "profile.h"
+
+/** STRUCT search_config - SEARCH CONFIG
+  *Describes a random hyperparameter search. Each candidate draws its leak rate, input scale, spectral radius and density uniformly from the given ranges.
+    *inputs. The number of inputs of every candidate ESN.
+    *outputs. The number of outputs of every candidate ESN.
+    *nodes. The number of resevoir nodes of every candidate ESN.
+    *candidates. How many candidates to evaluate.
+    *leak_rate_min, leak_rate_max. The range of leak rates.
+    *input_scale_min, input_scale_max. The range of input scales.
+    *spectral_radius_min, spectral_radius_max. The range of spectral radii.
+    *density_min, density_max. The range of resevoir densities passed to randomize_esn.
+    *betas. The ridge regression betas passed to train_esn_ridge_regression.
+    *beta_count. The number of betas.
+    *threads. The number of worker threads. 0 uses every online core.
+    *seed. The rand_stream seed. Candidate i draws its hyperparameters and then its weights from stream i under this seed.
+    *verbose. Whether to print each candidate's scores as it finishes.
+*/
+typedef struct search_config{
+  int inputs;
+  int outputs;
+  int nodes;
+  int candidates;
+  double leak_rate_min;
+  double leak_rate_max;
+  double input_scale_min;
+  double input_scale_max;
+  double spectral_radius_min;
+  double spectral_radius_max;
+  double density_min;
+  double density_max;
+  double* betas;
+  int beta_count;
+  int threads;
+  uint64_t seed;
+  bool verbose;
+} search_config;
+
+/** STRUCT search_result - SEARCH RESULT
+  *The hyperparameters and scores of a single search candidate.
+    *index. The candidate's position in the order candidates were drawn, which is also its rand_stream id.
+    *leak_rate. The candidate's leak rate.
+    *input_scale. The candidate's input scale.
+    *spectral_radius. The candidate's spectral radius.
+    *density. The candidate's resevoir density.
+    *train_nmse. The candidate's NMSE on the training table.
+    *validate_nmse. The candidate's NMSE on the validation table.
+    *test_nmse. The candidate's NMSE on the testing table.
+    *profile. Where the candidate's build, training and scoring spent their time. All zeros unless built with ESN_PROFILE (see profile.h).
+*/
+typedef struct search_result{
+  int index;
+  double leak_rate;
+  double input_scale;
+  double spectral_radius;
+  double density;
+  double train_nmse;
+  double validate_nmse;
+  double test_nmse;
+  profile_report profile;
+} search_result;
+
+/**search_config_init - SEARCH CONFIG INIT
+  *Fills a search_config with the ranges used by the demo: leak rate [0, 1], input scale [-1, 1], spectral radius [-1, 1] and density [0.005, 1], using every core.
+  *The seed is drawn from C's inbuilt RNG, so it follows srand.
+    *config. The config to fill.
+    *inputs. The number of inputs of every candidate ESN.
+    *outputs. The number of outputs of every candidate ESN.
+    *nodes. The number of resevoir nodes of every candidate ESN.
+    *candidates. How many candidates to evaluate.
+    *betas. The ridge regression betas. Not copied.
+    *beta_count. The number of betas.
+*/
+void search_config_init(search_config* config, int inputs, int outputs, int nodes, int candidates, double* betas, int beta_count);
+
+/**hyperparameter_search - HYPERPARAMETER SEARCH
+  *Evaluates config->candidates random ESNs concurrently on config->threads worker threads. Each worker repeatedly takes the next unevaluated candidate,
+  *builds and randomizes its ESN, trains it with train_esn_ridge_regression against the train and validate tables and scores it on all three tables.
+  *The dataset is shared read-only between the workers. Every candidate is drawn from its own rand_stream, so the whole search is reproducible from
+  *config->seed regardless of thread count or scheduling. When linking a multithreaded BLAS, limit its own threads (e.g. OPENBLAS_NUM_THREADS=1) to avoid oversubscription.
+  *Returns a newly allocated array of config->candidates results ranked by ascending validation NMSE. It is the responsibility of the caller to free it.
+    *dataset. The dataset to train and score against.
+    *config. The search to run.
+*/
+search_result* hyperparameter_search(train_dataset* dataset, search_config* config);
+
+/**search_build_candidate - SEARCH BUILD CANDIDATE
+  *Regenerates candidate (index) of a search bit-exactly: draws its hyperparameters into result and returns its newly allocated, randomized (untrained) ESN.
+    *config. The search config.
+    *index. The candidate's index.
+    *result. Filled with the candidate's index and hyperparameters. Its scores are not touched.
+*/
+ESN* search_build_candidate(search_config* config, int index, search_result* result);
+
+#endif
@@ -0,0 +1,213 @@
+#include "sparse_util.h"
+#include <string.h>
+
+/**csr_calloc - CSR CALLOC
+  *Allocates a csr_matrix of zeros, with no stored entries.
+    * rows. The number of rows.
+    * cols. The number of columns.
+*/
+csr_matrix* csr_calloc(int rows, int cols){
+  csr_matrix* a = malloc(sizeof(csr_matrix));
+  a->rows = rows;
+  a->cols = cols;
+  a->nnz = 0;
+  a->row_ptr = calloc(rows + 1, sizeof(int));
+  a->col_idx = malloc(sizeof(int));
+  a->values = malloc(sizeof(double));
+  a->owner = 1;
+  return a;
+}
+
+/**csr_copy - CSR COPY
+  *Copies a csr_matrix into a newly allocated csr_matrix that owns its arrays.
+    * a. The matrix to copy.
+*/
+csr_matrix* csr_copy(const csr_matrix* a){
+  csr_matrix* b = malloc(sizeof(csr_matrix));
+  b->rows = a->rows;
+  b->cols = a->cols;
+  b->nnz = a->nnz;
+  b->row_ptr = malloc((a->rows + 1) * sizeof(int));
+  b->col_idx = malloc((a->nnz > 0 ? a->nnz : 1) * sizeof(int));
+  b->values = malloc((a->nnz > 0 ? a->nnz : 1) * sizeof(double));
+  b->owner = 1;
+  memcpy(b->row_ptr, a->row_ptr, (a->rows + 1) * sizeof(int));
+  memcpy(b->col_idx, a->col_idx, a->nnz * sizeof(int));
+  memcpy(b->values, a->values, a->nnz * sizeof(double));
+  return b;
+}
+
+/**csr_from_gsl_matrix - CSR FROM GSL MATRIX
+  *Compresses a dense gsl_matrix into a newly allocated csr_matrix, keeping every entry that is not exactly 0.0. Preserves the existing matrix.
+    * m. The matrix to compress.
+*/
+csr_matrix* csr_from_gsl_matrix(const gsl_matrix* m){
+  int rows = m->size1;
+  int cols = m->size2;
+  int nnz = 0;
+  for(int i = 0; i < rows; i++){
+    for(int j = 0; j < cols; j++){
+      if(gsl_matrix_get(m, i, j) != 0.0){
+        nnz++;
+      }
+    }
+  }
+
+  csr_matrix* a = malloc(sizeof(csr_matrix));
+  a->rows = rows;
+  a->cols = cols;
+  a->nnz = nnz;
+  a->row_ptr = malloc((rows + 1) * sizeof(int));
+  a->col_idx = malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+  a->values = malloc((nnz > 0 ? nnz : 1) * sizeof(double));
+  a->owner = 1;
+
+  int k = 0;
+  for(int i = 0; i < rows; i++){
+    a->row_ptr[i] = k;
+    for(int j = 0; j < cols; j++){
+      double v = gsl_matrix_get(m, i, j);
+      if(v != 0.0){
+        a->col_idx[k] = j;
+        a->values[k] = v;
+        k++;
+      }
+    }
+  }
+  a->row_ptr[rows] = k;
+  return a;
+}
+
+/**csr_to_gsl_matrix - CSR TO GSL MATRIX
+  *Expands a csr_matrix into a newly allocated dense gsl_matrix.
+    * a. The matrix to expand.
+*/
+gsl_matrix* csr_to_gsl_matrix(const csr_matrix* a){
+  gsl_matrix* m = gsl_matrix_calloc(a->rows, a->cols);
+  for(int i = 0; i < a->rows; i++){
+    for(int k = a->row_ptr[i]; k < a->row_ptr[i + 1]; k++){
+      gsl_matrix_set(m, i, a->col_idx[k], a->values[k]);
+    }
+  }
+  return m;
+}
+
+/**csr_free - CSR FREE
+  *Frees a csr_matrix, and its arrays if it owns them.
+    * a. The matrix to free.
+*/
+void csr_free(csr_matrix* a){
+  if(a->owner){
+    free(a->row_ptr);
+    free(a->col_idx);
+    free(a->values);
+  }
+  free(a);
+}
+
+/**csr_density - CSR DENSITY
+  *Computes the fraction of entries of a csr_matrix which are stored, nnz / (rows x cols).
+    * a. The matrix to measure.
+*/
+double csr_density(const csr_matrix* a){
+  if(a->rows == 0 || a->cols == 0){
+    return 0.0;
+  }
+  return (double)a->nnz / ((double)a->rows * (double)a->cols);
+}
+
+/**csr_scale - CSR SCALE
+  *Multiplies every stored entry of a csr_matrix by x, in place.
+    * a. The matrix to scale.
+    * x. The scale factor.
+*/
+void csr_scale(csr_matrix* a, double x){
+  for(int k = 0; k < a->nnz; k++){
+    a->values[k] *= x;
+  }
+}
+
+/**csr_mv - CSR MATRIX VECTOR
+  *Computes y = alpha * a.x + beta * y in O(nnz). Each row is summed in ascending column order. x and y must not overlap.
+    * a. The sparse matrix.
+    * alpha. The scaling of a.x.
+    * x. The vector to multiply, of length a->cols.
+    * beta. The scaling of the existing y. If beta is 0.0 the existing contents of y are ignored.
+    * y. The vector to write to, of length a->rows.
+*/
+void csr_mv(const csr_matrix* a, double alpha, const gsl_vector* x, double beta, gsl_vector* y){
+  if(x->size != (size_t)a->cols || y->size != (size_t)a->rows){
+    printf("Error: Matrix dimensions do not match. %d x %d . %d x 1 -> %d x 1\n", a->rows, a->cols, (int)x->size, (int)y->size);
+    return;
+  }
+  const double* xd = x->data;
+  const size_t xs = x->stride;
+  double* yd = y->data;
+  const size_t ys = y->stride;
+  for(int i = 0; i < a->rows; i++){
+    double sum = 0.0;
+    for(int k = a->row_ptr[i]; k < a->row_ptr[i + 1]; k++){
+      sum += a->values[k] * xd[a->col_idx[k] * xs];
+    }
+    if(beta == 0.0){
+      yd[i * ys] = alpha * sum;
+    }
+    else{
+      yd[i * ys] = alpha * sum + beta * yd[i * ys];
+    }
+  }
+}
+
+/**csr_mm - CSR MATRIX MATRIX
+  *Computes c = alpha * a.b + beta * c in O(nnz x b->size2). Each stored entry of a is applied to a whole row of b, so rows of b and c are streamed contiguously.
+  *b and c must not overlap.
+    * a. The sparse matrix.
+    * alpha. The scaling of a.b.
+    * b. The dense matrix to multiply, [a->cols x n].
+    * beta. The scaling of the existing c. If beta is 0.0 the existing contents of c are ignored.
+    * c. The dense matrix to write to, [a->rows x n].
+*/
+void csr_mm(const csr_matrix* a, double alpha, const gsl_matrix* b, double beta, gsl_matrix* c){
+  if(b->size1 != (size_t)a->cols || c->size1 != (size_t)a->rows || b->size2 != c->size2){
+    printf("Error: Matrix dimensions do not match. %d x %d . %d x %d -> %d x %d\n", a->rows, a->cols, (int)b->size1, (int)b->size2, (int)c->size1, (int)c->size2);
+    return;
+  }
+  const size_t n = b->size2;
+  for(int i = 0; i < a->rows; i++){
+    double* c_row = c->data + (i * c->tda);
+    if(beta == 0.0){
+      for(size_t j = 0; j < n; j++){
+        c_row[j] = 0.0;
+      }
+    }
+    else if(beta != 1.0){
+      for(size_t j = 0; j < n; j++){
+        c_row[j] *= beta;
+      }
+    }
+    for(int k = a->row_ptr[i]; k < a->row_ptr[i + 1]; k++){
+      double v = alpha * a->values[k];
+      const double* b_row = b->data + (a->col_idx[k] * b->tda);
+      for(size_t j = 0; j < n; j++){
+        c_row[j] += v * b_row[j];
+      }
+    }
+  }
+}
+
+/**csr_spectral_mv - CSR SPECTRAL MV
+  *A matrix_util_mv for csr_matrices, using csr_mv.
+*/
+static void csr_spectral_mv(const void* a, const gsl_vector* x, gsl_vector* y){
+  csr_mv((const csr_matrix*)a, 1.0, x, 0.0, y);
+}
+
+/**csr_spectral_radius - CSR SPECTRAL RADIUS
+  *Estimates the spectral radius of a square csr_matrix with spectral_radius_arnoldi (see matrix_util.h), at O(nnz) per iteration.
+    * a. The matrix.
+    * tol. The relative tolerance.
+    * max_iter. The maximum number of matrix-vector products.
+*/
+double csr_spectral_radius(const csr_matrix* a, double tol, int max_iter){
+  return spectral_radius_arnoldi(csr_spectral_mv, a, a->rows, tol, max_iter);
+}
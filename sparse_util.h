@@ -0,0 +1,103 @@
+#ifndef SU_H
+#define SU_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+#include "matrix_util.h"
+
+/**STRUCT csr_matrix
+ * A compressed sparse row (CSR) matrix. Only the nonzero entries are stored, row by row, so a matrix-vector product costs O(nnz) rather than O(rows x cols).
+  * rows - The number of rows.
+  * cols - The number of columns.
+  * nnz - The number of stored (nonzero) entries.
+  * row_ptr - A (rows + 1) long array. The entries of row i are stored at positions row_ptr[i] to row_ptr[i + 1] - 1 of col_idx and values.
+  * col_idx - A nnz long array giving the column of each stored entry. Columns are ascending within a row.
+  * values - A nnz long array giving the value of each stored entry.
+  * owner - 1 if the arrays belong to the matrix and are freed by csr_free, 0 if they point into memory owned elsewhere (e.g. a mapped model file).
+*/
+typedef struct csr_matrix{
+  int rows;
+  int cols;
+  int nnz;
+  int* row_ptr;
+  int* col_idx;
+  double* values;
+  int owner;
+} csr_matrix;
+
+/**csr_calloc - CSR CALLOC
+  *Allocates a csr_matrix of zeros, with no stored entries.
+    * rows. The number of rows.
+    * cols. The number of columns.
+*/
+csr_matrix* csr_calloc(int rows, int cols);
+
+/**csr_copy - CSR COPY
+  *Copies a csr_matrix into a newly allocated csr_matrix that owns its arrays.
+    * a. The matrix to copy.
+*/
+csr_matrix* csr_copy(const csr_matrix* a);
+
+/**csr_from_gsl_matrix - CSR FROM GSL MATRIX
+  *Compresses a dense gsl_matrix into a newly allocated csr_matrix, keeping every entry that is not exactly 0.0. Preserves the existing matrix.
+    * m. The matrix to compress.
+*/
+csr_matrix* csr_from_gsl_matrix(const gsl_matrix* m);
+
+/**csr_to_gsl_matrix - CSR TO GSL MATRIX
+  *Expands a csr_matrix into a newly allocated dense gsl_matrix.
+    * a. The matrix to expand.
+*/
+gsl_matrix* csr_to_gsl_matrix(const csr_matrix* a);
+
+/**csr_free - CSR FREE
+  *Frees a csr_matrix, and its arrays if it owns them.
+    * a. The matrix to free.
+*/
+void csr_free(csr_matrix* a);
+
+/**csr_density - CSR DENSITY
+  *Computes the fraction of entries of a csr_matrix which are stored, nnz / (rows x cols).
+    * a. The matrix to measure.
+*/
+double csr_density(const csr_matrix* a);
+
+/**csr_scale - CSR SCALE
+  *Multiplies every stored entry of a csr_matrix by x, in place.
+    * a. The matrix to scale.
+    * x. The scale factor.
+*/
+void csr_scale(csr_matrix* a, double x);
+
+/**csr_mv - CSR MATRIX VECTOR
+  *Computes y = alpha * a.x + beta * y in O(nnz). Each row is summed in ascending column order. x and y must not overlap.
+    * a. The sparse matrix.
+    * alpha. The scaling of a.x.
+    * x. The vector to multiply, of length a->cols.
+    * beta. The scaling of the existing y. If beta is 0.0 the existing contents of y are ignored.
+    * y. The vector to write to, of length a->rows.
+*/
+void csr_mv(const csr_matrix* a, double alpha, const gsl_vector* x, double beta, gsl_vector* y);
+
+/**csr_mm - CSR MATRIX MATRIX
+  *Computes c = alpha * a.b + beta * c in O(nnz x b->size2). Each stored entry of a is applied to a whole row of b, so rows of b and c are streamed contiguously.
+  *b and c must not overlap.
+    * a. The sparse matrix.
+    * alpha. The scaling of a.b.
+    * b. The dense matrix to multiply, [a->cols x n].
+    * beta. The scaling of the existing c. If beta is 0.0 the existing contents of c are ignored.
+    * c. The dense matrix to write to, [a->rows x n].
+*/
+void csr_mm(const csr_matrix* a, double alpha, const gsl_matrix* b, double beta, gsl_matrix* c);
+
+/**csr_spectral_radius - CSR SPECTRAL RADIUS
+  *Estimates the spectral radius of a square csr_matrix with spectral_radius_arnoldi (see matrix_util.h), at O(nnz) per iteration.
+    * a. The matrix.
+    * tol. The relative tolerance.
+    * max_iter. The maximum number of matrix-vector products.
+*/
+double csr_spectral_radius(const csr_matrix* a, double tol, int max_iter);
+
+#endif
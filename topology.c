@@ -0,0 +1,198 @@
+#include "topology.h"
+
+/**topology_alloc - TOPOLOGY ALLOC
+  *Allocates a structured resevoir. Returns NULL (after printing why) if the kind is unknown, nodes is below 2 or, for TOPOLOGY_JUMPS, jump is below 2 or
+  *leaves fewer than 3 nodes to join.
+    * kind. TOPOLOGY_CYCLE, TOPOLOGY_DELAY or TOPOLOGY_JUMPS.
+    * nodes. The number of nodes.
+    * jump. For TOPOLOGY_JUMPS, the distance between the nodes joined by jumps. Otherwise ignored.
+    * jump_weight. For TOPOLOGY_JUMPS, the weight of each jump. Otherwise ignored.
+*/
+topology* topology_alloc(int kind, int nodes, int jump, double jump_weight){
+  if(kind != TOPOLOGY_CYCLE && kind != TOPOLOGY_DELAY && kind != TOPOLOGY_JUMPS){
+    printf("topology_alloc: unknown topology %d.\n", kind);
+    return NULL;
+  }
+  if(nodes < 2){
+    printf("topology_alloc: a structured resevoir needs at least 2 nodes, not %d.\n", nodes);
+    return NULL;
+  }
+  if(kind == TOPOLOGY_JUMPS && (jump < 2 || nodes / jump < 3)){
+    printf("topology_alloc: a jump of %d does not join at least 3 of %d nodes.\n", jump, nodes);
+    return NULL;
+  }
+  topology* t = malloc(sizeof(topology));
+  t->kind = kind;
+  t->nodes = nodes;
+  t->jump = kind == TOPOLOGY_JUMPS ? jump : 0;
+  t->jump_weight = kind == TOPOLOGY_JUMPS ? jump_weight : 0.0;
+  t->jumps = kind == TOPOLOGY_JUMPS ? nodes / jump : 0;
+  return t;
+}
+
+/**topology_free - TOPOLOGY FREE
+  *Frees a topology.
+    * t. The topology to free.
+*/
+void topology_free(topology* t){
+  free(t);
+}
+
+/**topology_nnz - TOPOLOGY NNZ
+  *Counts the nonzero weights of a topology.
+    * t. The topology.
+*/
+int topology_nnz(const topology* t){
+  return (t->kind == TOPOLOGY_DELAY ? t->nodes - 1 : t->nodes) + (2 * t->jumps);
+}
+
+/**topology_to_gsl_matrix - TOPOLOGY TO GSL MATRIX
+  *Expands a topology into a newly allocated dense gsl_matrix.
+    * t. The topology to expand.
+*/
+gsl_matrix* topology_to_gsl_matrix(const topology* t){
+  gsl_matrix* m = gsl_matrix_calloc(t->nodes, t->nodes);
+  for(int i = 1; i < t->nodes; i++){
+    gsl_matrix_set(m, i, i - 1, 1.0);
+  }
+  if(t->kind != TOPOLOGY_DELAY){
+    gsl_matrix_set(m, 0, t->nodes - 1, 1.0);
+  }
+  for(int k = 0; k < t->jumps; k++){
+    int next = ((k + 1) % t->jumps) * t->jump;
+    gsl_matrix_set(m, k * t->jump, next, t->jump_weight);
+    gsl_matrix_set(m, next, k * t->jump, t->jump_weight);
+  }
+  return m;
+}
+
+/**topology_mv - TOPOLOGY MATRIX VECTOR
+  *Computes y = alpha * t.x + beta * y in O(nodes), as csr_mv. x and y must not overlap.
+    * t. The topology.
+    * alpha. The scaling of t.x.
+    * x. The vector to multiply, of length t->nodes.
+    * beta. The scaling of the existing y. If beta is 0.0 the existing contents of y are ignored.
+    * y. The vector to write to, of length t->nodes.
+*/
+void topology_mv(const topology* t, double alpha, const gsl_vector* x, double beta, gsl_vector* y){
+  if(x->size != (size_t)t->nodes || y->size != (size_t)t->nodes){
+    printf("Error: Matrix dimensions do not match. %d x %d . %d x 1 -> %d x 1\n", t->nodes, t->nodes, (int)x->size, (int)y->size);
+    return;
+  }
+  const double* xd = x->data;
+  const size_t xs = x->stride;
+  double* yd = y->data;
+  const size_t ys = y->stride;
+  double first = t->kind == TOPOLOGY_DELAY ? 0.0 : alpha * xd[(t->nodes - 1) * xs];
+  if(beta == 0.0){
+    yd[0] = first;
+    for(int i = 1; i < t->nodes; i++){
+      yd[i * ys] = alpha * xd[(i - 1) * xs];
+    }
+  }
+  else{
+    yd[0] = first + beta * yd[0];
+    for(int i = 1; i < t->nodes; i++){
+      yd[i * ys] = alpha * xd[(i - 1) * xs] + beta * yd[i * ys];
+    }
+  }
+  double a = alpha * t->jump_weight;
+  for(int k = 0; k < t->jumps; k++){
+    size_t prev = (size_t)(k == 0 ? t->jumps - 1 : k - 1) * t->jump;
+    size_t next = (size_t)(k + 1 == t->jumps ? 0 : k + 1) * t->jump;
+    yd[(size_t)k * t->jump * ys] += a * (xd[prev * xs] + xd[next * xs]);
+  }
+}
+
+/**topology_mm - TOPOLOGY MATRIX MATRIX
+  *Computes c = alpha * t.b + beta * c in O(nodes x b->size2), as csr_mm. Each row of c is a scaled copy of one or three rows of b, streamed contiguously.
+  *b and c must not overlap.
+    * t. The topology.
+    * alpha. The scaling of t.b.
+    * b. The [t->nodes x n] matrix to multiply.
+    * beta. The scaling of the existing c. If beta is 0.0 the existing contents of c are ignored.
+    * c. The [t->nodes x n] matrix to write to.
+*/
+void topology_mm(const topology* t, double alpha, const gsl_matrix* b, double beta, gsl_matrix* c){
+  if(b->size1 != (size_t)t->nodes || c->size1 != (size_t)t->nodes || b->size2 != c->size2){
+    printf("Error: Matrix dimensions do not match. %d x %d . %d x %d -> %d x %d\n", t->nodes, t->nodes, (int)b->size1, (int)b->size2, (int)c->size1,
+      (int)c->size2);
+    return;
+  }
+  const size_t n = b->size2;
+  for(int i = 0; i < t->nodes; i++){
+    double* c_row = gsl_matrix_ptr(c, i, 0);
+    if(i == 0 && t->kind == TOPOLOGY_DELAY){
+      for(size_t j = 0; j < n; j++){
+        c_row[j] = beta == 0.0 ? 0.0 : beta * c_row[j];
+      }
+      continue;
+    }
+    const double* b_row = gsl_matrix_const_ptr(b, i == 0 ? t->nodes - 1 : i - 1, 0);
+    if(beta == 0.0){
+      for(size_t j = 0; j < n; j++){
+        c_row[j] = alpha * b_row[j];
+      }
+    }
+    else{
+      for(size_t j = 0; j < n; j++){
+        c_row[j] = alpha * b_row[j] + beta * c_row[j];
+      }
+    }
+  }
+  double a = alpha * t->jump_weight;
+  for(int k = 0; k < t->jumps; k++){
+    double* c_row = gsl_matrix_ptr(c, (size_t)k * t->jump, 0);
+    const double* prev = gsl_matrix_const_ptr(b, (size_t)(k == 0 ? t->jumps - 1 : k - 1) * t->jump, 0);
+    const double* next = gsl_matrix_const_ptr(b, (size_t)(k + 1 == t->jumps ? 0 : k + 1) * t->jump, 0);
+    for(size_t j = 0; j < n; j++){
+      c_row[j] += a * (prev[j] + next[j]);
+    }
+  }
+}
+
+/**topology_mv_float - TOPOLOGY MATRIX VECTOR FLOAT
+  *Computes y += alpha * t.x in single precision, over contiguous arrays. x and y must not overlap.
+    * t. The topology.
+    * alpha. The scaling of t.x.
+    * x. The t->nodes long vector to multiply.
+    * y. The t->nodes long vector to add to.
+*/
+void topology_mv_float(const topology* t, float alpha, const float* x, float* y){
+  if(t->kind != TOPOLOGY_DELAY){
+    y[0] += alpha * x[t->nodes - 1];
+  }
+  for(int i = 1; i < t->nodes; i++){
+    y[i] += alpha * x[i - 1];
+  }
+  float a = alpha * (float)t->jump_weight;
+  for(int k = 0; k < t->jumps; k++){
+    size_t prev = (size_t)(k == 0 ? t->jumps - 1 : k - 1) * t->jump;
+    size_t next = (size_t)(k + 1 == t->jumps ? 0 : k + 1) * t->jump;
+    y[(size_t)k * t->jump] += a * (x[prev] + x[next]);
+  }
+}
+
+/**topology_spectral_mv - TOPOLOGY SPECTRAL MV
+  *A matrix_util_mv for topologies, using topology_mv.
+*/
+static void topology_spectral_mv(const void* a, const gsl_vector* x, gsl_vector* y){
+  topology_mv((const topology*)a, 1.0, x, 0.0, y);
+}
+
+/**topology_spectral_radius - TOPOLOGY SPECTRAL RADIUS
+  *Computes the spectral radius of a topology: exactly 1 for TOPOLOGY_CYCLE (a permutation) and 0 for TOPOLOGY_DELAY (nilpotent), and an estimate by
+  *spectral_radius_arnoldi (see matrix_util.h), at O(nodes) per iteration, for TOPOLOGY_JUMPS.
+    * t. The topology.
+    * tol. The relative tolerance.
+    * max_iter. The maximum number of matrix-vector products.
+*/
+double topology_spectral_radius(const topology* t, double tol, int max_iter){
+  if(t->kind == TOPOLOGY_CYCLE){
+    return 1.0;
+  }
+  if(t->kind == TOPOLOGY_DELAY){
+    return 0.0;
+  }
+  return spectral_radius_arnoldi(topology_spectral_mv, t, t->nodes, tol, max_iter);
+}
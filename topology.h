@@ -0,0 +1,105 @@
+#ifndef TP_H
+#define TP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+#include "matrix_util.h"
+
+/** TOPOLOGY_CYCLE, TOPOLOGY_DELAY, TOPOLOGY_JUMPS
+  * The structured resevoirs. In each, node i is fed by node i - 1 with weight 1.
+  * TOPOLOGY_CYCLE - A simple cycle: node 0 is also fed by node nodes - 1, so the weights are a cyclic permutation.
+  * TOPOLOGY_DELAY - A delay line: node 0 is fed by no node.
+  * TOPOLOGY_JUMPS - A cycle with jumps: as TOPOLOGY_CYCLE, and the nodes 0, jump, 2 * jump, ... below nodes are also joined in a ring of their own by
+    undirected edges of weight jump_weight.
+*/
+static const int TOPOLOGY_CYCLE = 1;
+static const int TOPOLOGY_DELAY = 2;
+static const int TOPOLOGY_JUMPS = 3;
+
+/**STRUCT topology
+ * A structured resevoir, stored implicitly. Its weights are a permutation (plus, for TOPOLOGY_JUMPS, a ring of jumps), so a matrix-vector product costs
+ * O(nodes) time and no memory beyond the vectors.
+  * kind - TOPOLOGY_CYCLE, TOPOLOGY_DELAY or TOPOLOGY_JUMPS.
+  * nodes - The order of the matrix.
+  * jump - The distance between the nodes joined by jumps, or 0.
+  * jump_weight - The weight of each jump, or 0.0.
+  * jumps - The number of nodes joined by jumps, nodes / jump, or 0.
+*/
+typedef struct topology{
+  int kind;
+  int nodes;
+  int jump;
+  double jump_weight;
+  int jumps;
+} topology;
+
+/**topology_alloc - TOPOLOGY ALLOC
+  *Allocates a structured resevoir. Returns NULL (after printing why) if the kind is unknown, nodes is below 2 or, for TOPOLOGY_JUMPS, jump is below 2 or
+  *leaves fewer than 3 nodes to join.
+    * kind. TOPOLOGY_CYCLE, TOPOLOGY_DELAY or TOPOLOGY_JUMPS.
+    * nodes. The number of nodes.
+    * jump. For TOPOLOGY_JUMPS, the distance between the nodes joined by jumps. Otherwise ignored.
+    * jump_weight. For TOPOLOGY_JUMPS, the weight of each jump. Otherwise ignored.
+*/
+topology* topology_alloc(int kind, int nodes, int jump, double jump_weight);
+
+/**topology_free - TOPOLOGY FREE
+  *Frees a topology.
+    * t. The topology to free.
+*/
+void topology_free(topology* t);
+
+/**topology_nnz - TOPOLOGY NNZ
+  *Counts the nonzero weights of a topology.
+    * t. The topology.
+*/
+int topology_nnz(const topology* t);
+
+/**topology_to_gsl_matrix - TOPOLOGY TO GSL MATRIX
+  *Expands a topology into a newly allocated dense gsl_matrix.
+    * t. The topology to expand.
+*/
+gsl_matrix* topology_to_gsl_matrix(const topology* t);
+
+/**topology_mv - TOPOLOGY MATRIX VECTOR
+  *Computes y = alpha * t.x + beta * y in O(nodes), as csr_mv. x and y must not overlap.
+    * t. The topology.
+    * alpha. The scaling of t.x.
+    * x. The vector to multiply, of length t->nodes.
+    * beta. The scaling of the existing y. If beta is 0.0 the existing contents of y are ignored.
+    * y. The vector to write to, of length t->nodes.
+*/
+void topology_mv(const topology* t, double alpha, const gsl_vector* x, double beta, gsl_vector* y);
+
+/**topology_mm - TOPOLOGY MATRIX MATRIX
+  *Computes c = alpha * t.b + beta * c in O(nodes x b->size2), as csr_mm. Each row of c is a scaled copy of one or three rows of b, streamed contiguously.
+  *b and c must not overlap.
+    * t. The topology.
+    * alpha. The scaling of t.b.
+    * b. The [t->nodes x n] matrix to multiply.
+    * beta. The scaling of the existing c. If beta is 0.0 the existing contents of c are ignored.
+    * c. The [t->nodes x n] matrix to write to.
+*/
+void topology_mm(const topology* t, double alpha, const gsl_matrix* b, double beta, gsl_matrix* c);
+
+/**topology_mv_float - TOPOLOGY MATRIX VECTOR FLOAT
+  *Computes y += alpha * t.x in single precision, over contiguous arrays. x and y must not overlap.
+    * t. The topology.
+    * alpha. The scaling of t.x.
+    * x. The t->nodes long vector to multiply.
+    * y. The t->nodes long vector to add to.
+*/
+void topology_mv_float(const topology* t, float alpha, const float* x, float* y);
+
+/**topology_spectral_radius - TOPOLOGY SPECTRAL RADIUS
+  *Computes the spectral radius of a topology: exactly 1 for TOPOLOGY_CYCLE (a permutation) and 0 for TOPOLOGY_DELAY (nilpotent), and an estimate by
+  *spectral_radius_arnoldi (see matrix_util.h), at O(nodes) per iteration, for TOPOLOGY_JUMPS.
+    * t. The topology.
+    * tol. The relative tolerance.
+    * max_iter. The maximum number of matrix-vector products.
+*/
+double topology_spectral_radius(const topology* t, double tol, int max_iter);
+
+#endif
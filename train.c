@@ -1,8 +1,107 @@
 #include "train.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
-train_table* get_table(train_dataset* dataset, const int type);
+/**train_table_alloc - TRAIN TABLE ALLOC
+  *Allocates a train_table with contiguous uN and y_target. The bias column of uN is set to 1 and the warmup input to [1, 0, ...]; the rest is uninitialized.
+    *inputs. The number of inputs, not counting the bias.
+    *outputs. The number of outputs.
+    *entries. The number of timesteps.
+    *warmups. The number of warmup steps.
+*/
+train_table* train_table_alloc(int inputs, int outputs, int entries, int warmups){
+  train_table* table = malloc(sizeof(train_table));
+  table->entries = entries;
+  table->warmups = warmups;
+  table->warmup_m = gsl_matrix_calloc(inputs + 1, 1);
+  gsl_matrix_set(table->warmup_m, 0, 0, 1.0);
+  table->uN = gsl_matrix_alloc(entries, inputs + 1);
+  gsl_vector_view bias = gsl_matrix_column(table->uN, 0);
+  gsl_vector_set_all(&bias.vector, 1.0);
+  table->y_target = gsl_matrix_alloc(entries, outputs);
+  table->sequences = 1;
+  table->starts = NULL;
+  table->washout_uN = NULL;
+  table->washout_starts = NULL;
+  return table;
+}
+
+/**train_table_alloc_sequences - TRAIN TABLE ALLOC SEQUENCES
+  *Allocates a train_table of several independent sequences, as train_table_alloc, with the sequences' entries stored back to back in uN and y_target and
+  *their washouts back to back in washout_uN (whose bias column is also set to 1). Returns NULL (after printing why) if a sequence is empty.
+    *inputs. The number of inputs, not counting the bias.
+    *outputs. The number of outputs.
+    *sequences. The number of sequences.
+    *lengths. The sequences long array of each sequence's number of entries. Each must be at least 1.
+    *washouts. NULL, or the sequences long array of each sequence's number of washout steps.
+    *warmups. The number of warmup steps run before each sequence.
+*/
+train_table* train_table_alloc_sequences(int inputs, int outputs, int sequences, const int* lengths, const int* washouts, int warmups){
+  int entries = 0;
+  int washout_rows = 0;
+  for(int s = 0; s < sequences; s++){
+    if(lengths[s] < 1 || (washouts != NULL && washouts[s] < 0)){
+      printf("train_table_alloc_sequences: sequence %d has %d entries and a washout of %d.\n", s, lengths[s], washouts != NULL ? washouts[s] : 0);
+      return NULL;
+    }
+    entries += lengths[s];
+    washout_rows += washouts != NULL ? washouts[s] : 0;
+  }
+
+  train_table* table = train_table_alloc(inputs, outputs, entries, warmups);
+  table->sequences = sequences;
+  table->starts = malloc((sequences + 1) * sizeof(int));
+  table->starts[0] = 0;
+  for(int s = 0; s < sequences; s++){
+    table->starts[s + 1] = table->starts[s] + lengths[s];
+  }
+  if(washout_rows > 0){
+    table->washout_uN = gsl_matrix_alloc(washout_rows, inputs + 1);
+    gsl_vector_view bias = gsl_matrix_column(table->washout_uN, 0);
+    gsl_vector_set_all(&bias.vector, 1.0);
+    table->washout_starts = malloc((sequences + 1) * sizeof(int));
+    table->washout_starts[0] = 0;
+    for(int s = 0; s < sequences; s++){
+      table->washout_starts[s + 1] = table->washout_starts[s] + washouts[s];
+    }
+  }
+  return table;
+}
 
+/**train_table_opens - TRAIN TABLE OPENS
+  *Returns the sequence a table's entry starts, if it starts any but the first, or -1. Every loop over a table's entries calls this for each entry and, when
+  *it returns a sequence, zeros the state and runs the warmup input and that sequence's washout before stepping the entry.
+    *table. The table.
+    *entry. The entry.
+*/
+int train_table_opens(const train_table* table, int entry){
+  if(table->starts == NULL || entry <= 0){
+    return -1;
+  }
+  int low = 1;
+  int high = table->sequences - 1;
+  while(low <= high){
+    int mid = (low + high) / 2;
+    if(table->starts[mid] == entry){
+      return mid;
+    }
+    if(table->starts[mid] < entry){
+      low = mid + 1;
+    }
+    else{
+      high = mid - 1;
+    }
+  }
+  return -1;
+}
 
+/**get_table - GET TABLE
+  *Gets one table of a dataset, or NULL for an unknown type.
+    *dataset. The dataset.
+    *type. TRAIN_CONST, VALIDATE_CONST or TEST_CONST.
+*/
 train_table* get_table(train_dataset* dataset, const int type){
   if(type == TRAIN_CONST){
     return dataset->train;
@@ -15,6 +114,78 @@ train_table* get_table(train_dataset* dataset, const int type){
   }
   return NULL;
 }
+/**train_symmetrize - TRAIN SYMMETRIZE
+  *Copies the lower triangle of a square matrix into its upper triangle.
+    *a. The matrix.
+*/
+void train_symmetrize(gsl_matrix* a){
+  for(size_t i = 0; i < a->size1; i++){
+    for(size_t j = i + 1; j < a->size2; j++){
+      gsl_matrix_set(a, i, j, gsl_matrix_get(a, j, i));
+    }
+  }
+}
+
+/**train_gram_add - TRAIN GRAM ADD
+  *Folds a block of harvested rows into X.Xt and y_target.Xt with a rank-k update (dsyrk, lower triangle only) and a dgemm. Call train_symmetrize on XXt once
+  *every block has been added.
+    *X_rows. The [rows x (1 + inputs + nodes)] block of Xt.
+    *y_rows. The matching [rows x outputs] block of y_target.
+    *XXt. The [(1 + inputs + nodes) x (1 + inputs + nodes)] matrix to add X.Xt to.
+    *y_Xt. The [outputs x (1 + inputs + nodes)] matrix to add y_target.Xt to.
+*/
+void train_gram_add(const gsl_matrix* X_rows, const gsl_matrix* y_rows, gsl_matrix* XXt, gsl_matrix* y_Xt){
+  PROFILE_BEGIN(PROFILE_GRAM);
+  gsl_blas_dsyrk(CblasLower, CblasTrans, 1.0, X_rows, 1.0, XXt);
+  gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, y_rows, X_rows, 1.0, y_Xt);
+  PROFILE_END(PROFILE_GRAM, ((double)X_rows->size2 * (X_rows->size2 + 1) + (2.0 * y_rows->size2 * X_rows->size2)) * X_rows->size1, 0);
+}
+
+/**train_warmup_into - TRAIN WARMUP INTO
+  *Starts one sequence of a table on a state held outside the ESN: zeros the state (unless it is the first sequence, which continues from the caller's
+  *state), then runs the table's warmup input and the sequence's washout with esn_step_into, swapping *state and *state_next after each step.
+    *esn. The ESN whose weights to use.
+    *table. The table whose warmups to run.
+    *sequence. The sequence to start.
+    *state, state_next. The state and scratch vectors, of length nodes. On return *state holds the warmed up state.
+*/
+void train_warmup_into(const ESN* esn, const train_table* table, int sequence, gsl_vector** state, gsl_vector** state_next){
+  PROFILE_BEGIN(PROFILE_WARMUP);
+  if(sequence > 0){
+    gsl_vector_set_zero(*state);
+  }
+  int washout_start = table->washout_uN != NULL ? table->washout_starts[sequence] : 0;
+  int washout_end = table->washout_uN != NULL ? table->washout_starts[sequence + 1] : 0;
+  for(int i = -table->warmups; i < washout_end - washout_start; i++){
+    gsl_vector_const_view uN_v = i < 0 ? gsl_matrix_const_column(table->warmup_m, 0) : gsl_matrix_const_row(table->washout_uN, washout_start + i);
+    esn_step_into(esn, &uN_v.vector, *state, *state_next);
+    gsl_vector* old_state = *state;
+    *state = *state_next;
+    *state_next = old_state;
+  }
+  PROFILE_END(PROFILE_WARMUP, 0, 0);
+}
+
+/**train_warmup - TRAIN WARMUP
+  *Starts one sequence of a table on the ESN's own state, as train_warmup_into.
+    *esn. The ESN to run.
+    *table. The table whose warmups to run.
+    *sequence. The sequence to start.
+*/
+void train_warmup(ESN* esn, const train_table* table, int sequence){
+  gsl_vector_view state_v = gsl_matrix_column(esn->state, 0);
+  gsl_vector_view next_v = gsl_matrix_column(esn->state_next, 0);
+  gsl_vector* state = &state_v.vector;
+  gsl_vector* state_next = &next_v.vector;
+  train_warmup_into(esn, table, sequence, &state, &state_next);
+  /* an odd number of steps leaves the warmed up state in state_next's storage, so swap as step_esn would */
+  if(state != &state_v.vector){
+    gsl_matrix* old_state = esn->state;
+    esn->state = esn->state_next;
+    esn->state_next = old_state;
+  }
+}
+
 /**train_get_X - TRAIN GET X
   *Gets the Matrix X for a given ESN and table. X is the matrix formed by [1, uN, state] for each input.
     *esn. The ESN to produce X for.
@@ -22,24 +193,125 @@ train_table* get_table(train_dataset* dataset, const int type){
 */
 gsl_matrix* train_get_X(ESN* esn, train_table* table){
   gsl_matrix* X = gsl_matrix_alloc(1 + esn->inputs + esn->nodes, table->entries);
-  for(int i = 0; i < table->warmups; i++){
-    update_esn(esn, table->warmup_m);
-  }
+  train_warmup(esn, table, 0);
+  PROFILE_BEGIN(PROFILE_HARVEST);
   for(int i = 0; i < table->entries; i++){
-    update_esn(esn, table->uN[i]);
+    int sequence = train_table_opens(table, i);
+    if(sequence > 0){
+      train_warmup(esn, table, sequence);
+    }
+    gsl_vector_const_view uN_v = gsl_matrix_const_row(table->uN, i);
+    step_esn(esn, &uN_v.vector);
     for(int j = 0; j < esn->inputs + 1; j++){
-      gsl_matrix_set(X, j, i, gsl_matrix_get(table->uN[i], j, 0));
+      gsl_matrix_set(X, j, i, gsl_vector_get(&uN_v.vector, j));
     }
     for(int j = 0; j < esn->nodes; j++){
       gsl_matrix_set(X, j + 1 + esn->inputs, i, gsl_matrix_get(esn->state, j, 0));
     }
   }
+  PROFILE_END(PROFILE_HARVEST, 0, X->size1 * X->size2 * sizeof(double));
   return X;
 }
 
+/**train_get_rows - TRAIN GET ROWS
+  *Runs an ESN over the next entries of a table, writing one row of Xt ([1, uN, state]) and of y_target per timestep. Rows are contiguous, so each state is
+  *a single copy. A new sequence is started (see train_warmup) at every entry which opens one. Returns how many rows were written - X_rows->size1, or fewer
+  *at end.
+    *esn. The ESN to run.
+    *table. The table to run it over.
+    *start. The first entry to run.
+    *end. The entry to stop before, usually table->entries.
+    *X_rows. The [rows x (1 + inputs + nodes)] matrix to write states to.
+    *y_rows. Either NULL or the [rows x outputs] matrix to write targets (rows of y_target) to.
+*/
+static int train_get_rows(ESN* esn, train_table* table, int start, int end, gsl_matrix* X_rows, gsl_matrix* y_rows){
+  PROFILE_BEGIN(PROFILE_HARVEST);
+  int count = end - start;
+  if(count > (int)X_rows->size1){
+    count = X_rows->size1;
+  }
+  for(int i = 0; i < count; i++){
+    int sequence = train_table_opens(table, start + i);
+    if(sequence > 0){
+      train_warmup(esn, table, sequence);
+    }
+    const double* uN = gsl_matrix_const_ptr(table->uN, start + i, 0);
+    gsl_vector_const_view uN_v = gsl_matrix_const_row(table->uN, start + i);
+    step_esn(esn, &uN_v.vector);
+    double* row = gsl_matrix_ptr(X_rows, i, 0);
+    for(int j = 0; j < esn->inputs + 1; j++){
+      row[j] = uN[j];
+    }
+    for(int j = 0; j < esn->nodes; j++){
+      row[j + 1 + esn->inputs] = gsl_matrix_get(esn->state, j, 0);
+    }
+    if(y_rows != NULL){
+      gsl_vector_view y_row = gsl_matrix_row(y_rows, i);
+      gsl_matrix_get_row(&y_row.vector, table->y_target, start + i);
+    }
+  }
+  PROFILE_END(PROFILE_HARVEST, 0, 0);
+  return count;
+}
+
+/**train_get_Xt - TRAIN GET XT
+  *Gets the transpose of train_get_X's X, one row per timestep. This is the layout least squares solvers take.
+    *esn. The ESN to produce Xt for.
+    *table. The table to produce Xt from.
+*/
+gsl_matrix* train_get_Xt(ESN* esn, train_table* table){
+  gsl_matrix* Xt = gsl_matrix_alloc(table->entries, 1 + esn->inputs + esn->nodes);
+  PROFILE_COUNT(PROFILE_HARVEST, 0, Xt->size1 * Xt->size2 * sizeof(double));
+  train_warmup(esn, table, 0);
+  train_get_rows(esn, table, 0, table->entries, Xt, NULL);
+  return Xt;
+}
+
+/**train_gram_range - TRAIN GRAM RANGE
+  *Computes X.Xt and y_target.Xt over a range of a table's entries, as train_get_gram, continuing from the ESN's current state.
+    *esn. The ESN to run.
+    *table. The table to run it over.
+    *start. The first entry.
+    *end. The entry to stop before.
+    *XXt, y_Xt. As train_get_gram.
+*/
+static void train_gram_range(ESN* esn, train_table* table, int start, int end, gsl_matrix* XXt, gsl_matrix* y_Xt){
+  int rows = 1 + esn->inputs + esn->nodes;
+  gsl_matrix* X_block = gsl_matrix_alloc(TRAIN_GRAM_BLOCK, rows);
+  gsl_matrix* y_block = gsl_matrix_alloc(TRAIN_GRAM_BLOCK, esn->outputs);
+  gsl_matrix_set_zero(XXt);
+  gsl_matrix_set_zero(y_Xt);
+  PROFILE_COUNT(PROFILE_GRAM, 0, (X_block->size1 * X_block->size2 + y_block->size1 * y_block->size2) * sizeof(double));
+
+  while(start < end){
+    int filled = train_get_rows(esn, table, start, end, X_block, y_block);
+    start += filled;
+    gsl_matrix_const_view X_v = gsl_matrix_const_submatrix(X_block, 0, 0, filled, rows);
+    gsl_matrix_const_view y_v = gsl_matrix_const_submatrix(y_block, 0, 0, filled, esn->outputs);
+    train_gram_add(&X_v.matrix, &y_v.matrix, XXt, y_Xt);
+  }
+  train_symmetrize(XXt);
+  gsl_matrix_free(X_block);
+  gsl_matrix_free(y_block);
+}
+
+/**train_get_gram - TRAIN GET GRAM
+  *Computes X.Xt and y_target.Xt for a given ESN and table without forming X (see train_get_X). States are buffered TRAIN_GRAM_BLOCK timesteps at a time and
+  *folded in with dsyrk and dgemm, so memory is O((1 + inputs + nodes)^2) whatever the table length.
+    *esn. The ESN to run.
+    *table. The table to run it over.
+    *XXt. The [(1 + inputs + nodes) x (1 + inputs + nodes)] matrix to write X.Xt to. Both triangles are written.
+    *y_Xt. The [outputs x (1 + inputs + nodes)] matrix to write y_target.Xt to.
+*/
+void train_get_gram(ESN* esn, train_table* table, gsl_matrix* XXt, gsl_matrix* y_Xt){
+  train_warmup(esn, table, 0);
+  train_gram_range(esn, table, 0, table->entries, XXt, y_Xt);
+}
+
 /**train_esn_pinverse - TRAIN ESN PSEUDOINVERSE
   *Trains an ESN using the pinverse method.
   * Wout = y_target . pinverse(X).
+  *This is solved as the least squares problem Xt.Woutt = y_targett with moore_penrose_lstsq, so pinverse(X) is never formed and memory is O(N x entries).
     *esn. The esn to train. state is reset to zeros at start and end.
     *dataset. The dataset to train against.
     *type. The table of the dataset to use. Typically 0 (train).
@@ -51,22 +323,90 @@ void train_esn_pinverse(ESN* esn, train_dataset* dataset, const int type){
 
   train_table* table = get_table(dataset, type);
 
-  gsl_matrix* X = train_get_X(esn, table);
+  gsl_matrix* Xt = train_get_Xt(esn, table);
 
-  gsl_matrix* xInv = gsl_matrix_pinv(X, 0.0000001);
+  PROFILE_BEGIN(PROFILE_SOLVE);
+  gsl_matrix* wOut_t = moore_penrose_lstsq(Xt, table->y_target, 0.0000001);
+  PROFILE_END(PROFILE_SOLVE, (4.0 * Xt->size1 * Xt->size2 * Xt->size2) + (8.0 * Xt->size2 * Xt->size2 * Xt->size2), Xt->size2 * Xt->size2 * sizeof(double));
 
-  gsl_matrix* y_target = gsl_matrix_alloc(esn->outputs, table->entries);
+  gsl_matrix_transpose_memcpy(esn->wOut, wOut_t);
 
-  for(int i = 0; i < table->entries; i++){
-    gsl_matrix_set(y_target, 0, i, table->y_target[i]);
+  gsl_matrix_free(Xt);
+  gsl_matrix_free(wOut_t);
+
+  for(int i = 0; i < esn->nodes; i++){
+    gsl_matrix_set(esn->state, i, 0, 0.0);
   }
+}
 
-  gsl_matrix_free(esn->wOut);
-  esn->wOut = gsl_matrix_multiply(y_target, xInv);
+/**train_esn_qr - TRAIN ESN QR
+  *Trains an ESN by least squares, as train_esn_pinverse, but streams the table through a QR factorization so memory is O(N^2) whatever the table length.
+  *Blocks of max(N, TRAIN_GRAM_BLOCK) rows of Xt are stacked under the running triangular factor R and refactorized, with Qt applied to y_target alongside;
+  *at the end R.Woutt = Qt.y_targett is solved by back substitution. Unlike the normal equations this never squares the condition number of X. If R is
+  *numerically singular wOut is left unchanged - use train_esn_pinverse or train_esn_ridge_regression instead.
+    *esn. The esn to train. state is reset to zeros at start and end.
+    *dataset. The dataset to train against.
+    *type. The table of the dataset to use. Typically 0 (train).
+*/
+void train_esn_qr(ESN* esn, train_dataset* dataset, const int type){
+  for(int i = 0; i < esn->nodes; i++){
+    gsl_matrix_set(esn->state, i, 0, 0.0);
+  }
 
-  gsl_matrix_free(X);
-  gsl_matrix_free(xInv);
-  gsl_matrix_free(y_target);
+  train_table* table = get_table(dataset, type);
+
+  int rows = 1 + esn->inputs + esn->nodes;
+  int block = rows > TRAIN_GRAM_BLOCK ? rows : TRAIN_GRAM_BLOCK;
+
+  /* [R; next rows of Xt] and [Qt.y_targett; next rows of y_targett] */
+  gsl_matrix* S = gsl_matrix_calloc(rows + block, rows);
+  gsl_matrix* z = gsl_matrix_calloc(rows + block, esn->outputs);
+  gsl_vector* tau = gsl_vector_alloc(rows);
+  PROFILE_COUNT(PROFILE_SOLVE, 0, (rows + block) * (rows + esn->outputs) * sizeof(double));
+
+  train_warmup(esn, table, 0);
+  for(int start = 0; start < table->entries;){
+    gsl_matrix_view S_new = gsl_matrix_submatrix(S, rows, 0, block, rows);
+    gsl_matrix_view z_new = gsl_matrix_submatrix(z, rows, 0, block, esn->outputs);
+    int filled = train_get_rows(esn, table, start, table->entries, &S_new.matrix, &z_new.matrix);
+    start += filled;
+
+    PROFILE_BEGIN(PROFILE_SOLVE);
+    gsl_matrix_view S_v = gsl_matrix_submatrix(S, 0, 0, rows + filled, rows);
+    gsl_matrix_view z_v = gsl_matrix_submatrix(z, 0, 0, rows + filled, esn->outputs);
+    gsl_linalg_QR_decomp(&S_v.matrix, tau);
+    gsl_linalg_QR_QTmat(&S_v.matrix, tau, &z_v.matrix);
+    PROFILE_END(PROFILE_SOLVE, 2.0 * rows * rows * (rows + filled + (2.0 * esn->outputs)), 0);
+
+    /* keep R, dropping the Householder vectors stored below its diagonal */
+    for(int i = 1; i < rows; i++){
+      for(int j = 0; j < i; j++){
+        gsl_matrix_set(S, i, j, 0.0);
+      }
+    }
+  }
+
+  gsl_matrix_view R = gsl_matrix_submatrix(S, 0, 0, rows, rows);
+  gsl_matrix_view wOut_t = gsl_matrix_submatrix(z, 0, 0, rows, esn->outputs);
+
+  double r_max = 0.0;
+  double r_min = INFINITY;
+  for(int i = 0; i < rows; i++){
+    double r = fabs(gsl_matrix_get(&R.matrix, i, i));
+    r_max = r > r_max ? r : r_max;
+    r_min = r < r_min ? r : r_min;
+  }
+  if(!(r_min > r_max * DBL_EPSILON * rows)){
+    printf("train_esn_qr: X is rank deficient, wOut left unchanged.\n");
+  }
+  else{
+    gsl_blas_dtrsm(CblasLeft, CblasUpper, CblasNoTrans, CblasNonUnit, 1.0, &R.matrix, &wOut_t.matrix);
+    gsl_matrix_transpose_memcpy(esn->wOut, &wOut_t.matrix);
+  }
+
+  gsl_matrix_free(S);
+  gsl_matrix_free(z);
+  gsl_vector_free(tau);
 
   for(int i = 0; i < esn->nodes; i++){
     gsl_matrix_set(esn->state, i, 0, 0.0);
@@ -79,77 +419,715 @@ void train_esn_pinverse(ESN* esn, train_dataset* dataset, const int type){
     *esn. The esn to train. state is reset to zeros at start and end.
     *dataset. The dataset to train against.
     *train_type. The table of the dataset to use for training. Typically 0 (train).
-    *beta_type. he table of the dataset to use for validating different beta values. Typically 1 (validate).
+    *beta_type. he table of the dataset to use for validating different beta values. Typically 1 (validate). It is harvested once and every beta is
+      scored against the harvest.
     *betas. The set of beta parameters to use. Each is used for training and the one that maximises the beta_type table's NMSE is the final one used.
     *beta_count. The number of beta parameters.
+  *This is a wrapper for train_esn_ridge_regression_solver using RIDGE_AUTO.
 */
 void train_esn_ridge_regression(ESN* esn, train_dataset* dataset, const int train_type, const int beta_type, double* betas, int beta_count){
+  train_esn_ridge_regression_solver(esn, dataset, train_type, beta_type, betas, beta_count, RIDGE_AUTO);
+}
 
-  for(int i = 0; i < esn->nodes; i++){
-    gsl_matrix_set(esn->state, i, 0, 0.0);
+/** TRAIN_JOB_GRAM, TRAIN_JOB_HARVEST, TRAIN_JOB_HARVEST_GRAM, TRAIN_JOB_NMSE, TRAIN_JOB_GRAM_RANGE, TRAIN_JOB_GRAM_RUNS
+  *The table passes train_run_jobs can run: train_get_gram_threads, train_harvest_table, train_harvest_table_gram, nmse, the Gram matrix of a run of
+  *sequences and one thread's share of the runs of a train_get_gram_threads.
+*/
+static const int TRAIN_JOB_GRAM = 0;
+static const int TRAIN_JOB_HARVEST = 1;
+static const int TRAIN_JOB_HARVEST_GRAM = 2;
+static const int TRAIN_JOB_NMSE = 3;
+static const int TRAIN_JOB_GRAM_RANGE = 4;
+static const int TRAIN_JOB_GRAM_RUNS = 5;
+
+/** STRUCT train_gram_runs - TRAIN GRAM RUNS
+  *The runs of one train_get_gram_threads, shared by its threads.
+    *bounds. The count + 1 long array of the entry each run starts at, followed by the table's entries.
+    *count. The number of runs.
+    *next. The index of the next unclaimed run.
+    *added. How many runs have been added to XXt and y_Xt. Runs are added strictly in order.
+    *lock, summed. Guard added and signal each time it grows.
+    *XXt, y_Xt. The totals.
+*/
+typedef struct train_gram_runs{
+  int* bounds;
+  int count;
+  atomic_int next;
+  int added;
+  pthread_mutex_t lock;
+  pthread_cond_t summed;
+  gsl_matrix* XXt;
+  gsl_matrix* y_Xt;
+} train_gram_runs;
+
+/** STRUCT train_job - TRAIN JOB
+  *One pass over one table, run by train_run_jobs.
+    *kind. Which pass, TRAIN_JOB_GRAM, TRAIN_JOB_HARVEST, TRAIN_JOB_HARVEST_GRAM, TRAIN_JOB_NMSE, TRAIN_JOB_GRAM_RANGE or TRAIN_JOB_GRAM_RUNS.
+    *view. A shallow copy of the ESN being run. It shares the ESN's weights but has a state of its own, so passes over different tables never interfere.
+    *dataset. The dataset, or NULL for a TRAIN_JOB_GRAM_RANGE pass.
+    *type. The table of the dataset to run.
+    *table. The table to run.
+    *start, end. The entries a TRAIN_JOB_GRAM_RANGE pass runs, from the start of one sequence to the start of another (or the end of the table).
+    *threads. The threads a TRAIN_JOB_GRAM pass may use, as train_get_gram_threads.
+    *XXt, y_Xt. The matrices a TRAIN_JOB_GRAM or TRAIN_JOB_GRAM_RANGE pass writes to, or a TRAIN_JOB_GRAM_RUNS pass harvests each run into, allocated by
+    *the caller.
+    *runs. The runs a TRAIN_JOB_GRAM_RUNS pass claims.
+    *harvest. The harvest a TRAIN_JOB_HARVEST or TRAIN_JOB_HARVEST_GRAM pass produces.
+    *score. The NMSE a TRAIN_JOB_NMSE pass produces.
+*/
+typedef struct train_job{
+  int kind;
+  ESN view;
+  train_dataset* dataset;
+  int type;
+  train_table* table;
+  int start;
+  int end;
+  int threads;
+  gsl_matrix* XXt;
+  gsl_matrix* y_Xt;
+  train_gram_runs* runs;
+  train_harvest* harvest;
+  double score;
+} train_job;
+
+/** STRUCT train_job_queue - TRAIN JOB QUEUE
+  *The jobs shared by the threads of one train_run_jobs.
+    *jobs. The jobs.
+    *count. The number of jobs.
+    *next. The index of the next unclaimed job.
+*/
+typedef struct train_job_queue{
+  train_job* jobs;
+  int count;
+  atomic_int next;
+} train_job_queue;
+
+/**train_job_init - TRAIN JOB INIT
+  *Prepares a job with a zero state of its own.
+    *job. The job to prepare.
+    *kind. The pass to run.
+    *esn. The ESN whose weights to use.
+    *dataset. The dataset, or NULL to set table directly.
+    *type. The table of the dataset to run.
+*/
+static void train_job_init(train_job* job, int kind, const ESN* esn, train_dataset* dataset, int type){
+  job->kind = kind;
+  job->view = *esn;
+  job->view.state = gsl_matrix_calloc(esn->nodes, 1);
+  job->view.state_next = gsl_matrix_calloc(esn->nodes, 1);
+  job->view.map = NULL;
+  job->dataset = dataset;
+  job->type = type;
+  job->table = dataset != NULL ? get_table(dataset, type) : NULL;
+  job->start = 0;
+  job->end = 0;
+  job->threads = 1;
+  job->XXt = NULL;
+  job->y_Xt = NULL;
+  job->runs = NULL;
+  job->harvest = NULL;
+  job->score = 0.0;
+}
+
+/**train_job_free - TRAIN JOB FREE
+  *Frees a job's state. Its results (and the shared weights) are left alone.
+    *job. The job.
+*/
+static void train_job_free(train_job* job){
+  gsl_matrix_free(job->view.state);
+  gsl_matrix_free(job->view.state_next);
+}
+
+/**train_gram_runs_work - TRAIN GRAM RUNS WORK
+  *Claims runs of a train_get_gram_threads until none remain, harvesting each into the job's XXt and y_Xt and adding it to the totals once every earlier run
+  *has been added. Runs are claimed in order, so the run a thread waits on is always being harvested or added by another.
+    *job. The TRAIN_JOB_GRAM_RUNS job.
+*/
+static void train_gram_runs_work(train_job* job){
+  train_gram_runs* runs = job->runs;
+  int k;
+  while((k = atomic_fetch_add(&runs->next, 1)) < runs->count){
+    /* every run but the first starts a sequence, which resets the state, so the state carried over from the job's last run never leaks in */
+    if(runs->bounds[k] == 0){
+      train_warmup(&job->view, job->table, 0);
+    }
+    train_gram_range(&job->view, job->table, runs->bounds[k], runs->bounds[k + 1], job->XXt, job->y_Xt);
+
+    pthread_mutex_lock(&runs->lock);
+    while(runs->added < k){
+      pthread_cond_wait(&runs->summed, &runs->lock);
+    }
+    pthread_mutex_unlock(&runs->lock);
+    PROFILE_BEGIN(PROFILE_GRAM);
+    gsl_matrix_add(runs->XXt, job->XXt);
+    gsl_matrix_add(runs->y_Xt, job->y_Xt);
+    PROFILE_END(PROFILE_GRAM, (double)(runs->XXt->size1 * runs->XXt->size2 + runs->y_Xt->size1 * runs->y_Xt->size2), 0);
+    pthread_mutex_lock(&runs->lock);
+    runs->added = k + 1;
+    pthread_cond_broadcast(&runs->summed);
+    pthread_mutex_unlock(&runs->lock);
   }
+}
 
-  train_table* table = get_table(dataset, train_type);
+/**train_job_run - TRAIN JOB RUN
+  *Runs a job's pass.
+    *job. The job.
+*/
+static void train_job_run(train_job* job){
+  if(job->kind == TRAIN_JOB_GRAM){
+    train_get_gram_threads(&job->view, job->table, job->XXt, job->y_Xt, job->threads);
+  }
+  else if(job->kind == TRAIN_JOB_GRAM_RANGE){
+    if(job->start == 0){
+      train_warmup(&job->view, job->table, 0);
+    }
+    train_gram_range(&job->view, job->table, job->start, job->end, job->XXt, job->y_Xt);
+  }
+  else if(job->kind == TRAIN_JOB_GRAM_RUNS){
+    train_gram_runs_work(job);
+  }
+  else if(job->kind == TRAIN_JOB_HARVEST){
+    job->harvest = train_harvest_table(&job->view, job->dataset, job->type);
+  }
+  else if(job->kind == TRAIN_JOB_HARVEST_GRAM){
+    job->harvest = train_harvest_table_gram(&job->view, job->dataset, job->type);
+  }
+  else{
+    job->score = nmse(&job->view, job->dataset, job->type);
+  }
+}
 
-  gsl_matrix* X = train_get_X(esn, table);
+/**train_job_worker - TRAIN JOB WORKER
+  *Claims and runs jobs until none remain.
+    *arg. The train_job_queue.
+*/
+static void* train_job_worker(void* arg){
+  train_job_queue* queue = arg;
+  int i;
+  while((i = atomic_fetch_add(&queue->next, 1)) < queue->count){
+    train_job_run(&queue->jobs[i]);
+  }
+  return NULL;
+}
 
-  gsl_matrix* XXt = gsl_matrix_multiply_transpose_b(X, X);
+/** STRUCT train_job_helper - TRAIN JOB HELPER
+  *A thread started by train_run_jobs.
+    *queue. The jobs.
+    *profile. The thread's profile counters, handed back so its work is credited to the thread that started it.
+*/
+typedef struct train_job_helper{
+  train_job_queue* queue;
+  profile_report profile;
+} train_job_helper;
 
-  gsl_matrix* y_target = gsl_matrix_alloc(esn->outputs, table->entries);
+/**train_job_help - TRAIN JOB HELP
+  *The body of a helper thread: runs jobs as train_job_worker and records what it profiled.
+    *arg. The train_job_helper.
+*/
+static void* train_job_help(void* arg){
+  train_job_helper* helper = arg;
+  profile_reset();
+  train_job_worker(helper->queue);
+  profile_get(&helper->profile);
+  return NULL;
+}
 
-  gsl_matrix* id = gsl_matrix_alloc(XXt->size1, XXt->size2);
+/**train_run_jobs - TRAIN RUN JOBS
+  *Runs jobs on up to threads threads, the calling thread being one of them, and returns when all are done. The helper threads' profile counters are
+  *merged into the calling thread's, so profiling sees the same work however many threads ran it.
+    *jobs. The jobs.
+    *count. The number of jobs.
+    *threads. The most threads to use. 0 (or more than count) uses one per job; 1 runs every job on the calling thread.
+*/
+static void train_run_jobs(train_job* jobs, int count, int threads){
+  if(threads <= 0 || threads > count){
+    threads = count;
+  }
+  train_job_queue queue;
+  queue.jobs = jobs;
+  queue.count = count;
+  atomic_init(&queue.next, 0);
+
+  int helpers = threads - 1;
+  pthread_t workers[helpers > 0 ? helpers : 1];
+  train_job_helper helper[helpers > 0 ? helpers : 1];
+  int started = 0;
+  for(int i = 0; i < helpers; i++){
+    helper[started].queue = &queue;
+    if(pthread_create(&workers[started], NULL, train_job_help, &helper[started]) == 0){
+      started++;
+    }
+  }
+  train_job_worker(&queue);
+  for(int i = 0; i < started; i++){
+    pthread_join(workers[i], NULL);
+    profile_merge(&helper[i].profile);
+  }
+}
 
-  gsl_matrix_set_identity(id);
+/**train_partition - TRAIN PARTITION
+  *Splits a table into contiguous runs of entries. If the table has at least parts sequences each run is whole sequences, balanced by entries, so runs can be
+  *harvested independently; otherwise the entries are split evenly, regardless of sequences.
+    *table. The table to split.
+    *parts. The number of runs, at least 1 and at most table->entries.
+    *bounds. The parts + 1 long array to write the entry each run starts at to, followed by table->entries.
+*/
+static void train_partition(const train_table* table, int parts, int* bounds){
+  bounds[0] = 0;
+  if(table->sequences < parts){
+    for(int k = 1; k <= parts; k++){
+      bounds[k] = (int)((int64_t)table->entries * k / parts);
+    }
+    return;
+  }
+  int first = 0;
+  for(int k = 0; k < parts; k++){
+    int last = table->sequences;
+    if(k + 1 < parts){
+      /* the first sequence starting past this run's share, leaving at least one sequence per later run */
+      int64_t goal = (int64_t)table->entries * (k + 1) / parts;
+      last = first + 1;
+      while(last < table->sequences - (parts - 1 - k) && table->starts[last] < goal){
+        last++;
+      }
+    }
+    bounds[k + 1] = table->starts != NULL ? table->starts[last] : table->entries;
+    first = last;
+  }
+}
 
-  for(int i = 0; i < table->entries; i++){
-    gsl_matrix_set(y_target, 0, i, table->y_target[i]);
+/**train_get_gram_threads - TRAIN GET GRAM THREADS
+  *Computes X.Xt and y_target.Xt as train_get_gram, harvesting a table of several sequences on several threads. The sequences are split into
+  *min(sequences, entries / TRAIN_GRAM_RUN rounded up) contiguous runs, balanced by entries, whatever the thread count. Each thread claims the next run,
+  *harvests it into its own X.Xt and y_target.Xt with a state of its own and adds that to the total once every earlier run has been added, so the result
+  *depends on neither the thread count nor scheduling and differs from train_get_gram's by summation order alone. A table of one run is harvested on the
+  *calling thread. esn->state is not touched.
+    *esn. The ESN to run. It must not be modified until the call returns.
+    *table. The table to run it over.
+    *XXt. The [(1 + inputs + nodes) x (1 + inputs + nodes)] matrix to write X.Xt to. Both triangles are written.
+    *y_Xt. The [outputs x (1 + inputs + nodes)] matrix to write y_target.Xt to.
+    *threads. How many threads to use, 0 for one per core.
+*/
+void train_get_gram_threads(ESN* esn, train_table* table, gsl_matrix* XXt, gsl_matrix* y_Xt, int threads){
+  int64_t wanted = ((int64_t)table->entries + TRAIN_GRAM_RUN - 1) / TRAIN_GRAM_RUN;
+  int parts = wanted < table->sequences ? (int)wanted : table->sequences;
+  if(parts <= 1){
+    train_job job;
+    train_job_init(&job, TRAIN_JOB_GRAM_RANGE, esn, NULL, 0);
+    job.table = table;
+    job.end = table->entries;
+    job.XXt = XXt;
+    job.y_Xt = y_Xt;
+    train_job_run(&job);
+    train_job_free(&job);
+    return;
+  }
+  if(threads <= 0){
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if(threads > parts){
+    threads = parts;
+  }
+  if(threads < 1){
+    threads = 1;
   }
 
-  gsl_matrix* y_Xt = gsl_matrix_multiply_transpose_b(y_target, X);
+  train_gram_runs runs;
+  runs.bounds = malloc((parts + 1) * sizeof(int));
+  train_partition(table, parts, runs.bounds);
+  runs.count = parts;
+  atomic_init(&runs.next, 0);
+  runs.added = 0;
+  pthread_mutex_init(&runs.lock, NULL);
+  pthread_cond_init(&runs.summed, NULL);
+  runs.XXt = XXt;
+  runs.y_Xt = y_Xt;
+  gsl_matrix_set_zero(XXt);
+  gsl_matrix_set_zero(y_Xt);
 
-  gsl_matrix* best_wOut = esn->wOut;
-  double best_score = 99999999999999.9;
+  train_job* jobs = malloc(threads * sizeof(train_job));
+  for(int k = 0; k < threads; k++){
+    train_job_init(&jobs[k], TRAIN_JOB_GRAM_RUNS, esn, NULL, 0);
+    jobs[k].table = table;
+    jobs[k].XXt = gsl_matrix_alloc(XXt->size1, XXt->size2);
+    jobs[k].y_Xt = gsl_matrix_alloc(y_Xt->size1, y_Xt->size2);
+    jobs[k].runs = &runs;
+  }
+  train_run_jobs(jobs, threads, threads);
 
-  for(int i = 0; i < beta_count; i++){
-    double beta = betas[i];
+  for(int k = 0; k < threads; k++){
+    gsl_matrix_free(jobs[k].XXt);
+    gsl_matrix_free(jobs[k].y_Xt);
+    train_job_free(&jobs[k]);
+  }
+  pthread_mutex_destroy(&runs.lock);
+  pthread_cond_destroy(&runs.summed);
+  free(runs.bounds);
+  free(jobs);
+}
 
-    gsl_matrix* beta_id = gsl_matrix_alloc(XXt->size1, XXt->size2);
-    gsl_matrix_memcpy(beta_id, id);
-    gsl_matrix_scale(beta_id, beta);
+/**train_ridge_path_flops - TRAIN RIDGE PATH FLOPS
+  *Estimates the flops ridge_path_alloc spends factorizing an [n x n] Gram matrix (the symmetric eigendecomposition dominates, at about 9n^3).
+    *n. The size of the Gram matrix.
+*/
+static double train_ridge_path_flops(size_t n){
+  return 9.0 * n * n * n;
+}
+
+/**train_ridge_path_solve_flops - TRAIN RIDGE PATH SOLVE FLOPS
+  *Estimates the flops ridge_path_solve spends on one beta.
+    *n. The size of the Gram matrix.
+    *outputs. The number of outputs.
+*/
+static double train_ridge_path_solve_flops(size_t n, size_t outputs){
+  return 2.0 * outputs * n * (n + 1);
+}
+
+/**train_ridge_cholesky_flops - TRAIN RIDGE CHOLESKY FLOPS
+  *Estimates the flops one Cholesky factorization and multi-RHS solve of XXt + beta I spends on one beta.
+    *n. The size of the Gram matrix.
+    *outputs. The number of outputs.
+*/
+static double train_ridge_cholesky_flops(size_t n, size_t outputs){
+  return (n * n * (n + 6.0 * outputs)) / 3.0;
+}
+
+/**train_ridge_path - TRAIN RIDGE PATH
+  *Factorizes the normal equations once with ridge_path_alloc if solver calls for it (RIDGE_PATH, or RIDGE_AUTO when the factorization and beta_count path
+  *solves are estimated to be cheaper than beta_count Cholesky solves), otherwise returns NULL so that each beta is solved by Cholesky.
+    *XXt. The [n x n] Gram matrix.
+    *y_Xt. The [outputs x n] cross term.
+    *solver. RIDGE_AUTO, RIDGE_CHOLESKY or RIDGE_PATH.
+    *beta_count. The number of betas to be solved.
+*/
+static ridge_path* train_ridge_path(const gsl_matrix* XXt, const gsl_matrix* y_Xt, const int solver, int beta_count){
+  size_t n = XXt->size1;
+  size_t outputs = y_Xt->size1;
+  bool path_cheaper = train_ridge_path_flops(n) + beta_count * train_ridge_path_solve_flops(n, outputs) < beta_count * train_ridge_cholesky_flops(n, outputs);
+  if(!(solver == RIDGE_PATH || (solver == RIDGE_AUTO && path_cheaper))){
+    return NULL;
+  }
+  PROFILE_BEGIN(PROFILE_SOLVE);
+  ridge_path* path = ridge_path_alloc(XXt, y_Xt);
+  PROFILE_END(PROFILE_SOLVE, train_ridge_path_flops(n), (2 * n + outputs) * n * sizeof(double));
+  return path;
+}
 
-    gsl_matrix_add(beta_id, XXt);
-    gsl_matrix* inverse = gsl_matrix_inverse(beta_id);
-    gsl_matrix* w_candidate = gsl_matrix_multiply(y_Xt, inverse);
+/**train_ridge_solve - TRAIN RIDGE SOLVE
+  *Solves wOut.(XXt + beta I) = y_Xt for one beta, from path if it is not NULL and otherwise by Cholesky. Returns GSL_SUCCESS, or an error if XXt + beta I
+  *is not positive definite (Cholesky only).
+    *XXt. The [n x n] Gram matrix.
+    *y_Xt. The [outputs x n] cross term.
+    *path. NULL, or the factorization from train_ridge_path.
+    *beta. The regularization parameter.
+    *wOut. The [outputs x n] matrix to write the solution to.
+*/
+static int train_ridge_solve(const gsl_matrix* XXt, const gsl_matrix* y_Xt, ridge_path* path, double beta, gsl_matrix* wOut){
+  PROFILE_BEGIN(PROFILE_SOLVE);
+  if(path != NULL){
+    ridge_path_solve(path, beta, wOut);
+    PROFILE_END(PROFILE_SOLVE, train_ridge_path_solve_flops(XXt->size1, y_Xt->size1), y_Xt->size1 * XXt->size1 * sizeof(double));
+    return GSL_SUCCESS;
+  }
+  gsl_matrix* factor = gsl_matrix_alloc(XXt->size1, XXt->size2);
+  gsl_matrix_memcpy(factor, XXt);
+  gsl_matrix_add_diagonal(factor, beta);
+  gsl_matrix_memcpy(wOut, y_Xt);
+  int status = linear_spd_solve_right(factor, wOut);
+  gsl_matrix_free(factor);
+  PROFILE_END(PROFILE_SOLVE, train_ridge_cholesky_flops(XXt->size1, y_Xt->size1), (XXt->size1 + y_Xt->size1) * XXt->size1 * sizeof(double));
+  return status;
+}
 
-    gsl_matrix_free(inverse);
+/**train_ridge_select - TRAIN RIDGE SELECT
+  *Solves the ridge regression normal equations wOut.(XXt + beta I) = y_Xt for every beta and returns the candidate with the lowest NMSE on a harvest, or NULL
+  *if no beta could be solved. It is the responsibility of the caller to free the returned matrix.
+    *XXt. The [n x n] Gram matrix of the training states.
+    *y_Xt. The [outputs x n] training cross term.
+    *beta_h. The harvest to score candidates on.
+    *betas. The beta parameters to try.
+    *beta_count. The number of beta parameters.
+    *solver. RIDGE_AUTO, RIDGE_CHOLESKY or RIDGE_PATH, as train_esn_ridge_regression_solver.
+*/
+gsl_matrix* train_ridge_select(const gsl_matrix* XXt, const gsl_matrix* y_Xt, train_harvest* beta_h, double* betas, int beta_count, const int solver){
+  ridge_path* path = train_ridge_path(XXt, y_Xt, solver, beta_count);
 
-    esn->wOut = w_candidate;
+  gsl_matrix* best_wOut = NULL;
+  double best_score = 99999999999999.9;
 
-    double nmse_new = nmse(esn, dataset, beta_type);
+  for(int i = 0; i < beta_count; i++){
+    double beta = betas[i];
+
+    gsl_matrix* w_candidate = gsl_matrix_alloc(y_Xt->size1, y_Xt->size2);
+    if(train_ridge_solve(XXt, y_Xt, path, beta, w_candidate) != GSL_SUCCESS){
+      printf("XXt + beta I is not positive definite for beta %g, skipping.\n", beta);
+      gsl_matrix_free(w_candidate);
+      continue;
+    }
+
+    double nmse_new = train_harvest_nmse(beta_h, w_candidate);
     if(nmse_new < best_score){
       best_score = nmse_new;
-      gsl_matrix_free(best_wOut);
+      if(best_wOut != NULL){
+        gsl_matrix_free(best_wOut);
+      }
       best_wOut = w_candidate;
     }
     else{
       gsl_matrix_free(w_candidate);
     }
+  }
 
-    gsl_matrix_free(beta_id);
+  if(path != NULL){
+    ridge_path_free(path);
   }
+  return best_wOut;
+}
 
-  esn->wOut = best_wOut;
+/**train_esn_ridge_regression_solver - TRAIN ESN RIDGE REGRESSION SOLVER
+  *Trains an ESN as train_esn_ridge_regression, using a chosen method to solve for each beta's candidate wOut.
+    *solver. RIDGE_AUTO, RIDGE_CHOLESKY or RIDGE_PATH.
+  *The remaining arguments are as train_esn_ridge_regression.
+*/
+void train_esn_ridge_regression_solver(ESN* esn, train_dataset* dataset, const int train_type, const int beta_type, double* betas, int beta_count, const int solver){
+  train_esn_ridge_regression_concurrent(esn, dataset, train_type, beta_type, betas, beta_count, solver, 1);
+}
 
-  gsl_matrix_free(X);
+/**train_esn_ridge_regression_concurrent - TRAIN ESN RIDGE REGRESSION CONCURRENT
+  *Trains an ESN as train_esn_ridge_regression_solver, forming the training table's Gram matrix and harvesting the beta table on up to two threads at once,
+  *each with its own state. The readout is identical to the sequential one, unless the training table has several sequences, when its Gram matrix is also
+  *harvested on threads threads (see train_get_gram_threads).
+    *threads. How many threads to use: 1 runs both passes on the calling thread, and 0 or more than 1 runs them concurrently.
+  *The remaining arguments are as train_esn_ridge_regression_solver.
+*/
+void train_esn_ridge_regression_concurrent(ESN* esn, train_dataset* dataset, const int train_type, const int beta_type, double* betas, int beta_count,
+  const int solver, int threads){
+  int rows = 1 + esn->inputs + esn->nodes;
+
+  train_job jobs[2];
+  train_job_init(&jobs[0], TRAIN_JOB_GRAM, esn, dataset, train_type);
+  jobs[0].threads = threads;
+  jobs[0].XXt = gsl_matrix_alloc(rows, rows);
+  jobs[0].y_Xt = gsl_matrix_alloc(esn->outputs, rows);
+  train_job_init(&jobs[1], beta_count > rows ? TRAIN_JOB_HARVEST_GRAM : TRAIN_JOB_HARVEST, esn, dataset, beta_type);
+  train_run_jobs(jobs, 2, threads);
+  train_job_free(&jobs[0]);
+  train_job_free(&jobs[1]);
+
+  gsl_matrix* XXt = jobs[0].XXt;
+  gsl_matrix* y_Xt = jobs[0].y_Xt;
+  train_harvest* beta_h = jobs[1].harvest;
+
+  gsl_matrix* best_wOut = train_ridge_select(XXt, y_Xt, beta_h, betas, beta_count, solver);
+  if(best_wOut != NULL){
+    gsl_matrix_free(esn->wOut);
+    esn->wOut = best_wOut;
+  }
+
+  train_harvest_free(beta_h);
   gsl_matrix_free(XXt);
-  gsl_matrix_free(y_target);
   gsl_matrix_free(y_Xt);
-  gsl_matrix_free(id);
 
+  for(int i = 0; i < esn->nodes; i++){
+    gsl_matrix_set(esn->state, i, 0, 0.0);
+  }
+}
+
+/**train_esn_ridge_cv - TRAIN ESN RIDGE CV
+  *Trains an ESN by ridge regression, choosing beta by blocked k-fold cross-validation on one table rather than against a separate validate table. The table
+  *is harvested once into per-fold X.Xt, y_target.Xt and y_target.y_target blocks. Each fold's training Gram matrix is then the total less the fold's own, in
+  *O(n^2), which is solved for every beta (factorized once per fold when the solver uses a ridge_path) and scored on the held-out fold from its blocks alone,
+  *as train_harvest_nmse does. The beta with the lowest mean held-out NMSE is finally solved on the whole table, so k-fold selection costs one harvest plus
+  *k + 1 solves. Folds are contiguous in time; if the table has at least folds sequences they are runs of whole sequences, harvested concurrently.
+  *Returns the index of the chosen beta, or -1 (leaving wOut unchanged) if folds is invalid or no beta could be solved.
+    *esn. The esn to train. state is reset to zeros at start and end.
+    *dataset. The dataset to train against.
+    *type. The table of the dataset to cross-validate on. Typically 0 (train).
+    *folds. The number of folds, from 2 to the table's entries.
+    *betas. The beta parameters to try.
+    *beta_count. The number of beta parameters.
+    *solver. RIDGE_AUTO, RIDGE_CHOLESKY or RIDGE_PATH, as train_esn_ridge_regression_solver.
+    *threads. How many threads may harvest folds at once, as train_harvest_tables.
+    *scores. NULL, or a beta_count long array to write each beta's mean held-out NMSE to (NAN for a beta that could not be solved on every fold).
+*/
+int train_esn_ridge_cv(ESN* esn, train_dataset* dataset, const int type, int folds, double* betas, int beta_count, const int solver, int threads,
+  double* scores){
+  train_table* table = get_table(dataset, type);
+  if(folds < 2 || folds > table->entries){
+    printf("train_esn_ridge_cv: cannot split %d entries into %d folds.\n", table->entries, folds);
+    return -1;
+  }
+  int rows = 1 + esn->inputs + esn->nodes;
+  int outputs = esn->outputs;
+
+  /* one harvest into per-fold blocks, whose views double as Gram harvests of each fold */
+  int* bounds = malloc((folds + 1) * sizeof(int));
+  train_partition(table, folds, bounds);
+  train_job* jobs = malloc(folds * sizeof(train_job));
+  train_harvest* held_out = malloc(folds * sizeof(train_harvest));
+  for(int f = 0; f < folds; f++){
+    train_job_init(&jobs[f], TRAIN_JOB_GRAM_RANGE, esn, NULL, 0);
+    jobs[f].table = table;
+    jobs[f].start = bounds[f];
+    jobs[f].end = bounds[f + 1];
+    jobs[f].XXt = gsl_matrix_alloc(rows, rows);
+    jobs[f].y_Xt = gsl_matrix_alloc(outputs, rows);
+
+    gsl_matrix_const_view y_v = gsl_matrix_const_submatrix(table->y_target, bounds[f], 0, bounds[f + 1] - bounds[f], outputs);
+    held_out[f].entries = bounds[f + 1] - bounds[f];
+    held_out[f].outputs = outputs;
+    held_out[f].X = NULL;
+    held_out[f].y_target = NULL;
+    held_out[f].variance = train_target_variance(&y_v.matrix);
+    held_out[f].Y = NULL;
+    held_out[f].XXt = jobs[f].XXt;
+    held_out[f].yXt = jobs[f].y_Xt;
+    held_out[f].yy = gsl_vector_alloc(outputs);
+    for(int o = 0; o < outputs; o++){
+      gsl_vector_const_view y = gsl_matrix_const_column(&y_v.matrix, o);
+      gsl_blas_ddot(&y.vector, &y.vector, gsl_vector_ptr(held_out[f].yy, o));
+    }
+  }
+  if(table->sequences >= folds){
+    train_run_jobs(jobs, folds, threads);
+  }
+  else{
+    /* folds split sequences, so the state runs on from one fold into the next */
+    train_warmup(&jobs[0].view, table, 0);
+    for(int f = 0; f < folds; f++){
+      train_gram_range(&jobs[0].view, table, bounds[f], bounds[f + 1], jobs[f].XXt, jobs[f].y_Xt);
+    }
+  }
+
+  gsl_matrix* XXt = gsl_matrix_calloc(rows, rows);
+  gsl_matrix* y_Xt = gsl_matrix_calloc(outputs, rows);
+  for(int f = 0; f < folds; f++){
+    gsl_matrix_add(XXt, jobs[f].XXt);
+    gsl_matrix_add(y_Xt, jobs[f].y_Xt);
+  }
+
+  double* totals = calloc(beta_count, sizeof(double));
+  gsl_matrix* fold_XXt = gsl_matrix_alloc(rows, rows);
+  gsl_matrix* fold_y_Xt = gsl_matrix_alloc(outputs, rows);
+  gsl_matrix* w_candidate = gsl_matrix_alloc(outputs, rows);
+  for(int f = 0; f < folds; f++){
+    PROFILE_BEGIN(PROFILE_GRAM);
+    gsl_matrix_memcpy(fold_XXt, XXt);
+    gsl_matrix_sub(fold_XXt, jobs[f].XXt);
+    gsl_matrix_memcpy(fold_y_Xt, y_Xt);
+    gsl_matrix_sub(fold_y_Xt, jobs[f].y_Xt);
+    PROFILE_END(PROFILE_GRAM, (double)rows * (rows + outputs), 0);
+
+    ridge_path* path = train_ridge_path(fold_XXt, fold_y_Xt, solver, beta_count);
+    for(int i = 0; i < beta_count; i++){
+      if(train_ridge_solve(fold_XXt, fold_y_Xt, path, betas[i], w_candidate) != GSL_SUCCESS){
+        totals[i] = NAN;
+        continue;
+      }
+      totals[i] += train_harvest_nmse(&held_out[f], w_candidate);
+    }
+    if(path != NULL){
+      ridge_path_free(path);
+    }
+  }
+
+  int best = -1;
+  for(int i = 0; i < beta_count; i++){
+    double score = totals[i] / folds;
+    if(scores != NULL){
+      scores[i] = score;
+    }
+    if(!isnan(score) && (best < 0 || score < totals[best] / folds)){
+      best = i;
+    }
+  }
+  if(best < 0){
+    printf("train_esn_ridge_cv: no beta could be solved on every fold, wOut left unchanged.\n");
+  }
+  else{
+    ridge_path* path = train_ridge_path(XXt, y_Xt, solver, 1);
+    if(train_ridge_solve(XXt, y_Xt, path, betas[best], w_candidate) == GSL_SUCCESS){
+      gsl_matrix_memcpy(esn->wOut, w_candidate);
+    }
+    else{
+      printf("train_esn_ridge_cv: XXt + beta I is not positive definite for beta %g, wOut left unchanged.\n", betas[best]);
+      best = -1;
+    }
+    if(path != NULL){
+      ridge_path_free(path);
+    }
+  }
+
+  for(int f = 0; f < folds; f++){
+    gsl_matrix_free(jobs[f].XXt);
+    gsl_matrix_free(jobs[f].y_Xt);
+    gsl_vector_free(held_out[f].variance);
+    gsl_vector_free(held_out[f].yy);
+    train_job_free(&jobs[f]);
+  }
+  free(jobs);
+  free(held_out);
+  free(bounds);
+  free(totals);
+  gsl_matrix_free(XXt);
+  gsl_matrix_free(y_Xt);
+  gsl_matrix_free(fold_XXt);
+  gsl_matrix_free(fold_y_Xt);
+  gsl_matrix_free(w_candidate);
 
   for(int i = 0; i < esn->nodes; i++){
     gsl_matrix_set(esn->state, i, 0, 0.0);
   }
+  return best;
+}
+
+/**train_harvest_tables - TRAIN HARVEST TABLES
+  *Harvests several tables of a dataset, as train_harvest_table (or train_harvest_table_gram), running the tables concurrently. Each table is run from a
+  *zero state of its own against the ESN's shared, read-only weights, so the harvests are identical to sequential ones and esn->state is not touched.
+  *It is the responsibility of the caller to free each harvest with train_harvest_free.
+    *esn. The ESN to run. It must not be modified until the call returns.
+    *dataset. The dataset to use.
+    *types. The count tables to harvest, e.g. {TRAIN_CONST, VALIDATE_CONST, TEST_CONST}.
+    *count. The number of tables.
+    *gram. Whether to harvest as train_harvest_table_gram, keeping only the Gram statistics.
+    *threads. How many threads to use: 1 runs every table on the calling thread, 0 uses one thread per table.
+    *harvests. A count long array to write the harvests to.
+*/
+void train_harvest_tables(ESN* esn, train_dataset* dataset, const int* types, int count, const bool gram, int threads, train_harvest** harvests){
+  train_job* jobs = malloc(count * sizeof(train_job));
+  for(int i = 0; i < count; i++){
+    train_job_init(&jobs[i], gram ? TRAIN_JOB_HARVEST_GRAM : TRAIN_JOB_HARVEST, esn, dataset, types[i]);
+  }
+  train_run_jobs(jobs, count, threads);
+  for(int i = 0; i < count; i++){
+    harvests[i] = jobs[i].harvest;
+    train_job_free(&jobs[i]);
+  }
+  free(jobs);
+}
+
+/**nmse_tables - NMSE TABLES
+  *Computes the nmse of several tables of a dataset concurrently, as train_harvest_tables, so scoring the train, validate and test tables takes about as
+  *long as the longest of them. The scores are identical to nmse's and esn->state is not touched.
+    *esn. The ESN to score. It must not be modified until the call returns.
+    *dataset. The dataset to use.
+    *types. The count tables to score, e.g. {TRAIN_CONST, VALIDATE_CONST, TEST_CONST}.
+    *count. The number of tables.
+    *threads. How many threads to use: 1 runs every table on the calling thread, 0 uses one thread per table.
+    *scores. A count long array to write the NMSE of each table to.
+*/
+void nmse_tables(ESN* esn, train_dataset* dataset, const int* types, int count, int threads, double* scores){
+  train_job* jobs = malloc(count * sizeof(train_job));
+  for(int i = 0; i < count; i++){
+    train_job_init(&jobs[i], TRAIN_JOB_NMSE, esn, dataset, types[i]);
+  }
+  train_run_jobs(jobs, count, threads);
+  for(int i = 0; i < count; i++){
+    scores[i] = jobs[i].score;
+    train_job_free(&jobs[i]);
+  }
+  free(jobs);
 }
 
 /**train_print - TRAIN PRINT
@@ -172,12 +1150,17 @@ void train_print(ESN* esn, train_dataset* dataset, const int type){
   for(int i = 0; i < table->entries; i++){
     printf("IN:\t");
     for(int j = 0; j < esn->inputs + 1; j++){
-		  printf("%f\t", gsl_matrix_get(table->uN[i], j, 0));
+		  printf("%f\t", gsl_matrix_get(table->uN, i, j));
     }
     printf("Expected:\t");
-		printf("%f\t", table->y_target[i]);
+    for(int j = 0; j < esn->outputs; j++){
+		  printf("%f\t", gsl_matrix_get(table->y_target, i, j));
+    }
     printf("OUT:\t");
-		printf("%f\t\n", gsl_matrix_get(Y, 0, i));
+    for(int j = 0; j < esn->outputs; j++){
+		  printf("%f\t", gsl_matrix_get(Y, j, i));
+    }
+    printf("\n");
   }
 
   gsl_matrix_free(X);
@@ -192,23 +1175,28 @@ void train_print(ESN* esn, train_dataset* dataset, const int type){
     *table. The table to free.
 */
 void train_table_free(train_table* table){
-  for(int i = 0; i < table->entries; i++){
-    gsl_matrix_free(table->uN[i]);
-  }
-  free(table->uN);
+  gsl_matrix_free(table->uN);
   gsl_matrix_free(table->warmup_m);
-  free(table->y_target);
+  gsl_matrix_free(table->y_target);
+  if(table->washout_uN != NULL){
+    gsl_matrix_free(table->washout_uN);
+  }
+  free(table->starts);
+  free(table->washout_starts);
   free(table);
 }
 
 /**train_dataset_free - TRAIN DATASET FREE
-  *Frees a train_dataset by freeing each of its train_tables using train_table_free.
+  *Frees a train_dataset by freeing each of its train_tables using train_table_free, and unmapping it if it was opened with train_dataset_mmap.
     *dataset. The dataset to free.
 */
 void train_dataset_free(train_dataset* dataset){
   train_table_free(dataset->train);
   train_table_free(dataset->validate);
   train_table_free(dataset->test);
+  if(dataset->map != NULL){
+    munmap(dataset->map, dataset->map_size);
+  }
   free(dataset);
 }
 
@@ -229,35 +1217,245 @@ double train_variance(double* vals, int count){
   return sqDiff / (double)count;
 }
 
+/**train_target_variance - TRAIN TARGET VARIANCE
+  *Gets the variance of every column (output) of a target matrix. It is the responsibility of the caller to free the vector.
+    *y_target. The [entries x outputs] targets.
+*/
+gsl_vector* train_target_variance(const gsl_matrix* y_target){
+  size_t entries = y_target->size1;
+  gsl_vector* variance = gsl_vector_alloc(y_target->size2);
+  for(size_t o = 0; o < y_target->size2; o++){
+    gsl_vector_const_view y = gsl_matrix_const_column(y_target, o);
+    double mean = 0.0;
+    for(size_t i = 0; i < entries; i++){
+      mean += gsl_vector_get(&y.vector, i);
+    }
+    mean /= (double)entries;
+    double sqDiff = 0.0;
+    for(size_t i = 0; i < entries; i++){
+      double diff = gsl_vector_get(&y.vector, i) - mean;
+      sqDiff += diff * diff;
+    }
+    gsl_vector_set(variance, o, sqDiff / (double)entries);
+  }
+  return variance;
+}
+
 /**nmse - NMSE
-  *Computes the NMSE = 1/n * sum of 1 to n of (y_target[i] - y_actual[i])^2 / variance(y_target)
+  *Computes the NMSE = 1/n * sum of 1 to n of (y_target[i] - y_actual[i])^2 / variance(y_target) for each output, and returns the mean over outputs.
+  *The table is streamed: each output is read out as the resevoir steps, so X is never formed and memory is O(nodes) whatever the table length. To score
+  *several readouts over one table, harvest it once with train_harvest_table and use train_harvest_nmse instead. state is reset to zeros at start and end.
     *esn. The ESN to compute the NMSE using.
     *dataset. The dataset to compute the NMSE using.
     *type. The table of the dataset to use. Typically 2 (test).
 */
 double nmse(ESN* esn, train_dataset* dataset, const int type){
+  train_table* table = get_table(dataset, type);
+  gsl_matrix_set_zero(esn->state);
+  train_warmup(esn, table, 0);
 
+  gsl_vector* sum = gsl_vector_calloc(esn->outputs);
+  PROFILE_BEGIN(PROFILE_HARVEST);
+  for(int i = 0; i < table->entries; i++){
+    int sequence = train_table_opens(table, i);
+    if(sequence > 0){
+      train_warmup(esn, table, sequence);
+    }
+    gsl_vector_const_view uN_v = gsl_matrix_const_row(table->uN, i);
+    step_esn(esn, &uN_v.vector);
+    for(int o = 0; o < esn->outputs; o++){
+      const double* w = gsl_matrix_const_ptr(esn->wOut, o, 0);
+      double y = 0.0;
+      for(int j = 0; j < esn->inputs + 1; j++){
+        y += w[j] * gsl_vector_get(&uN_v.vector, j);
+      }
+      for(int j = 0; j < esn->nodes; j++){
+        y += w[j + 1 + esn->inputs] * gsl_matrix_get(esn->state, j, 0);
+      }
+      double diff = gsl_matrix_get(table->y_target, i, o) - y;
+      *gsl_vector_ptr(sum, o) += diff * diff;
+    }
+  }
+  PROFILE_END(PROFILE_HARVEST, 0, 0);
+  PROFILE_COUNT(PROFILE_SCORE, 2.0 * esn->outputs * (1 + esn->inputs + esn->nodes) * table->entries, 0);
 
+  gsl_vector* variance = train_target_variance(table->y_target);
+  double score = 0.0;
+  for(int o = 0; o < esn->outputs; o++){
+    score += gsl_vector_get(sum, o) / gsl_vector_get(variance, o) / (double)table->entries;
+  }
+  gsl_vector_free(variance);
+  gsl_vector_free(sum);
+  gsl_matrix_set_zero(esn->state);
+  return score / (double)esn->outputs;
+}
+
+/**train_harvest_table - TRAIN HARVEST TABLE
+  *Runs an ESN over one table of a dataset and keeps its states. state is reset to zeros at start and end.
+  *It is the responsibility of the caller to free the harvest with train_harvest_free.
+    *esn. The ESN to run. Its wOut is not used, so it may be retrained afterwards.
+    *dataset. The dataset to use.
+    *type. The table of the dataset to use.
+*/
+train_harvest* train_harvest_table(ESN* esn, train_dataset* dataset, const int type){
   for(int i = 0; i < esn->nodes; i++){
     gsl_matrix_set(esn->state, i, 0, 0.0);
   }
 
-  double sum = 0.0;
   train_table* table = get_table(dataset, type);
-  int entries = table->entries;
 
-  gsl_matrix* X = train_get_X(esn, table);
+  train_harvest* harvest = malloc(sizeof(train_harvest));
+  harvest->entries = table->entries;
+  harvest->outputs = esn->outputs;
+  harvest->X = train_get_X(esn, table);
+  harvest->y_target = table->y_target;
+  harvest->variance = train_target_variance(table->y_target);
+  harvest->Y = gsl_matrix_alloc(esn->outputs, table->entries);
+  harvest->XXt = NULL;
+  harvest->yXt = NULL;
+  harvest->yy = NULL;
 
-  gsl_matrix* Y = gsl_matrix_multiply(esn->wOut, X);
+  for(int i = 0; i < esn->nodes; i++){
+    gsl_matrix_set(esn->state, i, 0, 0.0);
+  }
+  return harvest;
+}
 
-  double v = train_variance(table->y_target, entries);
+/**train_harvest_from_gram - TRAIN HARVEST FROM GRAM
+  *Wraps Gram statistics harvested elsewhere (train_get_gram, esn_float_get_gram, ...) in a train_harvest, as train_harvest_table_gram produces, computing
+  *the targets' variance and y_target.y_target. It is the responsibility of the caller to free the harvest with train_harvest_free.
+    *XXt. The table's X.Xt, both triangles written. The harvest takes ownership of it.
+    *yXt. The table's y_target.Xt. The harvest takes ownership of it.
+    *y_target. The table's [entries x outputs] targets. Not owned by the harvest.
+*/
+train_harvest* train_harvest_from_gram(gsl_matrix* XXt, gsl_matrix* yXt, const gsl_matrix* y_target){
+  train_harvest* harvest = malloc(sizeof(train_harvest));
+  harvest->entries = y_target->size1;
+  harvest->outputs = y_target->size2;
+  harvest->X = NULL;
+  harvest->y_target = y_target;
+  harvest->variance = train_target_variance(y_target);
+  harvest->Y = NULL;
+  harvest->XXt = XXt;
+  harvest->yXt = yXt;
+  harvest->yy = gsl_vector_alloc(y_target->size2);
+  for(size_t o = 0; o < y_target->size2; o++){
+    gsl_vector_const_view y = gsl_matrix_const_column(y_target, o);
+    gsl_blas_ddot(&y.vector, &y.vector, gsl_vector_ptr(harvest->yy, o));
+  }
+  return harvest;
+}
 
-  for(int i = 0; i < entries; i++){
-    sum += ((table->y_target[i] - gsl_matrix_get(Y, 0, i)) * (table->y_target[i] - gsl_matrix_get(Y, 0, i)) / v);
+/**train_harvest_table_gram - TRAIN HARVEST TABLE GRAM
+  *As train_harvest_table, but streams the table through train_get_gram and keeps only the cached X.Xt, y_target.Xt and y_target.y_target, so X is never
+  *formed. Readouts are then scored in O(outputs x n^2) each.
+    *esn. The ESN to run. Its wOut is not used.
+    *dataset. The dataset to use.
+    *type. The table of the dataset to use.
+*/
+train_harvest* train_harvest_table_gram(ESN* esn, train_dataset* dataset, const int type){
+  for(int i = 0; i < esn->nodes; i++){
+    gsl_matrix_set(esn->state, i, 0, 0.0);
   }
 
-  gsl_matrix_free(X);
-  gsl_matrix_free(Y);
+  train_table* table = get_table(dataset, type);
+  int rows = 1 + esn->inputs + esn->nodes;
+  gsl_matrix* XXt = gsl_matrix_alloc(rows, rows);
+  gsl_matrix* yXt = gsl_matrix_alloc(esn->outputs, rows);
+  train_get_gram(esn, table, XXt, yXt);
+  train_harvest* harvest = train_harvest_from_gram(XXt, yXt, table->y_target);
+
+  for(int i = 0; i < esn->nodes; i++){
+    gsl_matrix_set(esn->state, i, 0, 0.0);
+  }
+  return harvest;
+}
 
-  return sum / (double)entries;
+/**train_harvest_nmse - TRAIN HARVEST NMSE
+  *Computes the NMSE, as nmse, of readout wOut over a harvested table without rerunning the resevoir. Costs a single wOut.X product, or O(outputs x n^2) if
+  *the harvest's Gram statistics have been cached with train_harvest_cache_gram.
+    *harvest. The harvested table.
+    *wOut. The readout to score.
+*/
+double train_harvest_nmse(train_harvest* harvest, const gsl_matrix* wOut){
+  size_t outputs = harvest->outputs;
+  int entries = harvest->entries;
+  double score = 0.0;
+  PROFILE_BEGIN(PROFILE_SCORE);
+
+  if(harvest->XXt != NULL){
+    /* for each output, sum of (y - w.x)^2 = y.y - 2 w.(X.y) + w.(X.Xt).wt */
+    gsl_matrix* w_XXt = gsl_matrix_alloc(outputs, harvest->XXt->size2);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, wOut, harvest->XXt, 0.0, w_XXt);
+    for(size_t o = 0; o < outputs; o++){
+      gsl_vector_const_view w = gsl_matrix_const_row(wOut, o);
+      gsl_vector_const_view yXt = gsl_matrix_const_row(harvest->yXt, o);
+      gsl_vector_const_view wXXt = gsl_matrix_const_row(w_XXt, o);
+      double w_Xy, w_XXt_w;
+      gsl_blas_ddot(&w.vector, &yXt.vector, &w_Xy);
+      gsl_blas_ddot(&w.vector, &wXXt.vector, &w_XXt_w);
+      score += (gsl_vector_get(harvest->yy, o) - (2.0 * w_Xy) + w_XXt_w) / gsl_vector_get(harvest->variance, o) / (double)entries;
+    }
+    gsl_matrix_free(w_XXt);
+    PROFILE_END(PROFILE_SCORE, 2.0 * outputs * harvest->XXt->size2 * (harvest->XXt->size2 + 2), outputs * harvest->XXt->size2 * sizeof(double));
+    return score / (double)outputs;
+  }
+
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, wOut, harvest->X, 0.0, harvest->Y);
+
+  for(size_t o = 0; o < outputs; o++){
+    double sum = 0.0;
+    double v = gsl_vector_get(harvest->variance, o);
+    for(int i = 0; i < entries; i++){
+      double diff = gsl_matrix_get(harvest->y_target, i, o) - gsl_matrix_get(harvest->Y, o, i);
+      sum += (diff * diff / v);
+    }
+    score += sum / (double)entries;
+  }
+
+  PROFILE_END(PROFILE_SCORE, (2.0 * outputs * harvest->X->size1 * entries) + (3.0 * outputs * entries), 0);
+  return score / (double)outputs;
+}
+
+/**train_harvest_cache_gram - TRAIN HARVEST CACHE GRAM
+  *Caches X.Xt, y_target.Xt and y_target.y_target in a harvest (once), after which train_harvest_nmse scores a readout in O(outputs x n^2) independently of
+  *the table length. Worthwhile when scoring more readouts than X has rows.
+    *harvest. The harvested table.
+*/
+void train_harvest_cache_gram(train_harvest* harvest){
+  if(harvest->XXt != NULL){
+    return;
+  }
+  PROFILE_BEGIN(PROFILE_GRAM);
+  size_t n = harvest->X->size1;
+  size_t outputs = harvest->outputs;
+  harvest->XXt = gsl_matrix_alloc(n, n);
+  gsl_blas_dsyrk(CblasLower, CblasNoTrans, 1.0, harvest->X, 0.0, harvest->XXt);
+  train_symmetrize(harvest->XXt);
+  harvest->yXt = gsl_matrix_alloc(outputs, n);
+  gsl_blas_dgemm(CblasTrans, CblasTrans, 1.0, harvest->y_target, harvest->X, 0.0, harvest->yXt);
+  harvest->yy = gsl_vector_alloc(outputs);
+  for(size_t o = 0; o < outputs; o++){
+    gsl_vector_const_view y = gsl_matrix_const_column(harvest->y_target, o);
+    gsl_blas_ddot(&y.vector, &y.vector, gsl_vector_ptr(harvest->yy, o));
+  }
+  PROFILE_END(PROFILE_GRAM, (double)harvest->entries * ((n * (n + 1)) + (2.0 * outputs * (n + 1))), (n + outputs) * n * sizeof(double));
+}
+
+/**train_harvest_free - TRAIN HARVEST FREE
+  *Frees a train_harvest and its matrices. The table it came from is not freed.
+    *harvest. The harvest to free.
+*/
+void train_harvest_free(train_harvest* harvest){
+  if(harvest->X != NULL){
+    gsl_matrix_free(harvest->X);
+    gsl_matrix_free(harvest->Y);
+  }
+  if(harvest->XXt != NULL){
+    gsl_matrix_free(harvest->XXt);
+    gsl_matrix_free(harvest->yXt);
+    gsl_vector_free(harvest->yy);
+  }
+  gsl_vector_free(harvest->variance);
+  free(harvest);
 }
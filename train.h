@@ -1,28 +1,64 @@
 #ifndef TRAIN_H
 #define TRAIN_H
 
+#include <float.h>
 #include <gsl/gsl_matrix.h>
 #include "esn.h"
 #include "matrix_util.h"
+#include "ridge.h"
+#include "linear_solve.h"
 
 static const int TRAIN_CONST = 0;
 static const int VALIDATE_CONST = 1;
 static const int TEST_CONST = 2;
 
+/** Ridge regression solvers for train_esn_ridge_regression_solver.
+  *RIDGE_AUTO. Whichever of RIDGE_PATH and RIDGE_CHOLESKY is estimated to take fewer flops for the number of betas. With few outputs the factorization
+    pays for itself from roughly 27 betas.
+  *RIDGE_CHOLESKY. Cholesky factorizes XXt + beta I separately for every beta and solves against y_Xt, O(n^3 / 3) per beta. No inverse is formed.
+  *RIDGE_PATH. Factorizes XXt once with a ridge_path, O(n^3) once and then O(outputs x n^2) per beta.
+*/
+static const int RIDGE_AUTO = 0;
+static const int RIDGE_CHOLESKY = 1;
+static const int RIDGE_PATH = 2;
+
+/** TRAIN_GRAM_BLOCK
+  *How many timesteps train_get_gram buffers before folding them into X.Xt with a rank-k update.
+*/
+static const int TRAIN_GRAM_BLOCK = 64;
+
+/** TRAIN_GRAM_RUN
+  *Roughly how many timesteps each run of sequences train_get_gram_threads harvests. The runs depend on the table alone, rather than one per thread, so that
+  *the Gram matrix is summed in the same order however many threads harvest it.
+*/
+static const int TRAIN_GRAM_RUN = 2048;
+
 /** STRUCT train_table - TRAIN TABLE
-  *A single table - train, validate or test - for a train_dataset.
+  *A single table - train, validate or test - for a train_dataset. A table is one or more independent sequences (e.g. episodes) stored back to back. Each
+  *sequence is run from a zero state (the first from the caller's state), over the warmup input and then its own washout, before its entries, so no state
+  *leaks from one sequence into the next.
     *entries. How many rows the dataset has.
-    *warmups. How many times an ESN should be run on warmup_m before being run on the dataset.
-    *warmup_m. The warmup input (typically zeros).
-    *uN. The inputs.
-    *y_target. The outputs.
+    *warmups. How many times an ESN should be run on warmup_m before being run on each sequence.
+    *warmup_m. The [(inputs + 1) x 1] warmup input (typically zeros after the bias).
+    *uN. The [entries x (inputs + 1)] inputs. Row i is the input at timestep i, prefaced with the bias, so each timestep is contiguous and the whole table is
+      one buffer.
+    *y_target. The [entries x outputs] targets, laid out as uN. Row i is the target for timestep i, and there must be a column per ESN output.
+    *sequences. How many sequences the entries are split into, 1 for a plain table.
+    *starts. NULL for a single sequence, otherwise the [sequences + 1] entries each sequence starts at: sequence s is entries starts[s] to starts[s + 1] - 1.
+    *washout_uN. NULL, or the [washout rows x (inputs + 1)] washout inputs of every sequence, laid out as uN. They drive the resevoir but have no targets
+      and are never harvested.
+    *washout_starts. NULL when washout_uN is, otherwise the [sequences + 1] rows of washout_uN each sequence's washout starts at.
 */
 typedef struct train_table{
   int entries;
   int warmups;
   gsl_matrix* warmup_m;
-  gsl_matrix** uN;
-  double* y_target;
+  gsl_matrix* uN;
+  gsl_matrix* y_target;
+  int sequences;
+  int* starts;
+  gsl_matrix* washout_uN;
+  int* washout_starts;
 } train_table;
 
 /** STRUCT train_dataset - TRAIN DATASET
@@ -30,20 +66,111 @@ typedef struct train_table{
     *train. The training table.
     *validate. The validation table.
     *test. The testing table.
+    *map. NULL, or the read-only mapping the tables' matrices point into when the dataset was opened with train_dataset_mmap (see train_file.h).
+    *map_size. The length of map in bytes.
 */
 typedef struct train_dataset{
   train_table* train;
   train_table* validate;
   train_table* test;
+  void* map;
+  size_t map_size;
 } train_dataset;
 
 
+/** STRUCT train_harvest - TRAIN HARVEST
+  *The resevoir states of an ESN over one table, harvested once so that any number of candidate readouts can be scored without rerunning the resevoir.
+    *entries. How many rows the table has.
+    *outputs. How many outputs the table has.
+    *X. The [(1 + inputs + nodes) x entries] matrix produced by train_get_X, or NULL for a harvest from train_harvest_table_gram or train_harvest_from_gram.
+    *y_target. The table's [entries x outputs] targets, or NULL for a harvest holding only Gram statistics. Not owned by the harvest.
+    *variance. The variance of each output of y_target.
+    *Y. A [outputs x entries] scratch matrix for wOut.X, or NULL when X is.
+    *XXt. Either NULL or the cached [(1 + inputs + nodes) x (1 + inputs + nodes)] matrix X.Xt, see train_harvest_cache_gram.
+    *yXt. Either NULL or the cached [outputs x (1 + inputs + nodes)] matrix y_target.Xt.
+    *yy. Either NULL or the cached y_target.y_target of each output.
+*/
+typedef struct train_harvest{
+  int entries;
+  int outputs;
+  gsl_matrix* X;
+  const gsl_matrix* y_target;
+  gsl_vector* variance;
+  gsl_matrix* Y;
+  gsl_matrix* XXt;
+  gsl_matrix* yXt;
+  gsl_vector* yy;
+} train_harvest;
+
+/**train_table_alloc - TRAIN TABLE ALLOC
+  *Allocates a train_table with contiguous uN and y_target. The bias column of uN is set to 1 and the warmup input to [1, 0, ...]; the rest is uninitialized.
+    *inputs. The number of inputs, not counting the bias.
+    *outputs. The number of outputs.
+    *entries. The number of timesteps.
+    *warmups. The number of warmup steps.
+*/
+train_table* train_table_alloc(int inputs, int outputs, int entries, int warmups);
+
+/**train_table_alloc_sequences - TRAIN TABLE ALLOC SEQUENCES
+  *Allocates a train_table of several independent sequences, as train_table_alloc, with the sequences' entries stored back to back in uN and y_target and
+  *their washouts back to back in washout_uN (whose bias column is also set to 1). Returns NULL (after printing why) if a sequence is empty.
+    *inputs. The number of inputs, not counting the bias.
+    *outputs. The number of outputs.
+    *sequences. The number of sequences.
+    *lengths. The sequences long array of each sequence's number of entries. Each must be at least 1.
+    *washouts. NULL, or the sequences long array of each sequence's number of washout steps.
+    *warmups. The number of warmup steps run before each sequence.
+*/
+train_table* train_table_alloc_sequences(int inputs, int outputs, int sequences, const int* lengths, const int* washouts, int warmups);
+
+/**train_table_opens - TRAIN TABLE OPENS
+  *Returns the sequence a table's entry starts, if it starts any but the first, or -1. Every loop over a table's entries calls this for each entry and, when
+  *it returns a sequence, zeros the state and runs the warmup input and that sequence's washout before stepping the entry.
+    *table. The table.
+    *entry. The entry.
+*/
+int train_table_opens(const train_table* table, int entry);
+
+/**train_warmup - TRAIN WARMUP
+  *Starts one sequence of a table: zeros the ESN's state (unless it is the first sequence, which continues from the caller's state), then runs the table's
+  *warmup input and the sequence's washout. Loops over a table's entries call this before the first entry and wherever train_table_opens returns a sequence.
+    *esn. The ESN to run.
+    *table. The table whose warmups to run.
+    *sequence. The sequence to start.
+*/
+void train_warmup(ESN* esn, const train_table* table, int sequence);
+
+/**train_warmup_into - TRAIN WARMUP INTO
+  *As train_warmup, on a state held outside the ESN (e.g. one of several stepped against the same weights). *state and *state_next are swapped after each
+  *step, so on return *state holds the warmed up state. The ESN is not modified.
+    *esn. The ESN whose weights to use.
+    *table. The table whose warmups to run.
+    *sequence. The sequence to start.
+    *state, state_next. The state and scratch vectors, of length nodes.
+*/
+void train_warmup_into(const ESN* esn, const train_table* table, int sequence, gsl_vector** state, gsl_vector** state_next);
+
+/**get_table - GET TABLE
+  *Gets one table of a dataset, or NULL for an unknown type.
+    *dataset. The dataset.
+    *type. TRAIN_CONST, VALIDATE_CONST or TEST_CONST.
+*/
+train_table* get_table(train_dataset* dataset, const int type);
+
 double train_mean(double* vals, int count);
 
 double train_variance(double* vals, int count);
 
+/**train_target_variance - TRAIN TARGET VARIANCE
+  *Gets the variance of every column (output) of a target matrix. It is the responsibility of the caller to free the vector.
+    *y_target. The [entries x outputs] targets.
+*/
+gsl_vector* train_target_variance(const gsl_matrix* y_target);
+
 /**nmse - NMSE
-  *Computes the NMSE = 1/n * sum of 1 to n of (y_target[i] - y_actual[i])^2 / variance(y_target)
+  *Computes the NMSE = 1/n * sum of 1 to n of (y_target[i] - y_actual[i])^2 / variance(y_target) for each output, and returns the mean over outputs.
+  *The table is streamed: each output is read out as the resevoir steps, so X is never formed and memory is O(nodes) whatever the table length. To score
+  *several readouts over one table, harvest it once with train_harvest_table and use train_harvest_nmse instead. state is reset to zeros at start and end.
     *esn. The ESN to compute the NMSE using.
     *dataset. The dataset to compute the NMSE using.
     *type. The table of the dataset to use. Typically 2 (test).
@@ -65,15 +192,74 @@ void train_print(ESN* esn, train_dataset* dataset, const int type);
 */
 gsl_matrix* train_get_X(ESN* esn, train_table* table);
 
+/**train_get_Xt - TRAIN GET XT
+  *Gets the transpose of train_get_X's X, one row per timestep. This is the layout least squares solvers take.
+    *esn. The ESN to produce Xt for.
+    *table. The table to produce Xt from.
+*/
+gsl_matrix* train_get_Xt(ESN* esn, train_table* table);
+
+/**train_get_gram - TRAIN GET GRAM
+  *Computes X.Xt and y_target.Xt for a given ESN and table without forming X (see train_get_X). States are buffered TRAIN_GRAM_BLOCK timesteps at a time and
+  *folded in with dsyrk and dgemm, so memory is O((1 + inputs + nodes)^2) whatever the table length.
+    *esn. The ESN to run.
+    *table. The table to run it over.
+    *XXt. The [(1 + inputs + nodes) x (1 + inputs + nodes)] matrix to write X.Xt to. Both triangles are written.
+    *y_Xt. The [outputs x (1 + inputs + nodes)] matrix to write y_target.Xt to.
+*/
+void train_get_gram(ESN* esn, train_table* table, gsl_matrix* XXt, gsl_matrix* y_Xt);
+
+/**train_get_gram_threads - TRAIN GET GRAM THREADS
+  *Computes X.Xt and y_target.Xt as train_get_gram, harvesting a table of several sequences on several threads. The sequences are split into
+  *min(sequences, entries / TRAIN_GRAM_RUN rounded up) contiguous runs, balanced by entries, whatever the thread count. Each thread claims the next run,
+  *harvests it into its own X.Xt and y_target.Xt with a state of its own and adds that to the total once every earlier run has been added, so the result
+  *depends on neither the thread count nor scheduling and differs from train_get_gram's by summation order alone. A table of one run is harvested on the
+  *calling thread. esn->state is not touched.
+    *esn. The ESN to run. It must not be modified until the call returns.
+    *table. The table to run it over.
+    *XXt. The [(1 + inputs + nodes) x (1 + inputs + nodes)] matrix to write X.Xt to. Both triangles are written.
+    *y_Xt. The [outputs x (1 + inputs + nodes)] matrix to write y_target.Xt to.
+    *threads. How many threads to use, 0 for one per core.
+*/
+void train_get_gram_threads(ESN* esn, train_table* table, gsl_matrix* XXt, gsl_matrix* y_Xt, int threads);
+
+/**train_gram_add - TRAIN GRAM ADD
+  *Folds a block of harvested rows into X.Xt and y_target.Xt with a rank-k update (dsyrk, lower triangle only) and a dgemm. Call train_symmetrize on XXt once
+  *every block has been added.
+    *X_rows. The [rows x (1 + inputs + nodes)] block of Xt.
+    *y_rows. The matching [rows x outputs] block of y_target.
+    *XXt. The [(1 + inputs + nodes) x (1 + inputs + nodes)] matrix to add X.Xt to.
+    *y_Xt. The [outputs x (1 + inputs + nodes)] matrix to add y_target.Xt to.
+*/
+void train_gram_add(const gsl_matrix* X_rows, const gsl_matrix* y_rows, gsl_matrix* XXt, gsl_matrix* y_Xt);
+
+/**train_symmetrize - TRAIN SYMMETRIZE
+  *Copies the lower triangle of a square matrix into its upper triangle.
+    *a. The matrix.
+*/
+void train_symmetrize(gsl_matrix* a);
+
 /**train_esn_pinverse - TRAIN ESN PSEUDOINVERSsE
   *Trains an ESN using the pinverse method.
-  * Wout = y_target . pinverse(X). X is collected from the train_get_X method.
+  * Wout = y_target . pinverse(X).
+  *This is solved as the least squares problem Xt.Woutt = y_targett with moore_penrose_lstsq, so pinverse(X) is never formed and memory is O(N x entries).
     *esn. The esn to train. state is reset to zeros at start and end.
     *dataset. The dataset to train against.
     *type. The table of the dataset to use. Typically 0 (train).
 */
 void train_esn_pinverse(ESN* esn, train_dataset* dataset, const int type);
 
+/**train_esn_qr - TRAIN ESN QR
+  *Trains an ESN by least squares, as train_esn_pinverse, but streams the table through a QR factorization so memory is O(N^2) whatever the table length.
+  *Blocks of max(N, TRAIN_GRAM_BLOCK) rows of Xt are stacked under the running triangular factor R and refactorized, with Qt applied to y_target alongside;
+  *at the end R.Woutt = Qt.y_targett is solved by back substitution. Unlike the normal equations this never squares the condition number of X. If R is
+  *numerically singular wOut is left unchanged - use train_esn_pinverse or train_esn_ridge_regression instead.
+    *esn. The esn to train. state is reset to zeros at start and end.
+    *dataset. The dataset to train against.
+    *type. The table of the dataset to use. Typically 0 (train).
+*/
+void train_esn_qr(ESN* esn, train_dataset* dataset, const int type);
+
 
 /**train_esn_ridge_regression - TRAIN ESN RIDGE REGRESSION
   *Trains an ESN using the ridge regression method. This is cheaper than pinverse but not guaranteed to find a global optimum
@@ -81,12 +267,137 @@ void train_esn_pinverse(ESN* esn, train_dataset* dataset, const int type);
     *esn. The esn to train. state is reset to zeros at start and end.
     *dataset. The dataset to train against.
     *train_type. The table of the dataset to use for training. Typically 0 (train).
-    *beta_type. he table of the dataset to use for validating different beta values. Typically 1 (validate).
+    *beta_type. he table of the dataset to use for validating different beta values. Typically 1 (validate). It is harvested once and every beta is
+      scored against the harvest.
     *betas. The set of beta parameters to use. Each is used for training and the one that maximises the beta_type table's NMSE is the final one used.
     *beta_count. The number of beta parameters.
+  *This is a wrapper for train_esn_ridge_regression_solver using RIDGE_AUTO.
 */
 void train_esn_ridge_regression(ESN* esn, train_dataset* dataset, const int train_type, const int beta_type, double* betas, int beta_count);
 
+/**train_ridge_select - TRAIN RIDGE SELECT
+  *Solves the ridge regression normal equations wOut.(XXt + beta I) = y_Xt for every beta and returns the candidate with the lowest NMSE on a harvest, or NULL
+  *if no beta could be solved. It is the responsibility of the caller to free the returned matrix.
+    *XXt. The [n x n] Gram matrix of the training states.
+    *y_Xt. The [outputs x n] training cross term.
+    *beta_h. The harvest to score candidates on.
+    *betas. The beta parameters to try.
+    *beta_count. The number of beta parameters.
+    *solver. RIDGE_AUTO, RIDGE_CHOLESKY or RIDGE_PATH, as train_esn_ridge_regression_solver.
+*/
+gsl_matrix* train_ridge_select(const gsl_matrix* XXt, const gsl_matrix* y_Xt, train_harvest* beta_h, double* betas, int beta_count, const int solver);
+
+/**train_esn_ridge_regression_solver - TRAIN ESN RIDGE REGRESSION SOLVER
+  *Trains an ESN as train_esn_ridge_regression, using a chosen method to solve for each beta's candidate wOut.
+    *solver. RIDGE_AUTO, RIDGE_CHOLESKY or RIDGE_PATH.
+  *The remaining arguments are as train_esn_ridge_regression.
+*/
+void train_esn_ridge_regression_solver(ESN* esn, train_dataset* dataset, const int train_type, const int beta_type, double* betas, int beta_count, const int solver);
+
+/**train_esn_ridge_regression_concurrent - TRAIN ESN RIDGE REGRESSION CONCURRENT
+  *Trains an ESN as train_esn_ridge_regression_solver, forming the training table's Gram matrix and harvesting the beta table on up to two threads at once,
+  *each with its own state. The readout is identical to the sequential one, unless the training table has several sequences, when its Gram matrix is also
+  *harvested on threads threads (see train_get_gram_threads).
+    *threads. How many threads to use: 1 runs both passes on the calling thread, and 0 or more than 1 runs them concurrently.
+  *The remaining arguments are as train_esn_ridge_regression_solver.
+*/
+void train_esn_ridge_regression_concurrent(ESN* esn, train_dataset* dataset, const int train_type, const int beta_type, double* betas, int beta_count,
+  const int solver, int threads);
+
+/**train_esn_ridge_cv - TRAIN ESN RIDGE CV
+  *Trains an ESN by ridge regression, choosing beta by blocked k-fold cross-validation on one table rather than against a separate validate table. The table
+  *is harvested once into per-fold X.Xt, y_target.Xt and y_target.y_target blocks. Each fold's training Gram matrix is then the total less the fold's own, in
+  *O(n^2), which is solved for every beta (factorized once per fold when the solver uses a ridge_path) and scored on the held-out fold from its blocks alone,
+  *as train_harvest_nmse does. The beta with the lowest mean held-out NMSE is finally solved on the whole table, so k-fold selection costs one harvest plus
+  *k + 1 solves. Folds are contiguous in time; if the table has at least folds sequences they are runs of whole sequences, harvested concurrently.
+  *Returns the index of the chosen beta, or -1 (leaving wOut unchanged) if folds is invalid or no beta could be solved.
+    *esn. The esn to train. state is reset to zeros at start and end.
+    *dataset. The dataset to train against.
+    *type. The table of the dataset to cross-validate on. Typically 0 (train).
+    *folds. The number of folds, from 2 to the table's entries.
+    *betas. The beta parameters to try.
+    *beta_count. The number of beta parameters.
+    *solver. RIDGE_AUTO, RIDGE_CHOLESKY or RIDGE_PATH, as train_esn_ridge_regression_solver.
+    *threads. How many threads may harvest folds at once, as train_harvest_tables.
+    *scores. NULL, or a beta_count long array to write each beta's mean held-out NMSE to (NAN for a beta that could not be solved on every fold).
+*/
+int train_esn_ridge_cv(ESN* esn, train_dataset* dataset, const int type, int folds, double* betas, int beta_count, const int solver, int threads,
+  double* scores);
+
+/**train_harvest_tables - TRAIN HARVEST TABLES
+  *Harvests several tables of a dataset, as train_harvest_table (or train_harvest_table_gram), running the tables concurrently. Each table is run from a
+  *zero state of its own against the ESN's shared, read-only weights, so the harvests are identical to sequential ones and esn->state is not touched.
+  *It is the responsibility of the caller to free each harvest with train_harvest_free.
+    *esn. The ESN to run. It must not be modified until the call returns.
+    *dataset. The dataset to use.
+    *types. The count tables to harvest, e.g. {TRAIN_CONST, VALIDATE_CONST, TEST_CONST}.
+    *count. The number of tables.
+    *gram. Whether to harvest as train_harvest_table_gram, keeping only the Gram statistics.
+    *threads. How many threads to use: 1 runs every table on the calling thread, 0 uses one thread per table.
+    *harvests. A count long array to write the harvests to.
+*/
+void train_harvest_tables(ESN* esn, train_dataset* dataset, const int* types, int count, const bool gram, int threads, train_harvest** harvests);
+
+/**nmse_tables - NMSE TABLES
+  *Computes the nmse of several tables of a dataset concurrently, as train_harvest_tables, so scoring the train, validate and test tables takes about as
+  *long as the longest of them. The scores are identical to nmse's and esn->state is not touched.
+    *esn. The ESN to score. It must not be modified until the call returns.
+    *dataset. The dataset to use.
+    *types. The count tables to score, e.g. {TRAIN_CONST, VALIDATE_CONST, TEST_CONST}.
+    *count. The number of tables.
+    *threads. How many threads to use: 1 runs every table on the calling thread, 0 uses one thread per table.
+    *scores. A count long array to write the NMSE of each table to.
+*/
+void nmse_tables(ESN* esn, train_dataset* dataset, const int* types, int count, int threads, double* scores);
+
+/**train_harvest_table - TRAIN HARVEST TABLE
+  *Runs an ESN over one table of a dataset and keeps its states. state is reset to zeros at start and end.
+  *It is the responsibility of the caller to free the harvest with train_harvest_free.
+    *esn. The ESN to run. Its wOut is not used, so it may be retrained afterwards.
+    *dataset. The dataset to use.
+    *type. The table of the dataset to use.
+*/
+train_harvest* train_harvest_table(ESN* esn, train_dataset* dataset, const int type);
+
+/**train_harvest_table_gram - TRAIN HARVEST TABLE GRAM
+  *As train_harvest_table, but streams the table through train_get_gram and keeps only the cached X.Xt, y_target.Xt and y_target.y_target, so X is never
+  *formed. Readouts are then scored in O(outputs x n^2) each.
+    *esn. The ESN to run. Its wOut is not used.
+    *dataset. The dataset to use.
+    *type. The table of the dataset to use.
+*/
+train_harvest* train_harvest_table_gram(ESN* esn, train_dataset* dataset, const int type);
+
+/**train_harvest_from_gram - TRAIN HARVEST FROM GRAM
+  *Wraps Gram statistics harvested elsewhere (train_get_gram, esn_float_get_gram, ...) in a train_harvest, as train_harvest_table_gram produces, computing
+  *the targets' variance and y_target.y_target. It is the responsibility of the caller to free the harvest with train_harvest_free.
+    *XXt. The table's X.Xt, both triangles written. The harvest takes ownership of it.
+    *yXt. The table's y_target.Xt. The harvest takes ownership of it.
+    *y_target. The table's [entries x outputs] targets. Not owned by the harvest.
+*/
+train_harvest* train_harvest_from_gram(gsl_matrix* XXt, gsl_matrix* yXt, const gsl_matrix* y_target);
+
+/**train_harvest_nmse - TRAIN HARVEST NMSE
+  *Computes the NMSE, as nmse, of readout wOut over a harvested table without rerunning the resevoir. Costs a single wOut.X product, or O(outputs x n^2) if
+  *the harvest's Gram statistics have been cached with train_harvest_cache_gram.
+    *harvest. The harvested table.
+    *wOut. The readout to score.
+*/
+double train_harvest_nmse(train_harvest* harvest, const gsl_matrix* wOut);
+
+/**train_harvest_cache_gram - TRAIN HARVEST CACHE GRAM
+  *Caches X.Xt, y_target.Xt and y_target.y_target in a harvest (once), after which train_harvest_nmse scores a readout in O(outputs x n^2) independently of
+  *the table length. Worthwhile when scoring more readouts than X has rows.
+    *harvest. The harvested table.
+*/
+void train_harvest_cache_gram(train_harvest* harvest);
+
+/**train_harvest_free - TRAIN HARVEST FREE
+  *Frees a train_harvest and its matrices. The table it came from is not freed.
+    *harvest. The harvest to free.
+*/
+void train_harvest_free(train_harvest* harvest);
+
 /**train_table_free - TRAIN TABLE FREE
   *Frees a train_table, including warmup_m and uN.
     *table. The table to free.
@@ -94,7 +405,7 @@ void train_esn_ridge_regression(ESN* esn, train_dataset* dataset, const int trai
 void train_table_free(train_table* table);
 
 /**train_dataset_free - TRAIN DATASET FREE
-  *Frees a train_dataset by freeing each of its train_tables using train_table_free.
+  *Frees a train_dataset by freeing each of its train_tables using train_table_free, and unmapping it if it was opened with train_dataset_mmap.
     *dataset. The dataset to free.
 */
 void train_dataset_free(train_dataset* dataset);
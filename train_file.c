@@ -0,0 +1,291 @@
+#include "train_file.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**train_file_align - TRAIN FILE ALIGN
+  * Rounds an offset up to the next multiple of TRAIN_FILE_ALIGN.
+    * offset. The offset to round.
+*/
+static uint64_t train_file_align(uint64_t offset){
+  return (offset + TRAIN_FILE_ALIGN - 1) / TRAIN_FILE_ALIGN * TRAIN_FILE_ALIGN;
+}
+
+/**train_file_pad - TRAIN FILE PAD
+  * Writes zeros from the current position up to an offset. Returns 0 or -1.
+    * file. The file to write to, positioned at *position.
+    * position. The current position in the file, updated.
+    * offset. The offset to pad to.
+*/
+static int train_file_pad(FILE* file, uint64_t* position, uint64_t offset){
+  static const char zeros[64] = {0};
+  while(*position < offset){
+    uint64_t pad = offset - *position;
+    pad = pad < sizeof(zeros) ? pad : sizeof(zeros);
+    if(fwrite(zeros, 1, pad, file) != pad){
+      return -1;
+    }
+    *position += pad;
+  }
+  return 0;
+}
+
+/**train_file_write_starts - TRAIN FILE WRITE STARTS
+  * Writes a [sequences + 1] array of starts as int32_t at an offset, padding as train_file_pad. Returns 0 or -1.
+    * file. The file to write to, positioned at *position.
+    * position. The current position in the file, updated.
+    * offset. Where the array goes.
+    * starts. The starts.
+    * count. The number of starts.
+*/
+static int train_file_write_starts(FILE* file, uint64_t* position, uint64_t offset, const int* starts, uint64_t count){
+  if(train_file_pad(file, position, offset) != 0){
+    return -1;
+  }
+  for(uint64_t i = 0; i < count; i++){
+    int32_t start = starts[i];
+    if(fwrite(&start, sizeof(start), 1, file) != 1){
+      return -1;
+    }
+  }
+  *position += count * sizeof(int32_t);
+  return 0;
+}
+
+/**train_file_write_matrix - TRAIN FILE WRITE MATRIX
+  * Writes a matrix at an offset, padding with zeros from the current position. Rows are written packed whatever the matrix's tda. Returns 0 or -1.
+    * file. The file to write to, positioned at *position.
+    * position. The current position in the file, updated.
+    * offset. Where the matrix goes.
+    * m. The matrix to write.
+*/
+static int train_file_write_matrix(FILE* file, uint64_t* position, uint64_t offset, const gsl_matrix* m){
+  if(train_file_pad(file, position, offset) != 0){
+    return -1;
+  }
+  for(size_t i = 0; i < m->size1; i++){
+    if(fwrite(gsl_matrix_const_ptr(m, i, 0), sizeof(double), m->size2, file) != m->size2){
+      return -1;
+    }
+  }
+  *position += m->size1 * m->size2 * sizeof(double);
+  return 0;
+}
+
+/**train_dataset_save - TRAIN DATASET SAVE
+  * Writes a dataset to a binary file that train_dataset_mmap can open. Returns 0, or -1 (after printing why) if the file could not be written.
+    * dataset. The dataset to save.
+    * path. The file to write.
+*/
+int train_dataset_save(const train_dataset* dataset, const char* path){
+  const train_table* tables[3] = {dataset->train, dataset->validate, dataset->test};
+
+  train_file_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TRAIN_FILE_MAGIC, sizeof(header.magic));
+  header.version = TRAIN_FILE_VERSION;
+  header.endian = TRAIN_FILE_ENDIAN;
+
+  uint64_t offset = sizeof(header);
+  for(int t = 0; t < 3; t++){
+    const train_table* table = tables[t];
+    train_file_table* entry = &header.tables[t];
+    entry->entries = table->entries;
+    entry->warmups = table->warmups;
+    entry->inputs = table->uN->size2 - 1;
+    entry->outputs = table->y_target->size2;
+    entry->warmup_offset = train_file_align(offset);
+    entry->uN_offset = train_file_align(entry->warmup_offset + (entry->inputs + 1) * sizeof(double));
+    entry->y_offset = train_file_align(entry->uN_offset + entry->entries * (entry->inputs + 1) * sizeof(double));
+    offset = entry->y_offset + entry->entries * entry->outputs * sizeof(double);
+    entry->sequences = table->sequences;
+    if(table->starts != NULL){
+      entry->starts_offset = train_file_align(offset);
+      offset = entry->starts_offset + (entry->sequences + 1) * sizeof(int32_t);
+    }
+    if(table->washout_uN != NULL){
+      entry->washout_rows = table->washout_uN->size1;
+      entry->washout_offset = train_file_align(offset);
+      entry->washout_starts_offset = train_file_align(entry->washout_offset + entry->washout_rows * (entry->inputs + 1) * sizeof(double));
+      offset = entry->washout_starts_offset + (entry->sequences + 1) * sizeof(int32_t);
+    }
+  }
+
+  FILE* file = fopen(path, "wb");
+  if(file == NULL){
+    printf("train_dataset_save: could not open %s for writing.\n", path);
+    return -1;
+  }
+
+  int status = fwrite(&header, sizeof(header), 1, file) == 1 ? 0 : -1;
+  uint64_t position = sizeof(header);
+  for(int t = 0; t < 3 && status == 0; t++){
+    status |= train_file_write_matrix(file, &position, header.tables[t].warmup_offset, tables[t]->warmup_m);
+    status |= train_file_write_matrix(file, &position, header.tables[t].uN_offset, tables[t]->uN);
+    status |= train_file_write_matrix(file, &position, header.tables[t].y_offset, tables[t]->y_target);
+    if(tables[t]->starts != NULL){
+      status |= train_file_write_starts(file, &position, header.tables[t].starts_offset, tables[t]->starts, header.tables[t].sequences + 1);
+    }
+    if(tables[t]->washout_uN != NULL){
+      status |= train_file_write_matrix(file, &position, header.tables[t].washout_offset, tables[t]->washout_uN);
+      status |= train_file_write_starts(file, &position, header.tables[t].washout_starts_offset, tables[t]->washout_starts, header.tables[t].sequences + 1);
+    }
+  }
+  if(fclose(file) != 0){
+    status = -1;
+  }
+  if(status != 0){
+    printf("train_dataset_save: could not write %s.\n", path);
+  }
+  return status;
+}
+
+/**train_file_check_block - TRAIN FILE CHECK BLOCK
+  * Checks that a [rows x cols] block is aligned and lies inside the file after the header. The extent is compared by division, so no product of untrusted
+  * counts can wrap. Returns 0 if so.
+    * offset. The offset of the block.
+    * rows, cols. The shape of the block, cols at least 1.
+    * element. The element size in bytes.
+    * size. The length of the file.
+*/
+static int train_file_check_block(uint64_t offset, uint64_t rows, uint64_t cols, uint64_t element, uint64_t size){
+  if(offset % sizeof(double) != 0 || offset < sizeof(train_file_header) || offset > size || rows > (size - offset) / element / cols){
+    return -1;
+  }
+  return 0;
+}
+
+/**train_file_check_table - TRAIN FILE CHECK TABLE
+  * Checks that a table's counts are in range and that its matrices and arrays are aligned and lie inside the file. Returns 0 if so.
+    * entry. The table.
+    * size. The length of the file.
+*/
+static int train_file_check_table(const train_file_table* entry, uint64_t size){
+  if(entry->entries > INT32_MAX || entry->warmups > INT32_MAX || entry->inputs > INT32_MAX || entry->outputs == 0 || entry->outputs > INT32_MAX
+    || entry->sequences == 0 || entry->sequences > entry->entries || entry->washout_rows > INT32_MAX){
+    return -1;
+  }
+  uint64_t columns = entry->inputs + 1;
+  bool split = entry->sequences > 1 || entry->starts_offset != 0;
+  bool washout = entry->washout_rows > 0;
+  if(train_file_check_block(entry->warmup_offset, 1, columns, sizeof(double), size) != 0
+    || train_file_check_block(entry->uN_offset, entry->entries, columns, sizeof(double), size) != 0
+    || train_file_check_block(entry->y_offset, entry->entries, entry->outputs, sizeof(double), size) != 0
+    || (split && train_file_check_block(entry->starts_offset, entry->sequences + 1, 1, sizeof(int32_t), size) != 0)
+    || (washout && train_file_check_block(entry->washout_offset, entry->washout_rows, columns, sizeof(double), size) != 0)
+    || (washout && train_file_check_block(entry->washout_starts_offset, entry->sequences + 1, 1, sizeof(int32_t), size) != 0)){
+    return -1;
+  }
+  return 0;
+}
+
+/**train_file_read_starts - TRAIN FILE READ STARTS
+  * Copies a mapped [sequences + 1] array of int32_t starts, checking that they rise from 0 to last, strictly if strict. Returns NULL if they do not.
+    * data. The mapped array.
+    * sequences. The number of sequences.
+    * last. The value the final start must have.
+    * strict. Whether every sequence must be non-empty.
+*/
+static int* train_file_read_starts(const int32_t* data, uint64_t sequences, int64_t last, bool strict){
+  if(data[0] != 0 || data[sequences] != last){
+    return NULL;
+  }
+  int* starts = malloc((sequences + 1) * sizeof(int));
+  for(uint64_t s = 0; s <= sequences; s++){
+    starts[s] = data[s];
+    if(s > 0 && (starts[s] < starts[s - 1] || (strict && starts[s] == starts[s - 1]))){
+      free(starts);
+      return NULL;
+    }
+  }
+  return starts;
+}
+
+/**train_dataset_mmap - TRAIN DATASET MMAP
+  * Opens a dataset file without reading or copying it: the file is mapped read-only and shared, and every table's matrices point straight into the mapping,
+  * so opening costs O(1) whatever the size (bar copying the sequence starts) and processes mapping the same file share its pages. The tables must not be
+  * written to. Free with train_dataset_free, which unmaps the file. Returns NULL (after printing why) if the file cannot be mapped or is not a valid dataset
+  * file, including one whose tables disagree on their number of inputs or outputs.
+    * path. The file to open.
+*/
+train_dataset* train_dataset_mmap(const char* path){
+  int fd = open(path, O_RDONLY);
+  if(fd < 0){
+    printf("train_dataset_mmap: could not open %s.\n", path);
+    return NULL;
+  }
+  struct stat st;
+  if(fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(train_file_header)){
+    printf("train_dataset_mmap: %s is too short to be a dataset file.\n", path);
+    close(fd);
+    return NULL;
+  }
+  size_t size = st.st_size;
+  void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED){
+    printf("train_dataset_mmap: could not map %s.\n", path);
+    return NULL;
+  }
+
+  const train_file_header* header = map;
+  int valid = memcmp(header->magic, TRAIN_FILE_MAGIC, sizeof(header->magic)) == 0 && header->version == TRAIN_FILE_VERSION
+    && header->endian == TRAIN_FILE_ENDIAN;
+  for(int t = 0; t < 3 && valid; t++){
+    /* every table is run through the same ESN, which indexes rows by its own inputs and outputs */
+    valid = train_file_check_table(&header->tables[t], size) == 0 && header->tables[t].inputs == header->tables[0].inputs
+      && header->tables[t].outputs == header->tables[0].outputs;
+  }
+  if(!valid){
+    printf("train_dataset_mmap: %s is not a valid version %u dataset file for this machine.\n", path, TRAIN_FILE_VERSION);
+    munmap(map, size);
+    return NULL;
+  }
+  /* harvesting reads each table front to back */
+  posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+
+  train_table* tables[3];
+  for(int t = 0; t < 3; t++){
+    const train_file_table* entry = &header->tables[t];
+    train_table* table = malloc(sizeof(train_table));
+    table->entries = entry->entries;
+    table->warmups = entry->warmups;
+    table->warmup_m = gsl_matrix_wrap((double*)((char*)map + entry->warmup_offset), entry->inputs + 1, 1);
+    table->uN = gsl_matrix_wrap((double*)((char*)map + entry->uN_offset), entry->entries, entry->inputs + 1);
+    table->y_target = gsl_matrix_wrap((double*)((char*)map + entry->y_offset), entry->entries, entry->outputs);
+    table->sequences = entry->sequences;
+    table->starts = NULL;
+    table->washout_uN = NULL;
+    table->washout_starts = NULL;
+    if(entry->starts_offset != 0){
+      table->starts = train_file_read_starts((const int32_t*)((char*)map + entry->starts_offset), entry->sequences, entry->entries, true);
+      valid = valid && table->starts != NULL;
+    }
+    if(entry->washout_rows > 0){
+      table->washout_uN = gsl_matrix_wrap((double*)((char*)map + entry->washout_offset), entry->washout_rows, entry->inputs + 1);
+      table->washout_starts = train_file_read_starts((const int32_t*)((char*)map + entry->washout_starts_offset), entry->sequences, entry->washout_rows,
+        false);
+      valid = valid && table->washout_starts != NULL;
+    }
+    valid = valid && (table->starts != NULL || table->sequences == 1);
+    tables[t] = table;
+  }
+  if(!valid){
+    printf("train_dataset_mmap: %s has invalid sequence starts.\n", path);
+    for(int t = 0; t < 3; t++){
+      train_table_free(tables[t]);
+    }
+    munmap(map, size);
+    return NULL;
+  }
+
+  train_dataset* dataset = malloc(sizeof(train_dataset));
+  dataset->train = tables[0];
+  dataset->validate = tables[1];
+  dataset->test = tables[2];
+  dataset->map = map;
+  dataset->map_size = size;
+  return dataset;
+}
@@ -0,0 +1,75 @@
+#ifndef TF_H
+#define TF_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <gsl/gsl_matrix.h>
+#include "train.h"
+
+/** TRAIN_FILE_MAGIC, TRAIN_FILE_VERSION, TRAIN_FILE_ENDIAN, TRAIN_FILE_ALIGN
+  * A dataset file starts with a train_file_header: the magic, the format version, TRAIN_FILE_ENDIAN as written by the saving machine (files are native
+  * endian), and a train_file_table per table. Every matrix follows at a TRAIN_FILE_ALIGN aligned offset, stored exactly as the in memory train_table layout
+  * (row major, rows packed), so a mapped file is used in place. Version 2 added sequences and washouts.
+*/
+static const char TRAIN_FILE_MAGIC[8] = {'E', 'S', 'N', 'D', 'A', 'T', 'A', '\0'};
+static const uint32_t TRAIN_FILE_VERSION = 2;
+static const uint32_t TRAIN_FILE_ENDIAN = 0x01020304;
+static const uint64_t TRAIN_FILE_ALIGN = 64;
+
+/** STRUCT train_file_table - TRAIN FILE TABLE
+  * Where one table lives in a dataset file. Offsets are in bytes from the start of the file.
+    * entries. The number of timesteps.
+    * warmups. The number of warmup steps.
+    * inputs. The number of inputs, not counting the bias.
+    * outputs. The number of outputs.
+    * warmup_offset. The [(inputs + 1) x 1] warmup input.
+    * uN_offset. The [entries x (inputs + 1)] inputs.
+    * y_offset. The [entries x outputs] targets.
+    * sequences. The number of sequences.
+    * washout_rows. The number of rows of washout inputs, 0 if there are none.
+    * starts_offset. The [sequences + 1] int32_t sequence starts, or 0 for a single sequence.
+    * washout_offset. The [washout_rows x (inputs + 1)] washout inputs, or 0.
+    * washout_starts_offset. The [sequences + 1] int32_t washout starts, or 0.
+*/
+typedef struct train_file_table{
+  uint64_t entries;
+  uint64_t warmups;
+  uint64_t inputs;
+  uint64_t outputs;
+  uint64_t warmup_offset;
+  uint64_t uN_offset;
+  uint64_t y_offset;
+  uint64_t sequences;
+  uint64_t washout_rows;
+  uint64_t starts_offset;
+  uint64_t washout_offset;
+  uint64_t washout_starts_offset;
+} train_file_table;
+
+/** STRUCT train_file_header - TRAIN FILE HEADER
+  * The start of a dataset file. tables holds the train, validate and test tables in that order.
+*/
+typedef struct train_file_header{
+  char magic[8];
+  uint32_t version;
+  uint32_t endian;
+  train_file_table tables[3];
+} train_file_header;
+
+/**train_dataset_save - TRAIN DATASET SAVE
+  * Writes a dataset to a binary file that train_dataset_mmap can open. Returns 0, or -1 (after printing why) if the file could not be written.
+    * dataset. The dataset to save.
+    * path. The file to write.
+*/
+int train_dataset_save(const train_dataset* dataset, const char* path);
+
+/**train_dataset_mmap - TRAIN DATASET MMAP
+  * Opens a dataset file without reading or copying it: the file is mapped read-only and shared, and every table's matrices point straight into the mapping,
+  * so opening costs O(1) whatever the size (bar copying the sequence starts) and processes mapping the same file share its pages. The tables must not be
+  * written to. Free with train_dataset_free, which unmaps the file. Returns NULL (after printing why) if the file cannot be mapped or is not a valid dataset
+  * file, including one whose tables disagree on their number of inputs or outputs.
+    * path. The file to open.
+*/
+train_dataset* train_dataset_mmap(const char* path);
+
+#endif